@@ -0,0 +1,267 @@
+#include "AnimationClip.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // the three smaller components of a unit quaternion lie within this
+    constexpr float SMALLEST_THREE_RANGE = 0.70710678f;
+    constexpr float ROTATION_QUANTA = 32767.0f; // 15 bits
+    constexpr float RANGE_QUANTA = 65535.0f;    // 16 bits
+}
+
+glm::mat4 JointPose::toMatrix() const {
+    // the rotation's columns scaled per axis, with the translation as the
+    // last column
+    const glm::mat3 columns = glm::mat3_cast(rotation);
+    return glm::mat4(glm::vec4(columns[0] * scale.x, 0.0f),
+                     glm::vec4(columns[1] * scale.y, 0.0f),
+                     glm::vec4(columns[2] * scale.z, 0.0f),
+                     glm::vec4(translation, 1.0f));
+}
+
+AnimationClip::AnimationClip(const std::string& name, const std::vector<SourceChannel>& channels,
+                             const float sampleRate)
+    : _name(name),
+      _duration(0.0f),
+      _frameCount(1),
+      _frameStride(0)
+{
+    std::vector<const SourceChannel*> rotations, translations, scales;
+    for (const SourceChannel& channel : channels) {
+        if (channel.times.empty() || channel.values.size() < channel.times.size()) continue;
+        _duration = std::max(_duration, channel.times.back());
+        switch (channel.type) {
+            case ROTATION: rotations.push_back(&channel); break;
+            case TRANSLATION: translations.push_back(&channel); break;
+            case SCALE: scales.push_back(&channel); break;
+        }
+    }
+    if (_duration > 0.0f) {
+        _frameCount = std::max(2, static_cast<int>(std::ceil(_duration * sampleRate)) + 1);
+    }
+
+    const size_t numTracks = rotations.size() + translations.size() + scales.size();
+    _frameStride = 3 * numTracks;
+    _samples.resize(_frameStride * _frameCount);
+
+    // the frames are spread evenly so the last lands on the end of the clip
+    std::vector<float> frameTimes(_frameCount);
+    for (int frame = 0; frame < _frameCount; ++frame) {
+        frameTimes[frame] = _frameCount > 1 ? _duration * frame / (_frameCount - 1) : 0.0f;
+    }
+
+    size_t offset = 0;
+    for (const SourceChannel* channel : rotations) {
+        _rotationTracks.push_back({channel->jointIndex, glm::vec3(0.0f), glm::vec3(0.0f)});
+        for (int frame = 0; frame < _frameCount; ++frame) {
+            const glm::vec4 value = _evaluate(*channel, frameTimes[frame]);
+            _encodeRotation(glm::quat(value.w, value.x, value.y, value.z),
+                            &_samples[frame * _frameStride + offset]);
+        }
+        offset += 3;
+    }
+
+    // translations and scales are quantized across the range each channel
+    // covers, so small motions keep their precision
+    std::vector<glm::vec3> resampled(_frameCount);
+    const auto addRangeTracks = [&](const std::vector<const SourceChannel*>& sources, std::vector<Track>& tracks) {
+        for (const SourceChannel* channel : sources) {
+            for (int frame = 0; frame < _frameCount; ++frame) {
+                resampled[frame] = glm::vec3(_evaluate(*channel, frameTimes[frame]));
+            }
+            glm::vec3 minimum = resampled[0];
+            glm::vec3 maximum = resampled[0];
+            for (const glm::vec3& value : resampled) {
+                minimum = glm::min(minimum, value);
+                maximum = glm::max(maximum, value);
+            }
+            const glm::vec3 step = (maximum - minimum) / RANGE_QUANTA;
+            tracks.push_back({channel->jointIndex, minimum, step});
+
+            for (int frame = 0; frame < _frameCount; ++frame) {
+                uint16_t* out = &_samples[frame * _frameStride + offset];
+                for (int axis = 0; axis < 3; ++axis) {
+                    const float quantized = step[axis] > 0.0f
+                        ? std::round((resampled[frame][axis] - minimum[axis]) / step[axis]) : 0.0f;
+                    out[axis] = static_cast<uint16_t>(std::clamp(quantized, 0.0f, RANGE_QUANTA));
+                }
+            }
+            offset += 3;
+        }
+    };
+    addRangeTracks(translations, _translationTracks);
+    addRangeTracks(scales, _scaleTracks);
+}
+
+AnimationClip::AnimationClip(BinaryReader& reader)
+    : _duration(0.0f),
+      _frameCount(1),
+      _frameStride(0)
+{
+    _name = reader.readString();
+    _duration = reader.read<float>();
+    _frameCount = reader.read<int32_t>();
+    _readTracks(reader, _rotationTracks);
+    _readTracks(reader, _translationTracks);
+    _readTracks(reader, _scaleTracks);
+    _frameStride = 3 * (_rotationTracks.size() + _translationTracks.size() + _scaleTracks.size());
+
+    const uint32_t numSamples = reader.read<uint32_t>();
+    if (_frameCount < 1 || numSamples != _frameStride * _frameCount ||
+        !reader.canHold(numSamples, sizeof(uint16_t))) {
+        // leave it a valid clip of nothing, the reader has failed
+        _frameCount = 1;
+        _frameStride = 0;
+        _rotationTracks.clear();
+        _translationTracks.clear();
+        _scaleTracks.clear();
+        reader.fail();
+        return;
+    }
+    _samples.resize(numSamples);
+    reader.readBytes(_samples.data(), numSamples * sizeof(uint16_t));
+}
+
+bool AnimationClip::fitsSkeleton(const size_t numJoints) const {
+    for (const std::vector<Track>* tracks : {&_rotationTracks, &_translationTracks, &_scaleTracks}) {
+        for (const Track& track : *tracks) {
+            if (track.jointIndex < 0 || static_cast<size_t>(track.jointIndex) >= numJoints) return false;
+        }
+    }
+    return true;
+}
+
+void AnimationClip::write(BinaryWriter& writer) const {
+    writer.writeString(_name);
+    writer.write(_duration);
+    writer.write(static_cast<int32_t>(_frameCount));
+    _writeTracks(writer, _rotationTracks);
+    _writeTracks(writer, _translationTracks);
+    _writeTracks(writer, _scaleTracks);
+    writer.write(static_cast<uint32_t>(_samples.size()));
+    writer.writeBytes(_samples.data(), _samples.size() * sizeof(uint16_t));
+}
+
+void AnimationClip::_writeTracks(BinaryWriter& writer, const std::vector<Track>& tracks) {
+    writer.write(static_cast<uint32_t>(tracks.size()));
+    for (const Track& track : tracks) {
+        writer.write(static_cast<int32_t>(track.jointIndex));
+        writer.write(track.minimum);
+        writer.write(track.step);
+    }
+}
+
+void AnimationClip::_readTracks(BinaryReader& reader, std::vector<Track>& tracks) {
+    const uint32_t numTracks = reader.read<uint32_t>();
+    if (!reader.canHold(numTracks, sizeof(int32_t) + 2 * sizeof(glm::vec3))) return;
+    tracks.resize(numTracks);
+    for (Track& track : tracks) {
+        track.jointIndex = reader.read<int32_t>();
+        track.minimum = reader.read<glm::vec3>();
+        track.step = reader.read<glm::vec3>();
+    }
+}
+
+glm::vec4 AnimationClip::_evaluate(const SourceChannel& channel, const float time) {
+    const std::vector<float>& times = channel.times;
+    const std::vector<glm::vec4>& values = channel.values;
+    if (time <= times.front()) return values.front();
+    if (time >= times.back()) return values[times.size() - 1];
+
+    const size_t i = static_cast<size_t>(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+    const float t = (time - times[i]) / (times[i + 1] - times[i]);
+    if (channel.type != ROTATION) return glm::mix(values[i], values[i + 1], t);
+
+    const glm::quat q0(values[i].w, values[i].x, values[i].y, values[i].z);
+    const glm::quat q1(values[i + 1].w, values[i + 1].x, values[i + 1].y, values[i + 1].z);
+    const glm::quat q = glm::slerp(q0, q1, t);
+    return glm::vec4(q.x, q.y, q.z, q.w);
+}
+
+void AnimationClip::_encodeRotation(const glm::quat& rotation, uint16_t* out) {
+    float components[4] = {rotation.x, rotation.y, rotation.z, rotation.w};
+    const float length = std::sqrt(components[0] * components[0] + components[1] * components[1] +
+                                   components[2] * components[2] + components[3] * components[3]);
+    int largest = 0;
+    for (int i = 0; i < 4; ++i) {
+        components[i] = length > 0.0f ? components[i] / length : (i == 3 ? 1.0f : 0.0f);
+        if (std::abs(components[i]) > std::abs(components[largest])) largest = i;
+    }
+    // q and -q are the same rotation, keep the dropped component positive so
+    // it can be rebuilt from the other three
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    uint16_t quantized[3];
+    for (int i = 0, n = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        const float normalized = (sign * components[i] / SMALLEST_THREE_RANGE + 1.0f) * 0.5f;
+        quantized[n++] = static_cast<uint16_t>(std::round(std::clamp(normalized, 0.0f, 1.0f) * ROTATION_QUANTA));
+    }
+    // the largest component's index goes in the top bits of the first two
+    out[0] = static_cast<uint16_t>(quantized[0] | ((largest >> 1) << 15));
+    out[1] = static_cast<uint16_t>(quantized[1] | ((largest & 1) << 15));
+    out[2] = quantized[2];
+}
+
+glm::quat AnimationClip::_decodeRotation(const uint16_t* in) {
+    const int largest = ((in[0] >> 15) << 1) | (in[1] >> 15);
+    float components[4];
+    float sumOfSquares = 0.0f;
+    for (int i = 0, n = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        const float normalized = static_cast<float>(in[n++] & 0x7FFF) / ROTATION_QUANTA;
+        components[i] = (normalized * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+        sumOfSquares += components[i] * components[i];
+    }
+    components[largest] = std::sqrt(std::max(1.0f - sumOfSquares, 0.0f));
+    return glm::quat(components[3], components[0], components[1], components[2]);
+}
+
+void AnimationClip::sample(const float time, JointPose* poses) const {
+    // a clip without frames or tracks leaves the poses as they are
+    if (_samples.empty()) return;
+
+    // the pair of frames around time, a fixed rate makes this arithmetic
+    float frame = 0.0f;
+    if (_frameCount > 1) {
+        frame = std::clamp(time, 0.0f, _duration) / _duration * static_cast<float>(_frameCount - 1);
+    }
+    const int frame0 = std::min(static_cast<int>(frame), std::max(_frameCount - 2, 0));
+    const float t = frame - static_cast<float>(frame0);
+    const uint16_t* a = &_samples[frame0 * _frameStride];
+    const uint16_t* b = _frameCount > 1 ? a + _frameStride : a;
+
+    for (const Track& track : _rotationTracks) {
+        // normalized lerp, the frames are close enough together for it
+        const glm::quat q0 = _decodeRotation(a);
+        const glm::quat q1 = _decodeRotation(b);
+        const float dot = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
+        const float t1 = dot < 0.0f ? -t : t;
+        const float t0 = 1.0f - t;
+        const float x = q0.x * t0 + q1.x * t1;
+        const float y = q0.y * t0 + q1.y * t1;
+        const float z = q0.z * t0 + q1.z * t1;
+        const float w = q0.w * t0 + q1.w * t1;
+        const float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+        poses[track.jointIndex].rotation = glm::quat(w * inverseLength, x * inverseLength,
+                                                     y * inverseLength, z * inverseLength);
+        a += 3;
+        b += 3;
+    }
+
+    // interpolate the quantized values, then decode once
+    const auto decodeRange = [&](const Track& track) {
+        const glm::vec3 q0(a[0], a[1], a[2]);
+        const glm::vec3 q1(b[0], b[1], b[2]);
+        a += 3;
+        b += 3;
+        return track.minimum + (q0 + (q1 - q0) * t) * track.step;
+    };
+    for (const Track& track : _translationTracks) {
+        poses[track.jointIndex].translation = decodeRange(track);
+    }
+    for (const Track& track : _scaleTracks) {
+        poses[track.jointIndex].scale = decodeRange(track);
+    }
+}
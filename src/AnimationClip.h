@@ -0,0 +1,102 @@
+#ifndef ANIMATION_CLIP_H
+#define ANIMATION_CLIP_H
+
+#include "BinaryStream.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// a joint's local transform in the parts animation channels set
+struct JointPose {
+    glm::vec3 translation;
+    glm::quat rotation;
+    glm::vec3 scale;
+
+    // translate * rotate * scale without the matrix multiplies
+    glm::mat4 toMatrix() const;
+};
+
+// A skeletal animation clip resampled at a fixed rate and quantized.
+//
+// Every channel is resampled at import to the same evenly spaced frames, so
+// sampling finds its frame pair with a multiply instead of a search, and all
+// channels of a frame are stored next to each other in one block: the
+// frame's rotations, then its translations, then its scales. A sample only
+// reads the two frames around it. Rotations are stored smallest three, the
+// index of the largest component and the other three in 15 bits each (48
+// bits in all), and translations and scales as 16 bits per component across
+// their channel's range, a quarter of the floats they came from.
+class AnimationClip {
+public:
+    enum ChannelType { TRANSLATION, ROTATION, SCALE };
+
+    // a channel as imported, keyframes interpolated linearly (rotations
+    // spherically)
+    struct SourceChannel {
+        int jointIndex;
+        ChannelType type;
+        std::vector<float> times;
+        // xyz for translations and scales, xyzw for rotations
+        std::vector<glm::vec4> values;
+    };
+
+    static constexpr float DEFAULT_SAMPLE_RATE = 30.0f;
+
+    // resamples the channels at sampleRate frames per second over the length
+    // of the longest one
+    AnimationClip(const std::string& name, const std::vector<SourceChannel>& channels,
+                  float sampleRate = DEFAULT_SAMPLE_RATE);
+
+    // reads a clip back from what write() wrote, the reader fails if it is
+    // not one
+    explicit AnimationClip(BinaryReader& reader);
+
+    // true if every joint the clip animates is one of numJoints, for clips
+    // read back from a file
+    bool fitsSkeleton(size_t numJoints) const;
+
+    // the packed clip as is, no resampling needed to read it back
+    void write(BinaryWriter& writer) const;
+
+    // overwrites the parts of poses (indexed by joint) the clip animates with
+    // their value at time, clamped to the clip
+    void sample(float time, JointPose* poses) const;
+
+    const std::string& getName() const { return _name; }
+    float getDuration() const { return _duration; }
+    int getFrameCount() const { return _frameCount; }
+    // bytes of sample data
+    size_t getSampleBytes() const { return _samples.size() * sizeof(uint16_t); }
+
+private:
+    struct Track {
+        int jointIndex;
+        // translations and scales decode as minimum + quantized * step
+        glm::vec3 minimum;
+        glm::vec3 step;
+    };
+
+    std::string _name;
+    float _duration;
+    int _frameCount;
+    std::vector<Track> _rotationTracks;
+    std::vector<Track> _translationTracks;
+    std::vector<Track> _scaleTracks;
+    // three per track per frame, frame after frame
+    size_t _frameStride;
+    std::vector<uint16_t> _samples;
+
+    static void _writeTracks(BinaryWriter& writer, const std::vector<Track>& tracks);
+    static void _readTracks(BinaryReader& reader, std::vector<Track>& tracks);
+
+    static void _encodeRotation(const glm::quat& rotation, uint16_t* out);
+    static glm::quat _decodeRotation(const uint16_t* in);
+    static glm::vec4 _evaluate(const SourceChannel& channel, float time);
+};
+
+#endif // ANIMATION_CLIP_H
@@ -32,6 +32,19 @@ void CSCI441::ArcballCam::recomputeOrientation() {
 
   mCameraPosition = glm::vec3(camX, camY, camZ);
 
+  // Keep the camera in front of the terrain between it and the look at point
+  if (mObstructionTest) {
+    const GLfloat fraction =
+        mObstructionTest(mCameraLookAtPoint, mCameraPosition);
+    if (fraction < 1.0f) {
+      const GLfloat distance = glm::max(
+          fraction * mCameraRadius - OBSTRUCTION_CLEARANCE, 0.1f);
+      mCameraPosition =
+          mCameraLookAtPoint +
+          glm::normalize(mCameraPosition - mCameraLookAtPoint) * distance;
+    }
+  }
+
   // Re-calculate the camera's direction vector
   mCameraDirection = glm::normalize(mCameraLookAtPoint - mCameraPosition);
 
@@ -3,6 +3,8 @@
 
 #include <CSCI441/Camera.hpp>
 
+#include <functional>
+
 namespace CSCI441 {
 
 class ArcballCam : public Camera {
@@ -14,6 +16,24 @@ public:
 
   void moveForward(GLfloat speed) override;
   void moveBackward(GLfloat speed) override;
+
+  // returns the distance along the segment from the look at point towards
+  // the camera (0 at the look at point, 1 at the camera) at which something
+  // is in the way, 1 or more when nothing is
+  using ObstructionTest =
+      std::function<GLfloat(const glm::vec3 &from, const glm::vec3 &to)>;
+
+  // the camera is pulled in front of whatever the test reports, without
+  // changing its radius, so it springs back once the view clears
+  void setObstructionTest(const ObstructionTest &test) {
+    mObstructionTest = test;
+  }
+
+  // distance kept between the camera and an obstruction
+  static constexpr GLfloat OBSTRUCTION_CLEARANCE = 0.3f;
+
+private:
+  ObstructionTest mObstructionTest;
 };
 
 } // namespace CSCI441
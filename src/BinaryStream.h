@@ -0,0 +1,100 @@
+#ifndef BINARY_STREAM_H
+#define BINARY_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Appends plain values to a byte buffer, in memory order. Meant for files the
+// same build reads back, so there is no byte swapping.
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::vector<unsigned char>& bytes) : _bytes(bytes) {}
+
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        const unsigned char* first = static_cast<const unsigned char*>(data);
+        _bytes.insert(_bytes.end(), first, first + size);
+    }
+
+    // length first, then the characters
+    void writeString(const std::string& value) {
+        write(static_cast<uint32_t>(value.size()));
+        writeBytes(value.data(), value.size());
+    }
+
+private:
+    std::vector<unsigned char>& _bytes;
+};
+
+// Reads back what a BinaryWriter wrote. Reading past the end yields zeros and
+// leaves the reader failed rather than reading out of bounds, so a truncated
+// or corrupt file only needs checking once at the end.
+class BinaryReader {
+public:
+    BinaryReader(const unsigned char* data, size_t size)
+        : _cursor(data), _end(data + size), _ok(true) {}
+
+    template<typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read");
+        T value{};
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    void readBytes(void* out, size_t size) {
+        const unsigned char* bytes = skip(size);
+        if (bytes) {
+            memcpy(out, bytes, size);
+        } else {
+            memset(out, 0, size);
+        }
+    }
+
+    std::string readString() {
+        const uint32_t length = read<uint32_t>();
+        const unsigned char* characters = skip(length);
+        return characters ? std::string(reinterpret_cast<const char*>(characters), length) : std::string();
+    }
+
+    // the next size bytes in place, nullptr if fewer are left
+    const unsigned char* skip(size_t size) {
+        if (!_ok || size > remaining()) {
+            _ok = false;
+            return nullptr;
+        }
+        const unsigned char* bytes = _cursor;
+        _cursor += size;
+        return bytes;
+    }
+
+    // true if count records of at least recordSize bytes could still follow,
+    // checked before sizing anything by a count read from the data
+    bool canHold(size_t count, size_t recordSize) {
+        if (_ok && count <= remaining() / (recordSize > 0 ? recordSize : 1)) return true;
+        _ok = false;
+        return false;
+    }
+
+    // for data that reads fine but makes no sense
+    void fail() { _ok = false; }
+
+    size_t remaining() const { return static_cast<size_t>(_end - _cursor); }
+    bool ok() const { return _ok; }
+
+private:
+    const unsigned char* _cursor;
+    const unsigned char* _end;
+    bool _ok;
+};
+
+#endif // BINARY_STREAM_H
@@ -0,0 +1,223 @@
+#include "CDLODTerrain.h"
+#include "GLResources.h"
+#include "Heightmap.h"
+#include "StreamingBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    // range of the finest level in leaf node sizes, each coarser level doubles
+    // it. Three keeps every level's band wider than a node's diagonal, so
+    // neighbouring nodes never differ by more than one level
+    constexpr float LOD_RANGE_SCALE = 3.0f;
+    // fraction of a level's band after which its vertices start morphing
+    constexpr float MORPH_START_RATIO = 0.66f;
+}
+
+CDLODTerrain::CDLODTerrain(const Heightmap& heightmap)
+    : _heightmap(heightmap),
+      _vao(0),
+      _vbo(0),
+      _ibo(0),
+      _numIndices(0),
+      _heightmapTexture(0),
+      _frustum(glm::mat4(1.0f)),
+      _cameraPos(0.0f)
+{
+    const float halfSize = _heightmap.getHalfSize();
+    _origin = glm::vec2(-halfSize);
+    _mapEnd = glm::vec2(halfSize);
+
+    // one leaf grid quad per heightmap sample, then as many levels as it takes
+    // for the root to cover the map
+    const glm::vec2 spacing = _heightmap.getSpacing();
+    _leafNodeSize = NODE_RESOLUTION * std::min(spacing.x, spacing.y);
+    _lodCount = 1;
+    while (_lodCount < MAX_LODS && _nodeSize(_lodCount - 1) < 2.0f * halfSize) {
+        ++_lodCount;
+    }
+    // too many levels for the map, coarsen the leaves instead
+    if (_nodeSize(_lodCount - 1) < 2.0f * halfSize) {
+        _leafNodeSize = 2.0f * halfSize / static_cast<float>(1 << (_lodCount - 1));
+    }
+
+    float previousRange = 0.0f;
+    for (int lod = 0; lod < _lodCount; ++lod) {
+        _ranges[lod] = LOD_RANGE_SCALE * _leafNodeSize * static_cast<float>(1 << lod);
+        _morphRanges[lod] = glm::vec2(previousRange + (_ranges[lod] - previousRange) * MORPH_START_RATIO,
+                                      _ranges[lod]);
+        previousRange = _ranges[lod];
+    }
+
+    _computeNodeBounds();
+    _createGridMesh();
+
+    _heightmapTexture = GLResources::createTexture2D(
+        _heightmap.getWidth(), _heightmap.getDepth(), GL_R32F, GL_RED, GL_FLOAT,
+        _heightmap.getSamples(), GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+    fprintf(stdout, "[INFO]: CDLOD terrain with %d levels, leaf nodes %.1f units across\n",
+            _lodCount, _leafNodeSize);
+}
+
+CDLODTerrain::~CDLODTerrain() {
+    glDeleteVertexArrays(1, &_vao);
+    glDeleteBuffers(1, &_vbo);
+    glDeleteBuffers(1, &_ibo);
+    glDeleteTextures(1, &_heightmapTexture);
+}
+
+void CDLODTerrain::_computeNodeBounds() {
+    // leaves scan the heightmap, every coarser node merges its four children
+    const int leavesPerSide = _nodesPerSide(0);
+    _nodeBounds[0].resize(static_cast<size_t>(leavesPerSide) * leavesPerSide);
+    for (int row = 0; row < leavesPerSide; ++row) {
+        for (int col = 0; col < leavesPerSide; ++col) {
+            const float x = _origin.x + col * _leafNodeSize;
+            const float z = _origin.y + row * _leafNodeSize;
+            glm::vec2& bounds = _nodeBounds[0][row * leavesPerSide + col];
+            _heightmap.minMax(x, z, x + _leafNodeSize, z + _leafNodeSize, bounds.x, bounds.y);
+        }
+    }
+
+    for (int lod = 1; lod < _lodCount; ++lod) {
+        const int nodesPerSide = _nodesPerSide(lod);
+        const int childrenPerSide = _nodesPerSide(lod - 1);
+        _nodeBounds[lod].resize(static_cast<size_t>(nodesPerSide) * nodesPerSide);
+        for (int row = 0; row < nodesPerSide; ++row) {
+            for (int col = 0; col < nodesPerSide; ++col) {
+                const glm::vec2* children = &_nodeBounds[lod - 1][2 * row * childrenPerSide + 2 * col];
+                const glm::vec2 a = children[0], b = children[1];
+                const glm::vec2 c = children[childrenPerSide], d = children[childrenPerSide + 1];
+                _nodeBounds[lod][row * nodesPerSide + col] =
+                    glm::vec2(std::min(std::min(a.x, b.x), std::min(c.x, d.x)),
+                              std::max(std::max(a.y, b.y), std::max(c.y, d.y)));
+            }
+        }
+    }
+}
+
+void CDLODTerrain::_createGridMesh() {
+    // a unit square of QUADRANT_RESOLUTION^2 quads, scaled and placed per
+    // instance in the vertex shader
+    constexpr int verticesPerSide = QUADRANT_RESOLUTION + 1;
+    std::vector<glm::vec2> vertices;
+    vertices.reserve(verticesPerSide * verticesPerSide);
+    for (int row = 0; row < verticesPerSide; ++row) {
+        for (int col = 0; col < verticesPerSide; ++col) {
+            vertices.emplace_back(static_cast<float>(col) / QUADRANT_RESOLUTION,
+                                  static_cast<float>(row) / QUADRANT_RESOLUTION);
+        }
+    }
+
+    std::vector<GLushort> indices;
+    indices.reserve(6 * QUADRANT_RESOLUTION * QUADRANT_RESOLUTION);
+    for (int row = 0; row < QUADRANT_RESOLUTION; ++row) {
+        for (int col = 0; col < QUADRANT_RESOLUTION; ++col) {
+            const GLushort corner = row * verticesPerSide + col;
+            // counter clockwise seen from above
+            indices.push_back(corner);
+            indices.push_back(corner + verticesPerSide);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + verticesPerSide);
+            indices.push_back(corner + verticesPerSide + 1);
+        }
+    }
+    _numIndices = static_cast<GLsizei>(indices.size());
+
+    _vao = GLResources::createVertexArray();
+    _vbo = GLResources::createStaticBuffer(vertices.size() * sizeof(glm::vec2), vertices.data());
+    _ibo = GLResources::createStaticBuffer(indices.size() * sizeof(GLushort), indices.data());
+    GLResources::setVertexAttribute(_vao, 0, _vbo, 2, GL_FLOAT, sizeof(glm::vec2), 0);
+    GLResources::setElementBuffer(_vao, _ibo);
+
+    // the instance attribute (location 1) advances once per quadrant, its
+    // buffer and offset change every draw and are set in draw()
+    glBindVertexArray(_vao);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+}
+
+void CDLODTerrain::draw(const glm::mat4& viewProjectionMtx, const glm::vec3& cameraPos,
+                        StreamingBuffer& instanceBuffer) {
+    _frustum = Frustum(viewProjectionMtx);
+    _cameraPos = cameraPos;
+
+    _instances.clear();
+    if (!_selectNode(_lodCount - 1, 0, 0)) {
+        // beyond even the coarsest range, the root is all there is
+        const float halfRoot = 0.5f * _nodeSize(_lodCount - 1);
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            _addQuadrant(_origin.x + (quadrant & 1) * halfRoot, _origin.y + (quadrant >> 1) * halfRoot,
+                         halfRoot, _lodCount - 1);
+        }
+    }
+
+    const GLsizei numInstances = static_cast<GLsizei>(
+        std::min(_instances.size(), static_cast<size_t>(MAX_INSTANCES)));
+    if (numInstances == 0) return;
+
+    const GLintptr offset = instanceBuffer.write(_instances.data(), numInstances * sizeof(QuadrantInstance));
+    if (offset < 0) return;
+
+    glBindVertexArray(_vao);
+
+    // point the instance attribute at this frame's slice of the stream
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.getHandle());
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(QuadrantInstance), (void*)offset);
+
+    glDrawElementsInstanced(GL_TRIANGLES, _numIndices, GL_UNSIGNED_SHORT, nullptr, numInstances);
+
+    glBindVertexArray(0);
+}
+
+bool CDLODTerrain::_selectNode(int lod, int col, int row) {
+    const float size = _nodeSize(lod);
+    const float x = _origin.x + col * size;
+    const float z = _origin.y + row * size;
+
+    // nodes hanging completely off the far edges of the map
+    if (x >= _mapEnd.x || z >= _mapEnd.y) return true;
+
+    const glm::vec2 bounds = _nodeBounds[lod][row * _nodesPerSide(lod) + col];
+    const glm::vec3 boxMin(x, bounds.x, z);
+    const glm::vec3 boxMax(std::min(x + size, _mapEnd.x), bounds.y, std::min(z + size, _mapEnd.y));
+
+    if (!_sphereIntersects(boxMin, boxMax, _ranges[lod])) return false;
+
+    // out of view, nothing to draw but nothing left to cover either
+    if (!_frustum.intersects(boxMin, boxMax)) return true;
+
+    const float halfSize = 0.5f * size;
+    if (lod == 0 || !_sphereIntersects(boxMin, boxMax, _ranges[lod - 1])) {
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            _addQuadrant(x + (quadrant & 1) * halfSize, z + (quadrant >> 1) * halfSize, halfSize, lod);
+        }
+        return true;
+    }
+
+    // children too far for the finer level are drawn as this node's quarter
+    for (int quadrant = 0; quadrant < 4; ++quadrant) {
+        const int childCol = 2 * col + (quadrant & 1);
+        const int childRow = 2 * row + (quadrant >> 1);
+        if (!_selectNode(lod - 1, childCol, childRow)) {
+            _addQuadrant(x + (quadrant & 1) * halfSize, z + (quadrant >> 1) * halfSize, halfSize, lod);
+        }
+    }
+    return true;
+}
+
+void CDLODTerrain::_addQuadrant(float x, float z, float size, int lod) {
+    if (x >= _mapEnd.x || z >= _mapEnd.y) return;
+    _instances.push_back({glm::vec2(x, z), size, static_cast<float>(lod)});
+}
+
+bool CDLODTerrain::_sphereIntersects(const glm::vec3& boxMin, const glm::vec3& boxMax, float radius) const {
+    const glm::vec3 closest = glm::clamp(_cameraPos, boxMin, boxMax);
+    const glm::vec3 offset = closest - _cameraPos;
+    return glm::dot(offset, offset) <= radius * radius;
+}
@@ -0,0 +1,110 @@
+#ifndef CDLOD_TERRAIN_H
+#define CDLOD_TERRAIN_H
+
+#include "Frustum.h"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class Heightmap;
+class StreamingBuffer;
+
+// Continuous distance-dependent level of detail (CDLOD) rendering of a
+// heightmap.
+//
+// The map is covered by a quadtree whose leaves hold NODE_RESOLUTION grid
+// quads per side. Every frame the tree is walked from the root, keeping the
+// coarsest node that lies beyond the next finer level's distance range and
+// dropping nodes outside the view frustum. All selected nodes are drawn with
+// one instanced draw of a single grid mesh covering a quarter of a node; a
+// node is four instances, and a node only partially refined draws its
+// unrefined quarters at its own level. cdlod.v.glsl displaces the grid with
+// the heightmap texture and, towards the far end of each level's range,
+// slides every other vertex onto its neighbours so the mesh has become the
+// next coarser level by the time the selection switches. Neighbouring levels
+// therefore meet without cracks and switching never pops.
+class CDLODTerrain {
+public:
+    // the heightmap has to outlive the terrain
+    explicit CDLODTerrain(const Heightmap& heightmap);
+    ~CDLODTerrain();
+
+    CDLODTerrain(const CDLODTerrain&) = delete;
+    CDLODTerrain& operator=(const CDLODTerrain&) = delete;
+
+    // select the nodes for this view and draw them, the shader program and
+    // heightmap texture must already be bound. The per-instance data is
+    // streamed through instanceBuffer
+    void draw(const glm::mat4& viewProjectionMtx, const glm::vec3& cameraPos,
+              StreamingBuffer& instanceBuffer);
+
+    // R32F copy of the heightmap for cdlod.v.glsl
+    GLuint getHeightmapTexture() const { return _heightmapTexture; }
+
+    int getLODCount() const { return _lodCount; }
+    // per level (start, end) distances over which vertices morph to the next
+    // coarser level, for the morphRanges uniform
+    const glm::vec2* getMorphRanges() const { return _morphRanges; }
+
+    // quarter nodes drawn by the last draw()
+    GLsizei getSelectedQuadrantCount() const { return static_cast<GLsizei>(_instances.size()); }
+
+    // grid quads along the side of a node, and of the instanced quarter mesh
+    static constexpr int NODE_RESOLUTION = 32;
+    static constexpr int QUADRANT_RESOLUTION = NODE_RESOLUTION / 2;
+    static constexpr int MAX_LODS = 10;
+    // most quarter nodes sent in one draw call
+    static constexpr int MAX_INSTANCES = 4096;
+
+    // per-instance data read by cdlod.v.glsl
+    struct QuadrantInstance {
+        glm::vec2 origin; // minimum x and z corner
+        float size;
+        float lod;
+    };
+
+private:
+    const Heightmap& _heightmap;
+
+    // the root covers _rootSize starting at _origin, which can reach past the
+    // far edges of the map
+    glm::vec2 _origin;
+    glm::vec2 _mapEnd;
+    float _leafNodeSize;
+    int _lodCount;
+
+    // distance within which a level may be selected, finest first
+    float _ranges[MAX_LODS];
+    glm::vec2 _morphRanges[MAX_LODS];
+
+    // lowest and highest height under every node, indexed by level and then
+    // row major by node
+    std::vector<glm::vec2> _nodeBounds[MAX_LODS];
+
+    GLuint _vao;
+    GLuint _vbo;
+    GLuint _ibo;
+    GLsizei _numIndices;
+    GLuint _heightmapTexture;
+
+    // per draw selection state
+    std::vector<QuadrantInstance> _instances;
+    Frustum _frustum;
+    glm::vec3 _cameraPos;
+
+    void _computeNodeBounds();
+    void _createGridMesh();
+
+    float _nodeSize(int lod) const { return _leafNodeSize * static_cast<float>(1 << lod); }
+    int _nodesPerSide(int lod) const { return 1 << (_lodCount - 1 - lod); }
+
+    // returns false if the node is beyond its level's range, so the caller
+    // has to cover it at its own level
+    bool _selectNode(int lod, int col, int row);
+    void _addQuadrant(float x, float z, float size, int lod);
+    bool _sphereIntersects(const glm::vec3& boxMin, const glm::vec3& boxMax, float radius) const;
+};
+
+#endif // CDLOD_TERRAIN_H
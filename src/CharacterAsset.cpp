@@ -0,0 +1,267 @@
+#include "CharacterAsset.h"
+#include "CharacterCooker.h"
+#include "GLResources.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+
+std::shared_ptr<const CharacterAsset> CharacterAsset::load(const std::string& filepath) {
+    // an asset stays cached only while a character holds it
+    static std::map<std::string, std::weak_ptr<const CharacterAsset>> cache;
+
+    std::weak_ptr<const CharacterAsset>& entry = cache[filepath];
+    if (std::shared_ptr<const CharacterAsset> asset = entry.lock()) {
+        return asset;
+    }
+
+    std::shared_ptr<CharacterAsset> asset(new CharacterAsset());
+    if (!asset->_loadFromFile(filepath)) {
+        return nullptr;
+    }
+    entry = asset;
+    return asset;
+}
+
+CharacterAsset::CharacterAsset() {
+}
+
+CharacterAsset::~CharacterAsset() {
+    for (auto& prim : _primitives) {
+        glDeleteVertexArrays(1, &prim.vao);
+        glDeleteBuffers(1, &prim.vbo);
+        glDeleteBuffers(1, &prim.ibo);
+    }
+
+    // clearnup textures, materials may share them
+    if (!_textures.empty()) {
+        glDeleteTextures(static_cast<GLsizei>(_textures.size()), _textures.data());
+    }
+}
+
+int CharacterAsset::findAnimation(const std::string& animationName) const {
+    for (size_t i = 0; i < _animations.size(); ++i) {
+        if (_animations[i].getName() == animationName) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool CharacterAsset::_loadFromFile(const std::string& filepath) {
+    const auto start = std::chrono::steady_clock::now();
+
+    CharacterCooker::SourceStamp stamp;
+    if (!CharacterCooker::stampSource(filepath, stamp)) {
+        std::cerr << "Character file not found: " << filepath << std::endl;
+        return false;
+    }
+
+    // cooked on an earlier run and still matching the source, the mapping
+    // is let go before cooking so the file can be replaced
+    const std::string cookedPath = CharacterCooker::cookedPathFor(filepath);
+    bool loaded = false;
+    {
+        const MappedFile cooked(cookedPath);
+        loaded = cooked.isOpen() && _loadCooked(cooked.getData(), cooked.getSize(), stamp);
+    }
+
+    if (!loaded) {
+        std::vector<unsigned char> blob;
+        if (!CharacterCooker::cook(filepath, stamp, blob)) {
+            return false;
+        }
+        // without a saved copy this run still goes on, and the next one
+        // tries again
+        CharacterCooker::save(cookedPath, blob);
+        if (!_loadCooked(blob.data(), blob.size(), stamp)) {
+            std::cerr << "Failed to read back the cooked " << filepath << std::endl;
+            return false;
+        }
+    }
+
+    const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Successfully loaded character from " << (loaded ? cookedPath : filepath)
+              << " in " << milliseconds << " ms" << std::endl;
+    std::cout << "  Primitives: " << _primitives.size() << std::endl;
+    std::cout << "  Joints: " << _joints.size() << std::endl;
+    std::cout << "  Animations: " << _animations.size() << std::endl;
+    std::cout << "  Materials: " << _materials.size() << std::endl;
+
+    return true;
+}
+
+bool CharacterAsset::_loadCooked(const unsigned char* data, size_t size, const CharacterCooker::SourceStamp& stamp) {
+    BinaryReader reader(data, size);
+    if (!CharacterCooker::readHeader(reader, stamp)) {
+        return false;
+    }
+
+    // everything is read and checked before anything is created, the pixels,
+    // vertices and indices are uploaded from where they lie in the data
+    struct TextureRecord {
+        int32_t width, height;
+        int32_t minFilter, magFilter, wrapS, wrapT;
+        const unsigned char* pixels;
+    };
+    std::vector<TextureRecord> textures;
+    const uint32_t numTextures = reader.read<uint32_t>();
+    if (reader.canHold(numTextures, 6 * sizeof(int32_t))) {
+        textures.resize(numTextures);
+    }
+    for (TextureRecord& texture : textures) {
+        texture.width = reader.read<int32_t>();
+        texture.height = reader.read<int32_t>();
+        texture.minFilter = reader.read<int32_t>();
+        texture.magFilter = reader.read<int32_t>();
+        texture.wrapS = reader.read<int32_t>();
+        texture.wrapT = reader.read<int32_t>();
+        if (texture.width <= 0 || texture.height <= 0 ||
+            !reader.canHold(texture.height, static_cast<size_t>(texture.width) * 4)) {
+            reader.fail();
+            break;
+        }
+        texture.pixels = reader.skip(static_cast<size_t>(texture.width) * texture.height * 4);
+    }
+
+    std::vector<Material> materials;
+    std::vector<int32_t> materialTextures;
+    const uint32_t numMaterials = reader.read<uint32_t>();
+    if (reader.canHold(numMaterials, 2 * sizeof(glm::vec3) + sizeof(float) + sizeof(int32_t))) {
+        materials.resize(numMaterials);
+        materialTextures.resize(numMaterials);
+    }
+    for (size_t i = 0; i < materials.size(); ++i) {
+        materials[i].diffuse = reader.read<glm::vec3>();
+        materials[i].specular = reader.read<glm::vec3>();
+        materials[i].shininess = reader.read<float>();
+        materialTextures[i] = reader.read<int32_t>();
+        if (materialTextures[i] >= (int32_t)textures.size()) reader.fail();
+    }
+
+    std::vector<Joint> joints;
+    std::vector<JointPose> restPose;
+    const uint32_t numJoints = reader.read<uint32_t>();
+    if (reader.canHold(numJoints, sizeof(uint32_t) + sizeof(int32_t) + 2 * sizeof(glm::mat4))) {
+        joints.resize(numJoints);
+        restPose.resize(numJoints);
+    }
+    for (size_t i = 0; i < joints.size(); ++i) {
+        joints[i].name = reader.readString();
+        joints[i].parentIndex = reader.read<int32_t>();
+        joints[i].inverseBindMatrix = reader.read<glm::mat4>();
+        joints[i].restTransform = reader.read<glm::mat4>();
+        restPose[i].translation = reader.read<glm::vec3>();
+        const glm::vec4 rotation = reader.read<glm::vec4>();
+        restPose[i].rotation = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+        restPose[i].scale = reader.read<glm::vec3>();
+        // parents come first
+        if (joints[i].parentIndex >= (int)i) reader.fail();
+    }
+
+    struct PrimitiveRecord {
+        int32_t materialIndex;
+        bool hasTexCoords, hasSkin;
+        uint32_t vertexCount;
+        GLenum indexType;
+        uint32_t indexCount;
+        const unsigned char* vertices;
+        const unsigned char* indices;
+    };
+    std::vector<PrimitiveRecord> primitives;
+    const uint32_t numPrimitives = reader.read<uint32_t>();
+    if (reader.canHold(numPrimitives, sizeof(int32_t) + 2 * sizeof(uint8_t) + 3 * sizeof(uint32_t))) {
+        primitives.resize(numPrimitives);
+    }
+    for (PrimitiveRecord& prim : primitives) {
+        prim.materialIndex = reader.read<int32_t>();
+        prim.hasTexCoords = reader.read<uint8_t>() != 0;
+        prim.hasSkin = reader.read<uint8_t>() != 0;
+        prim.vertexCount = reader.read<uint32_t>();
+        prim.indexType = reader.read<uint32_t>();
+        prim.indexCount = reader.read<uint32_t>();
+        const size_t indexSize = prim.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+        if ((prim.indexType != GL_UNSIGNED_SHORT && prim.indexType != GL_UNSIGNED_INT) ||
+            !reader.canHold(prim.vertexCount, sizeof(CharacterCooker::Vertex))) {
+            reader.fail();
+            break;
+        }
+        prim.vertices = reader.skip(prim.vertexCount * sizeof(CharacterCooker::Vertex));
+        prim.indices = reader.canHold(prim.indexCount, indexSize) ? reader.skip(prim.indexCount * indexSize) : nullptr;
+    }
+
+    std::vector<AnimationClip> animations;
+    const uint32_t numAnimations = reader.read<uint32_t>();
+    if (reader.canHold(numAnimations, sizeof(uint32_t))) {
+        animations.reserve(numAnimations);
+        for (uint32_t i = 0; i < numAnimations && reader.ok(); ++i) {
+            animations.emplace_back(reader);
+            if (!animations.back().fitsSkeleton(joints.size())) reader.fail();
+        }
+    }
+
+    if (!reader.ok() || reader.remaining() != 0) {
+        std::cerr << "Cooked character data is corrupt, cooking it again" << std::endl;
+        return false;
+    }
+
+    // textures
+    _textures.reserve(textures.size());
+    for (const TextureRecord& texture : textures) {
+        _textures.push_back(GLResources::createTexture2D(
+            texture.width, texture.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels,
+            texture.minFilter, texture.magFilter, texture.wrapS, texture.wrapT));
+    }
+
+    // materials
+    _materials = std::move(materials);
+    for (size_t i = 0; i < _materials.size(); ++i) {
+        _materials[i].textureID = materialTextures[i] >= 0 ? _textures[materialTextures[i]] : 0;
+        _materials[i].hasTexture = _materials[i].textureID != 0;
+    }
+
+    // one interleaved vertex buffer per primitive
+    const GLsizei stride = sizeof(CharacterCooker::Vertex);
+    _primitives.reserve(primitives.size());
+    for (const PrimitiveRecord& record : primitives) {
+        Primitive prim = {};
+        prim.materialIndex = record.materialIndex;
+        prim.hasTexCoords = record.hasTexCoords;
+        prim.hasSkin = record.hasSkin;
+        prim.vertexCount = static_cast<int>(record.vertexCount);
+        prim.indexCount = static_cast<int>(record.indexCount);
+        prim.indexType = record.indexType;
+
+        prim.vao = GLResources::createVertexArray();
+        prim.vbo = GLResources::createStaticBuffer(record.vertexCount * sizeof(CharacterCooker::Vertex), record.vertices);
+        GLResources::setVertexAttribute(prim.vao, 0, prim.vbo, 3, GL_FLOAT, stride,
+                                        offsetof(CharacterCooker::Vertex, position));
+        GLResources::setVertexAttribute(prim.vao, 1, prim.vbo, 3, GL_FLOAT, stride,
+                                        offsetof(CharacterCooker::Vertex, normal));
+        if (record.hasSkin) {
+            GLResources::setIntegerVertexAttribute(prim.vao, 2, prim.vbo, 4, GL_UNSIGNED_SHORT, stride,
+                                                   offsetof(CharacterCooker::Vertex, joints));
+            GLResources::setVertexAttribute(prim.vao, 3, prim.vbo, 4, GL_FLOAT, stride,
+                                            offsetof(CharacterCooker::Vertex, weights));
+        }
+        if (record.hasTexCoords) {
+            GLResources::setVertexAttribute(prim.vao, 4, prim.vbo, 2, GL_FLOAT, stride,
+                                            offsetof(CharacterCooker::Vertex, texCoord));
+        }
+
+        prim.ibo = GLResources::createStaticBuffer(
+            record.indexCount * (record.indexType == GL_UNSIGNED_SHORT ? 2 : 4), record.indices);
+        GLResources::setElementBuffer(prim.vao, prim.ibo);
+
+        _primitives.push_back(prim);
+    }
+
+    _joints = std::move(joints);
+    _restPose = std::move(restPose);
+    _animations = std::move(animations);
+
+    return true;
+}
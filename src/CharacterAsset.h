@@ -0,0 +1,91 @@
+#ifndef CHARACTER_ASSET_H
+#define CHARACTER_ASSET_H
+
+#include "AnimationClip.h"
+#include "CharacterCooker.h"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// The parts of a loaded character that never change once loaded: its mesh
+// buffers, materials, skeleton and animation clips.
+//
+// Assets are shared between every character loaded from the same file, each
+// character keeping only its own transform, animation state and pose. An
+// asset lives as long as some character holds it. Assets load from the
+// cooked form of their glTF file, which is made the first time and whenever
+// the file changes (see CharacterCooker). Joints are stored parents first.
+class CharacterAsset {
+public:
+    struct Primitive {
+        GLuint vao;
+        GLuint vbo; // interleaved CharacterCooker::Vertex
+        GLuint ibo;
+        int vertexCount;
+        int indexCount;
+        GLenum indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        int materialIndex;
+        bool hasTexCoords;
+        bool hasSkin; // joints and weights are bound
+    };
+
+    struct Joint {
+        std::string name;
+        int parentIndex;
+        glm::mat4 inverseBindMatrix; // Brings vertex from mesh space to bone space
+        glm::mat4 restTransform; // relative to parent, when no clip animates it
+    };
+
+    struct Material {
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+        float shininess;
+        GLuint textureID;
+        bool hasTexture;
+    };
+
+    // the asset loaded from the glTF binary at filepath, loading it only if no character holds
+    // it already. nullptr if it fails to load
+    static std::shared_ptr<const CharacterAsset> load(const std::string& filepath);
+
+    ~CharacterAsset();
+
+    CharacterAsset(const CharacterAsset&) = delete;
+    CharacterAsset& operator=(const CharacterAsset&) = delete;
+
+    const std::vector<Primitive>& getPrimitives() const { return _primitives; }
+    const std::vector<Joint>& getJoints() const { return _joints; }
+    // the rest pose of every joint, in the same order
+    const std::vector<JointPose>& getRestPose() const { return _restPose; }
+    const std::vector<AnimationClip>& getAnimations() const { return _animations; }
+    const std::vector<Material>& getMaterials() const { return _materials; }
+
+    // index of the named clip, or -1
+    int findAnimation(const std::string& animationName) const;
+
+private:
+    CharacterAsset();
+
+    std::vector<Primitive> _primitives;
+    // parents before children
+    std::vector<Joint> _joints;
+    // read from the skin's nodes once at load, what a joint holds when the
+    // playing clip does not animate it
+    std::vector<JointPose> _restPose;
+    // animation data, resampled and quantized at load
+    std::vector<AnimationClip> _animations;
+    std::vector<Material> _materials;
+    // the textures of the materials
+    std::vector<GLuint> _textures;
+
+    bool _loadFromFile(const std::string& filepath);
+    // creates everything from cooked data, false without creating anything
+    // if the data is not cooked from a source with this stamp, or corrupt
+    bool _loadCooked(const unsigned char* data, size_t size, const CharacterCooker::SourceStamp& stamp);
+};
+
+#endif // CHARACTER_ASSET_H
@@ -0,0 +1,630 @@
+#include "CharacterCooker.h"
+#include "AnimationClip.h"
+
+#include <glad/gl.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#define TINYGLTF_IMPLEMENTATION
+#include <tiny_gltf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <utility>
+
+namespace {
+    const char MAGIC[4] = {'S', 'O', 'H', 'C'};
+
+    // one component of an accessor element as a float
+    float componentAsFloat(const unsigned char* component, const int componentType, const bool normalized) {
+        switch (componentType) {
+            case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+                float value;
+                memcpy(&value, component, sizeof(value));
+                return value;
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                return normalized ? *component / 255.0f : *component;
+            case TINYGLTF_COMPONENT_TYPE_BYTE: {
+                const float value = static_cast<int8_t>(*component);
+                return normalized ? std::max(value / 127.0f, -1.0f) : value;
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+                uint16_t value;
+                memcpy(&value, component, sizeof(value));
+                return normalized ? value / 65535.0f : value;
+            }
+            case TINYGLTF_COMPONENT_TYPE_SHORT: {
+                int16_t value;
+                memcpy(&value, component, sizeof(value));
+                return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
+                uint32_t value;
+                memcpy(&value, component, sizeof(value));
+                return static_cast<float>(value);
+            }
+            default:
+                return 0.0f;
+        }
+    }
+
+    // one component of an 8 or 16 bit image as 8 bits
+    unsigned char imageComponent(const tinygltf::Image& image, const size_t pixel, const int component) {
+        if (image.bits == 16) {
+            uint16_t value;
+            memcpy(&value, &image.image[(pixel * image.component + component) * 2], sizeof(value));
+            return static_cast<unsigned char>(value >> 8);
+        }
+        return image.image[pixel * image.component + component];
+    }
+}
+
+bool CharacterCooker::stampSource(const std::string& sourcePath, SourceStamp& stamp) {
+    std::error_code error;
+    const uintmax_t size = std::filesystem::file_size(sourcePath, error);
+    if (error) return false;
+    const std::filesystem::file_time_type modified = std::filesystem::last_write_time(sourcePath, error);
+    if (error) return false;
+
+    stamp.size = static_cast<uint64_t>(size);
+    stamp.modifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+    return true;
+}
+
+std::string CharacterCooker::cookedPathFor(const std::string& sourcePath) {
+    return sourcePath + ".cooked";
+}
+
+bool CharacterCooker::readHeader(BinaryReader& reader, const SourceStamp& stamp) {
+    char magic[4];
+    reader.readBytes(magic, sizeof(magic));
+    const uint32_t version = reader.read<uint32_t>();
+    const uint64_t sourceSize = reader.read<uint64_t>();
+    const int64_t sourceTime = reader.read<int64_t>();
+    return reader.ok() && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 && version == VERSION &&
+           sourceSize == stamp.size && sourceTime == stamp.modifiedTime;
+}
+
+bool CharacterCooker::save(const std::string& cookedPath, const std::vector<unsigned char>& blob) {
+    // written aside and moved over the old one, so a failed write never
+    // leaves half a file behind
+    const std::string partialPath = cookedPath + ".partial";
+    {
+        std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        if (!file) {
+            std::cerr << "Could not write " << partialPath << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(partialPath, cookedPath, error);
+    if (error) {
+        std::cerr << "Could not replace " << cookedPath << ": " << error.message() << std::endl;
+        std::filesystem::remove(partialPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool CharacterCooker::cook(const std::string& sourcePath, const SourceStamp& stamp, std::vector<unsigned char>& blob) {
+    tinygltf::TinyGLTF loader;
+    tinygltf::Model model;
+    std::string err, warn;
+
+    bool ret = false;
+    ret = loader.LoadBinaryFromFile(&model, &err, &warn, sourcePath);
+
+    if (!warn.empty()) {
+        std::cout << "GLTF Warning: " << warn << std::endl;
+    }
+
+    if (!err.empty()) {
+        std::cerr << "GLTF Error: " << err << std::endl;
+    }
+
+    if (!ret) {
+        std::cerr << "Failed to load glTF" << std::endl;
+        return false;
+    }
+
+    blob.clear();
+    BinaryWriter writer(blob);
+    writer.writeBytes(MAGIC, sizeof(MAGIC));
+    writer.write(VERSION);
+    writer.write(stamp.size);
+    writer.write(stamp.modifiedTime);
+
+    // the skeleton goes before the meshes and animations, they refer to
+    // joints by where it puts them
+    CharacterCooker cooker(model);
+    std::vector<int> textureIndices;
+    cooker._cookTextures(writer, textureIndices);
+    cooker._cookMaterials(writer, textureIndices);
+    cooker._cookSkeleton(writer);
+    cooker._cookMeshes(writer);
+    cooker._cookAnimations(writer);
+
+    std::cout << "Cooked " << sourcePath << " into " << blob.size() / 1024 << " KB" << std::endl;
+    return true;
+}
+
+CharacterCooker::CharacterCooker(const tinygltf::Model& model)
+    : _model(model)
+{
+}
+
+const unsigned char* CharacterCooker::_accessorData(const tinygltf::Accessor& accessor, size_t& byteStride) const {
+    if (accessor.bufferView < 0 || accessor.bufferView >= (int)_model.bufferViews.size()) return nullptr;
+    const tinygltf::BufferView& bufferView = _model.bufferViews[accessor.bufferView];
+    if (bufferView.buffer < 0 || bufferView.buffer >= (int)_model.buffers.size()) return nullptr;
+    const tinygltf::Buffer& buffer = _model.buffers[bufferView.buffer];
+
+    const int stride = accessor.ByteStride(bufferView);
+    if (stride <= 0) return nullptr;
+    byteStride = stride;
+
+    // the last element has to end inside the view and the view inside the
+    // buffer
+    const size_t elementSize = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(accessor.componentType)) *
+                               tinygltf::GetNumComponentsInType(accessor.type);
+    const size_t start = accessor.byteOffset;
+    const size_t end = accessor.count > 0 ? start + (accessor.count - 1) * byteStride + elementSize : start;
+    if (end > bufferView.byteLength || bufferView.byteOffset + bufferView.byteLength > buffer.data.size()) {
+        return nullptr;
+    }
+    return &buffer.data[bufferView.byteOffset + start];
+}
+
+bool CharacterCooker::_readAccessor(const int accessorIndex, const int components, std::vector<float>& values) const {
+    if (accessorIndex < 0 || accessorIndex >= (int)_model.accessors.size()) return false;
+    const tinygltf::Accessor& accessor = _model.accessors[accessorIndex];
+    const int accessorComponents = tinygltf::GetNumComponentsInType(accessor.type);
+    const int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+    if (accessorComponents < components || componentSize <= 0) return false;
+
+    size_t byteStride = 0;
+    const unsigned char* data = _accessorData(accessor, byteStride);
+    if (!data) return false;
+
+    values.resize(accessor.count * components);
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char* element = data + i * byteStride;
+        for (int c = 0; c < components; ++c) {
+            values[i * components + c] = componentAsFloat(element + c * componentSize, accessor.componentType,
+                                                          accessor.normalized);
+        }
+    }
+    return true;
+}
+
+bool CharacterCooker::_readIndices(const int accessorIndex, std::vector<uint32_t>& indices) const {
+    if (accessorIndex < 0 || accessorIndex >= (int)_model.accessors.size()) return false;
+    const tinygltf::Accessor& accessor = _model.accessors[accessorIndex];
+
+    size_t byteStride = 0;
+    const unsigned char* data = _accessorData(accessor, byteStride);
+    if (!data) return false;
+
+    indices.resize(accessor.count);
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char* element = data + i * byteStride;
+        switch (accessor.componentType) {
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                indices[i] = *element;
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+                uint16_t index;
+                memcpy(&index, element, sizeof(index));
+                indices[i] = index;
+                break;
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+                memcpy(&indices[i], element, sizeof(uint32_t));
+                break;
+            default:
+                std::cerr << "Unknown index type: " << accessor.componentType << std::endl;
+                return false;
+        }
+    }
+    return true;
+}
+
+// every texture a material uses, converted to RGBA8
+void CharacterCooker::_cookTextures(BinaryWriter& writer, std::vector<int>& textureIndices) const {
+    textureIndices.assign(_model.textures.size(), -1);
+
+    std::vector<unsigned char> pixels;
+    std::vector<std::pair<int, const tinygltf::Image*>> cooked;
+    for (size_t i = 0; i < _model.textures.size(); ++i) {
+        const tinygltf::Texture& tex = _model.textures[i];
+        if (tex.source < 0 || tex.source >= (int)_model.images.size()) continue;
+
+        const tinygltf::Image& image = _model.images[tex.source];
+        const size_t bytesPerComponent = image.bits == 16 ? 2 : 1;
+        if (image.width <= 0 || image.height <= 0 || image.component < 1 || image.component > 4 ||
+            (image.bits != 8 && image.bits != 16) ||
+            image.image.size() < static_cast<size_t>(image.width) * image.height * image.component * bytesPerComponent) {
+            std::cerr << "Skipping texture " << i << ", its image is not 8 or 16 bit" << std::endl;
+            continue;
+        }
+
+        textureIndices[i] = cooked.size();
+        cooked.emplace_back(static_cast<int>(i), &image);
+    }
+
+    writer.write(static_cast<uint32_t>(cooked.size()));
+    for (const auto& entry : cooked) {
+        const tinygltf::Texture& tex = _model.textures[entry.first];
+        const tinygltf::Image& image = *entry.second;
+
+        // Default texture parameters, will just be white
+        int32_t minFilter = GL_LINEAR_MIPMAP_LINEAR;
+        int32_t magFilter = GL_LINEAR;
+        int32_t wrapS = GL_REPEAT;
+        int32_t wrapT = GL_REPEAT;
+        if (tex.sampler >= 0 && tex.sampler < (int)_model.samplers.size()) {
+            const tinygltf::Sampler& sampler = _model.samplers[tex.sampler];
+            minFilter = sampler.minFilter != -1 ? sampler.minFilter : GL_LINEAR;
+            magFilter = sampler.magFilter != -1 ? sampler.magFilter : GL_LINEAR;
+            wrapS = sampler.wrapS;
+            wrapT = sampler.wrapT;
+        }
+
+        // gray spreads over red, green and blue, missing alpha is opaque
+        const size_t numPixels = static_cast<size_t>(image.width) * image.height;
+        pixels.resize(numPixels * 4);
+        for (size_t p = 0; p < numPixels; ++p) {
+            unsigned char* out = &pixels[p * 4];
+            if (image.component <= 2) {
+                out[0] = out[1] = out[2] = imageComponent(image, p, 0);
+                out[3] = image.component == 2 ? imageComponent(image, p, 1) : 255;
+            } else {
+                out[0] = imageComponent(image, p, 0);
+                out[1] = imageComponent(image, p, 1);
+                out[2] = imageComponent(image, p, 2);
+                out[3] = image.component == 4 ? imageComponent(image, p, 3) : 255;
+            }
+        }
+
+        writer.write(static_cast<int32_t>(image.width));
+        writer.write(static_cast<int32_t>(image.height));
+        writer.write(minFilter);
+        writer.write(magFilter);
+        writer.write(wrapS);
+        writer.write(wrapT);
+        writer.writeBytes(pixels.data(), pixels.size());
+    }
+}
+
+void CharacterCooker::_cookMaterials(BinaryWriter& writer, const std::vector<int>& textureIndices) const {
+    // default material
+    if (_model.materials.empty()) {
+        writer.write(static_cast<uint32_t>(1));
+        writer.write(glm::vec3(0.8f));
+        writer.write(glm::vec3(0.2f));
+        writer.write(32.0f);
+        writer.write(static_cast<int32_t>(-1));
+        return;
+    }
+
+    writer.write(static_cast<uint32_t>(_model.materials.size()));
+    for (const auto& mat : _model.materials) {
+        // metallic on material, will be translated to specular
+        glm::vec3 diffuse(0.8f);
+        if (mat.pbrMetallicRoughness.baseColorFactor.size() >= 3) {
+            diffuse = glm::vec3(
+                mat.pbrMetallicRoughness.baseColorFactor[0],
+                mat.pbrMetallicRoughness.baseColorFactor[1],
+                mat.pbrMetallicRoughness.baseColorFactor[2]
+            );
+        }
+
+        // base color texture
+        const int textureIndex = mat.pbrMetallicRoughness.baseColorTexture.index;
+        const int32_t cookedTexture = textureIndex >= 0 && textureIndex < (int)textureIndices.size()
+            ? textureIndices[textureIndex] : -1;
+
+        // approximate specular from metallic
+        float metallic = mat.pbrMetallicRoughness.metallicFactor;
+        const glm::vec3 specular(glm::max(metallic, 0.15f));
+
+        // shine from roughness
+        float roughness = mat.pbrMetallicRoughness.roughnessFactor;
+        const float shininess = glm::max((1.0f - roughness) * 128.0f, 4.0f);
+
+        writer.write(diffuse);
+        writer.write(specular);
+        writer.write(shininess);
+        writer.write(cookedTexture);
+    }
+}
+
+// need to handle all parental relationships between joints and also inital locations
+void CharacterCooker::_cookSkeleton(BinaryWriter& writer) {
+    _jointIndices.clear();
+
+    // find the skin
+    if (_model.skins.empty()) {
+        std::cout << "No skeleton found in model" << std::endl;
+        writer.write(static_cast<uint32_t>(0));
+        return;
+    }
+
+    const tinygltf::Skin& skin = _model.skins[0];
+    const size_t numJoints = skin.joints.size();
+
+    // inverse bind matrices are optional, the identity if missing
+    std::vector<float> matrices;
+    if (skin.inverseBindMatrices >= 0 &&
+        (!_readAccessor(skin.inverseBindMatrices, 16, matrices) || matrices.size() < numJoints * 16)) {
+        std::cerr << "Skin has unreadable inverse bind matrices" << std::endl;
+        writer.write(static_cast<uint32_t>(0));
+        return;
+    }
+
+    // node to skin index and node to parent node, each one pass
+    std::vector<int> nodeToSkin(_model.nodes.size(), -1);
+    for (size_t i = 0; i < numJoints; ++i) {
+        nodeToSkin[skin.joints[i]] = i;
+    }
+    std::vector<int> nodeParents(_model.nodes.size(), -1);
+    for (size_t j = 0; j < _model.nodes.size(); ++j) {
+        for (int child : _model.nodes[j].children) {
+            nodeParents[child] = j;
+        }
+    }
+
+    // find each joint's parent and children, in skin order. The children
+    // are packed by parent, counted first then filled
+    std::vector<int> skinParents(numJoints, -1);
+    std::vector<int> childStart(numJoints + 1, 0);
+    for (size_t i = 0; i < numJoints; ++i) {
+        const int parentNode = nodeParents[skin.joints[i]];
+        skinParents[i] = parentNode < 0 ? -1 : nodeToSkin[parentNode];
+        if (skinParents[i] >= 0) ++childStart[skinParents[i] + 1];
+    }
+    for (size_t i = 0; i < numJoints; ++i) {
+        childStart[i + 1] += childStart[i];
+    }
+    std::vector<int> children(childStart[numJoints]);
+    std::vector<int> childFill(childStart.begin(), childStart.end() - 1);
+    for (size_t i = 0; i < numJoints; ++i) {
+        if (skinParents[i] >= 0) children[childFill[skinParents[i]]++] = i;
+    }
+
+    // store the joints breadth first from the roots, so every parent comes
+    // before its children and the global transforms are one pass down the
+    // array. The order itself is the queue
+    std::vector<int> order;
+    order.reserve(numJoints);
+    for (size_t i = 0; i < numJoints; ++i) {
+        if (skinParents[i] < 0) order.push_back(i);
+    }
+    for (size_t next = 0; next < order.size(); ++next) {
+        const int parent = order[next];
+        order.insert(order.end(), children.begin() + childStart[parent], children.begin() + childStart[parent + 1]);
+    }
+    if (order.size() != numJoints) {
+        // only a cycle leaves joints unreached, which is not a valid skin
+        std::cerr << "Skin joints do not form a tree" << std::endl;
+        writer.write(static_cast<uint32_t>(0));
+        return;
+    }
+
+    // skin index to where the joint is stored
+    _jointIndices.resize(numJoints);
+    for (size_t i = 0; i < numJoints; ++i) {
+        _jointIndices[order[i]] = i;
+    }
+
+    writer.write(static_cast<uint32_t>(numJoints));
+    for (size_t i = 0; i < numJoints; ++i) {
+        const int skinIndex = order[i];
+        const tinygltf::Node& node = _model.nodes[skin.joints[skinIndex]];
+
+        const glm::mat4 inverseBindMatrix = matrices.empty() ? glm::mat4(1.0f)
+            : glm::make_mat4(&matrices[skinIndex * 16]);
+        const int32_t parentIndex = skinParents[skinIndex] < 0 ? -1 : _jointIndices[skinParents[skinIndex]];
+
+        // rest pose, missing parts are the identity
+        JointPose rest;
+        rest.translation = node.translation.size() < 3 ? glm::vec3(0.0f)
+            : glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+        rest.rotation = node.rotation.size() < 4 ? glm::quat(1.0f, 0.0f, 0.0f, 0.0f)
+            : glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
+        rest.scale = node.scale.size() < 3 ? glm::vec3(1.0f)
+            : glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+
+        // get initial transform
+        glm::mat4 restTransform;
+        if (node.matrix.size() == 16) {
+            const std::vector<float> matrix(node.matrix.begin(), node.matrix.end());
+            restTransform = glm::make_mat4(matrix.data());
+        } else {
+            restTransform = rest.toMatrix();
+        }
+
+        writer.writeString(node.name);
+        writer.write(parentIndex);
+        writer.write(inverseBindMatrix);
+        writer.write(restTransform);
+        writer.write(rest.translation);
+        writer.write(glm::vec4(rest.rotation.x, rest.rotation.y, rest.rotation.z, rest.rotation.w));
+        writer.write(rest.scale);
+    }
+}
+
+void CharacterCooker::_cookMeshes(BinaryWriter& writer) const {
+    // written after their count, which is only known once every primitive
+    // has been read
+    std::vector<unsigned char> primitives;
+    BinaryWriter primitiveWriter(primitives);
+    uint32_t numPrimitives = 0;
+
+    std::vector<float> positions, normals, texCoords, joints, weights;
+    std::vector<uint32_t> indices;
+    std::vector<Vertex> vertices;
+    for (const auto& mesh : _model.meshes) {
+        for (const auto& primitive : mesh.primitives) {
+            const auto attribute = [&](const char* name) {
+                const auto it = primitive.attributes.find(name);
+                return it != primitive.attributes.end() ? it->second : -1;
+            };
+
+            if (!_readAccessor(attribute("POSITION"), 3, positions)) {
+                std::cerr << "Skipping a primitive of " << mesh.name << " without positions" << std::endl;
+                continue;
+            }
+            const size_t vertexCount = positions.size() / 3;
+            const bool hasNormals = _readAccessor(attribute("NORMAL"), 3, normals) && normals.size() / 3 == vertexCount;
+            const bool hasTexCoords = _readAccessor(attribute("TEXCOORD_0"), 2, texCoords) &&
+                                      texCoords.size() / 2 == vertexCount;
+            const bool hasSkin = !_jointIndices.empty() &&
+                                 _readAccessor(attribute("JOINTS_0"), 4, joints) && joints.size() / 4 == vertexCount &&
+                                 _readAccessor(attribute("WEIGHTS_0"), 4, weights) && weights.size() / 4 == vertexCount;
+
+            vertices.assign(vertexCount, Vertex{});
+            for (size_t v = 0; v < vertexCount; ++v) {
+                Vertex& vertex = vertices[v];
+                vertex.position = glm::make_vec3(&positions[v * 3]);
+                if (hasNormals) vertex.normal = glm::make_vec3(&normals[v * 3]);
+                if (hasTexCoords) vertex.texCoord = glm::make_vec2(&texCoords[v * 2]);
+                if (!hasSkin) continue;
+
+                // the file numbers joints in the skin's order, renumber them
+                // to the skeleton's
+                vertex.weights = glm::make_vec4(&weights[v * 4]);
+                for (int c = 0; c < 4; ++c) {
+                    const size_t skinIndex = static_cast<size_t>(joints[v * 4 + c]);
+                    vertex.joints[c] = skinIndex < _jointIndices.size()
+                        ? static_cast<uint16_t>(_jointIndices[skinIndex]) : 0;
+                }
+            }
+
+            // without indices the vertices are the triangles in order
+            if (primitive.indices >= 0) {
+                if (!_readIndices(primitive.indices, indices)) {
+                    std::cerr << "Skipping a primitive of " << mesh.name << " with unreadable indices" << std::endl;
+                    continue;
+                }
+            } else {
+                indices.resize(vertexCount);
+                for (size_t v = 0; v < vertexCount; ++v) indices[v] = v;
+            }
+
+            primitiveWriter.write(static_cast<int32_t>(primitive.material));
+            primitiveWriter.write(static_cast<uint8_t>(hasTexCoords));
+            primitiveWriter.write(static_cast<uint8_t>(hasSkin));
+            primitiveWriter.write(static_cast<uint32_t>(vertexCount));
+
+            // 16 bit indices whenever they reach every vertex, never 8 bit,
+            // which GPUs handle poorly
+            const bool shortIndices = vertexCount <= 65536;
+            primitiveWriter.write(static_cast<uint32_t>(shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT));
+            primitiveWriter.write(static_cast<uint32_t>(indices.size()));
+            primitiveWriter.writeBytes(vertices.data(), vertices.size() * sizeof(Vertex));
+            for (const uint32_t index : indices) {
+                // out of range indices would read past the vertices
+                const uint32_t value = index < vertexCount ? index : 0;
+                if (shortIndices) {
+                    primitiveWriter.write(static_cast<uint16_t>(value));
+                } else {
+                    primitiveWriter.write(value);
+                }
+            }
+            ++numPrimitives;
+        }
+    }
+
+    writer.write(numPrimitives);
+    writer.writeBytes(primitives.data(), primitives.size());
+}
+
+// setup the animations from the gltf model
+void CharacterCooker::_cookAnimations(BinaryWriter& writer) const {
+    std::cout << "Loading " << _model.animations.size() << " animations:" << std::endl;
+    if (_jointIndices.empty()) {
+        writer.write(static_cast<uint32_t>(0));
+        return;
+    }
+
+    // node to joint, channels name the node they animate
+    const tinygltf::Skin& skin = _model.skins[0];
+    std::vector<int> nodeToJoint(_model.nodes.size(), -1);
+    for (size_t i = 0; i < skin.joints.size(); ++i) {
+        nodeToJoint[skin.joints[i]] = _jointIndices[i];
+    }
+
+    // per joint and channel type, where that channel is in tempChannels
+    constexpr size_t NO_CHANNEL = static_cast<size_t>(-1);
+    std::vector<size_t> channelSlots;
+    std::vector<float> times, values;
+
+    writer.write(static_cast<uint32_t>(_model.animations.size()));
+    for (const auto& anim : _model.animations) {
+        std::cout << "  - Animation: \"" << anim.name << "\"" << std::endl;
+
+        // FIX: track channels and filter duplicates, the last one wins
+        channelSlots.assign(_jointIndices.size() * 3, NO_CHANNEL);
+        std::vector<AnimationClip::SourceChannel> tempChannels;
+
+        for (const auto& channel : anim.channels) {
+            if (channel.sampler < 0 || channel.sampler >= (int)anim.samplers.size()) continue;
+            const tinygltf::AnimationSampler& sampler = anim.samplers[channel.sampler];
+
+            // find which joint this channel affects, again, theres like 700+ duplicate channels, but it doesn't seem to be bad
+            int targetNode = channel.target_node;
+            if (targetNode < 0 || targetNode >= (int)nodeToJoint.size()) continue;
+            int jointIndex = nodeToJoint[targetNode];
+
+            if (jointIndex < 0) continue;
+
+            AnimationClip::SourceChannel animChannel;
+            animChannel.jointIndex = jointIndex;
+
+            // set channel type, rotations stored x, y, z, w like the file
+            int components = 3;
+            if (channel.target_path == "translation") {
+                animChannel.type = AnimationClip::TRANSLATION;
+            } else if (channel.target_path == "rotation") {
+                animChannel.type = AnimationClip::ROTATION;
+                components = 4;
+            } else if (channel.target_path == "scale") {
+                animChannel.type = AnimationClip::SCALE;
+            } else {
+                continue; // unknown channel type, shouldn't ever reach here
+            }
+
+            // load times and values
+            if (!_readAccessor(sampler.input, 1, times) || !_readAccessor(sampler.output, components, values)) {
+                continue;
+            }
+            animChannel.times = times;
+            animChannel.values.resize(values.size() / components);
+            for (size_t i = 0; i < animChannel.values.size(); ++i) {
+                const float* value = &values[i * components];
+                animChannel.values[i] = glm::vec4(value[0], value[1], value[2], components == 4 ? value[3] : 0.0f);
+            }
+
+            size_t& slot = channelSlots[jointIndex * 3 + animChannel.type];
+            if (slot != NO_CHANNEL) {
+                tempChannels[slot] = std::move(animChannel);
+            } else {
+                slot = tempChannels.size();
+                tempChannels.push_back(std::move(animChannel));
+            }
+        }
+
+        // resampled and quantized, the source keyframes are not kept
+        const AnimationClip clip(anim.name, tempChannels);
+        clip.write(writer);
+        std::cout << "    " << tempChannels.size() << " channels, " << clip.getFrameCount()
+                  << " frames, " << clip.getSampleBytes() / 1024 << " KB" << std::endl;
+    }
+}
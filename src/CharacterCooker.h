@@ -0,0 +1,101 @@
+#ifndef CHARACTER_COOKER_H
+#define CHARACTER_COOKER_H
+
+#include "BinaryStream.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// forward declaration of required gltf stuff
+namespace tinygltf {
+    class Model;
+    struct Accessor;
+}
+
+// Converts a glTF binary character into the cooked form CharacterAsset loads.
+//
+// Reading a .glb parses its JSON, decodes its images and copies its buffers,
+// and only then can anything go to the GPU. A cooked file holds the result
+// of all that, ready to upload straight from a mapping of the file: one
+// interleaved vertex buffer and 16 or 32 bit indices per primitive, textures
+// as RGBA8, the skeleton parents first and the packed clips. It is written
+// next to the source the first time the source is loaded and stamped with
+// the source's size and modification time, so changing the source cooks it
+// again on the next load.
+//
+// The file is the header, then sections each led by their count:
+//   textures    width, height, minFilter, magFilter, wrapS, wrapT, pixels
+//   materials   diffuse, specular, shininess, texture index or -1
+//   joints      name, parent index, inverse bind matrix, rest transform,
+//               rest translation, rotation (xyzw) and scale
+//   primitives  material index, hasTexCoords, hasSkin, vertex count, index
+//               type, index count, vertices, indices
+//   clips       as AnimationClip::write() writes them
+// in memory order, for the build that wrote it.
+class CharacterCooker {
+public:
+    // bump whenever the layout changes, files from other versions are cooked
+    // again
+    static constexpr uint32_t VERSION = 1;
+
+    // identifies the source a cooked file was made from
+    struct SourceStamp {
+        uint64_t size;
+        int64_t modifiedTime;
+    };
+
+    // one vertex of a primitive's vertex buffer
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+        glm::vec4 weights;
+        uint16_t joints[4];
+    };
+
+    // false if the source cannot be found
+    static bool stampSource(const std::string& sourcePath, SourceStamp& stamp);
+
+    // where the cooked form of sourcePath is kept
+    static std::string cookedPathFor(const std::string& sourcePath);
+
+    // loads the glTF binary at sourcePath and cooks it into blob
+    static bool cook(const std::string& sourcePath, const SourceStamp& stamp, std::vector<unsigned char>& blob);
+
+    // writes blob to cookedPath, replacing it only once fully written
+    static bool save(const std::string& cookedPath, const std::vector<unsigned char>& blob);
+
+    // reads the header, false if it is not a cooked file of this version
+    // made from a source with this stamp
+    static bool readHeader(BinaryReader& reader, const SourceStamp& stamp);
+
+private:
+    explicit CharacterCooker(const tinygltf::Model& model);
+
+    const tinygltf::Model& _model;
+
+    // maps the skin's joint order to the parents first order joints are
+    // cooked in
+    std::vector<int> _jointIndices;
+
+    void _cookTextures(BinaryWriter& writer, std::vector<int>& textureIndices) const;
+    void _cookMaterials(BinaryWriter& writer, const std::vector<int>& textureIndices) const;
+    void _cookMeshes(BinaryWriter& writer) const;
+    void _cookSkeleton(BinaryWriter& writer);
+    void _cookAnimations(BinaryWriter& writer) const;
+
+    // the components of every element of an accessor as floats, integer
+    // components normalized if the accessor says so. False if it does not
+    // fit its buffer
+    bool _readAccessor(int accessorIndex, int components, std::vector<float>& values) const;
+    // an accessor of 8, 16 or 32 bit indices as 32 bit ones
+    bool _readIndices(int accessorIndex, std::vector<uint32_t>& indices) const;
+    // the address of an accessor's first element and its stride, nullptr if
+    // it does not fit its buffer
+    const unsigned char* _accessorData(const tinygltf::Accessor& accessor, size_t& byteStride) const;
+};
+
+#endif // CHARACTER_COOKER_H
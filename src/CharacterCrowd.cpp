@@ -0,0 +1,254 @@
+#include "CharacterCrowd.h"
+#include "GLResources.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    // a matrix is four RGBA32F texels, a normal matrix three with w unused
+    constexpr GLint TEXELS_PER_MATRIX = 4;
+    constexpr GLint TEXELS_PER_NORMAL_MATRIX = 3;
+    constexpr GLsizeiptr TEXEL_SIZE = 4 * sizeof(GLfloat);
+    // a skinned vertex is two RGB32F texels
+    constexpr GLint TEXELS_PER_SKINNED_VERTEX = 2;
+}
+
+CharacterCrowd::CharacterCrowd(const GLsizei maxInstances, const GLsizei maxJoints)
+    : _paletteBuffer(nullptr),
+      _paletteTexture(0),
+      _maxInstances(maxInstances),
+      _maxJoints(maxJoints),
+      _tooManyJoints(false),
+      _skinnedBuffer(0),
+      _skinnedTexture(0),
+      _skinnedCapacity(0),
+      _maxSkinnedVertices(0),
+      _numBatches(0),
+      _numInstances(0)
+{
+    // all regions of the buffer are visible through the texture, which has
+    // to stay within the texel limit
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    const GLsizeiptr texelsPerInstance =
+        TEXELS_PER_MATRIX + _maxJoints * (TEXELS_PER_MATRIX + TEXELS_PER_NORMAL_MATRIX);
+    const GLsizeiptr maxFitting = maxTexels / (texelsPerInstance * StreamingBuffer::NUM_REGIONS);
+    if (_maxInstances > maxFitting) {
+        fprintf(stderr, "[ERROR]: texture buffers of %d texels only fit %ld characters, not %d\n",
+                maxTexels, static_cast<long>(maxFitting), _maxInstances);
+        _maxInstances = static_cast<GLsizei>(maxFitting);
+    }
+
+    _paletteBuffer = new StreamingBuffer(GL_TEXTURE_BUFFER,
+                                         std::max<GLsizeiptr>(_maxInstances * texelsPerInstance * TEXEL_SIZE,
+                                                              TEXEL_SIZE));
+
+    glGenTextures(1, &_paletteTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, _paletteTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _paletteBuffer->getHandle());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    // its buffer is made once the first characters are skinned
+    glGenTextures(1, &_skinnedTexture);
+    _maxSkinnedVertices = maxTexels / TEXELS_PER_SKINNED_VERTEX;
+
+    _staging.reserve(_maxInstances * texelsPerInstance);
+
+    fprintf(stdout, "[INFO]: character crowd of up to %d characters with %d joints\n",
+            _maxInstances, _maxJoints);
+}
+
+CharacterCrowd::~CharacterCrowd() {
+    glDeleteTextures(1, &_paletteTexture);
+    delete _paletteBuffer;
+    glDeleteTextures(1, &_skinnedTexture);
+    glDeleteBuffers(1, &_skinnedBuffer);
+}
+
+void CharacterCrowd::_allocateSkinned(const GLsizeiptr vertexCapacity) {
+    glDeleteBuffers(1, &_skinnedBuffer);
+    _skinnedBuffer = GLResources::createDynamicBuffer(vertexCapacity * sizeof(SkinnedVertex), nullptr);
+    _skinnedCapacity = vertexCapacity;
+
+    glBindTexture(GL_TEXTURE_BUFFER, _skinnedTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32F, _skinnedBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void CharacterCrowd::beginFrame() {
+    _paletteBuffer->beginFrame();
+    for (size_t i = 0; i < _numBatches; ++i) {
+        _batches[i].characters.clear();
+    }
+    _numBatches = 0;
+    _numInstances = 0;
+}
+
+void CharacterCrowd::add(const Character& character) {
+    const CharacterAsset* asset = character.getAsset();
+    if (!asset || _numInstances >= _maxInstances) return;
+    if (static_cast<GLsizei>(asset->getJoints().size()) > _maxJoints) {
+        // characters are queued every frame, once is enough to know
+        if (!_tooManyJoints) {
+            fprintf(stderr, "[ERROR]: character with %zu joints, the crowd only has room for %d\n",
+                    asset->getJoints().size(), _maxJoints);
+            _tooManyJoints = true;
+        }
+        return;
+    }
+
+    // there are only ever a few assets, a search beats a map
+    size_t batch = 0;
+    while (batch < _numBatches && _batches[batch].asset != asset) ++batch;
+    if (batch == _numBatches) {
+        if (_numBatches == _batches.size()) _batches.emplace_back();
+        _batches[_numBatches].asset = asset;
+        ++_numBatches;
+    }
+    _batches[batch].characters.push_back(&character);
+    ++_numInstances;
+}
+
+void CharacterCrowd::upload() {
+    for (size_t i = 0; i < _numBatches; ++i) {
+        Batch& batch = _batches[i];
+
+        _staging.clear();
+        for (const Character* character : batch.characters) {
+            const glm::mat4 modelMtx = character->getModelMatrix();
+            _staging.insert(_staging.end(), &modelMtx[0], &modelMtx[0] + TEXELS_PER_MATRIX);
+            for (const glm::mat4& joint : character->getJointMatrices()) {
+                _staging.insert(_staging.end(), &joint[0], &joint[0] + TEXELS_PER_MATRIX);
+            }
+            for (const glm::mat3& normalMtx : character->getJointNormalMatrices()) {
+                for (int column = 0; column < TEXELS_PER_NORMAL_MATRIX; ++column) {
+                    _staging.emplace_back(normalMtx[column], 0.0f);
+                }
+            }
+        }
+
+        const GLintptr offset = _paletteBuffer->write(_staging.data(), _staging.size() * sizeof(glm::vec4),
+                                                      TEXEL_SIZE);
+        if (offset < 0) {
+            // sized for the capacity, so this does not happen
+            batch.characters.clear();
+            continue;
+        }
+        batch.firstTexel = static_cast<GLint>(offset / TEXEL_SIZE);
+    }
+}
+
+void CharacterCrowd::skin(const GLuint shaderProgramHandle, const SkinningLocations& locations) {
+    if (_numInstances == 0) return;
+
+    // every character gets its own copy of its asset's vertices, laid out
+    // batch by batch, then primitive by primitive, then character by
+    // character, the order the draws below capture them in
+    GLsizeiptr numVertices = 0;
+    for (size_t i = 0; i < _numBatches; ++i) {
+        Batch& batch = _batches[i];
+        GLsizeiptr verticesPerCharacter = 0;
+        for (const CharacterAsset::Primitive& prim : batch.asset->getPrimitives()) {
+            verticesPerCharacter += prim.vertexCount;
+        }
+
+        const GLsizeiptr fitting = (_maxSkinnedVertices - numVertices) / std::max<GLsizeiptr>(verticesPerCharacter, 1);
+        if (static_cast<GLsizeiptr>(batch.characters.size()) > fitting) {
+            batch.characters.resize(static_cast<size_t>(fitting));
+        }
+        batch.firstSkinnedVertex = static_cast<GLint>(numVertices);
+        numVertices += verticesPerCharacter * static_cast<GLsizeiptr>(batch.characters.size());
+    }
+    if (numVertices == 0) return;
+
+    // with room to spare, so a growing crowd does not grow it every frame
+    if (numVertices > _skinnedCapacity) {
+        const GLsizeiptr capacity = std::min(numVertices + numVertices / 4, _maxSkinnedVertices);
+        fprintf(stdout, "[INFO]: skinned character vertices grow from %ld to %ld\n",
+                static_cast<long>(_skinnedCapacity), static_cast<long>(capacity));
+        _allocateSkinned(capacity);
+    }
+
+    glProgramUniform1i(shaderProgramHandle, locations.instanceData, PALETTE_TEXTURE_UNIT);
+    glActiveTexture(GL_TEXTURE0 + PALETTE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, _paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    // one capture for the whole crowd, every draw appends to the last
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _skinnedBuffer);
+    glBeginTransformFeedback(GL_POINTS);
+    for (size_t i = 0; i < _numBatches; ++i) {
+        const Batch& batch = _batches[i];
+        if (batch.characters.empty()) continue;
+
+        glProgramUniform1i(shaderProgramHandle, locations.firstInstanceTexel, batch.firstTexel);
+        glProgramUniform1i(shaderProgramHandle, locations.jointCount,
+                           static_cast<GLint>(batch.asset->getJoints().size()));
+
+        for (const CharacterAsset::Primitive& prim : batch.asset->getPrimitives()) {
+            glProgramUniform1i(shaderProgramHandle, locations.hasSkin, prim.hasSkin ? 1 : 0);
+            glBindVertexArray(prim.vao);
+            glDrawArraysInstanced(GL_POINTS, 0, prim.vertexCount, static_cast<GLsizei>(batch.characters.size()));
+        }
+    }
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    glBindVertexArray(0);
+}
+
+void CharacterCrowd::draw(const GLuint shaderProgramHandle, const ShaderLocations& locations,
+                          const glm::mat4& viewProjectionMtx) const {
+    if (_numInstances == 0 || _skinnedBuffer == 0) return;
+
+    glProgramUniformMatrix4fv(shaderProgramHandle, locations.viewProjectionMatrix, 1, GL_FALSE,
+                              &viewProjectionMtx[0][0]);
+    glProgramUniform1i(shaderProgramHandle, locations.skinnedVertices, SKINNED_VERTICES_TEXTURE_UNIT);
+    glProgramUniform1i(shaderProgramHandle, locations.materialTexture, 0);
+
+    glActiveTexture(GL_TEXTURE0 + SKINNED_VERTICES_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, _skinnedTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    for (size_t i = 0; i < _numBatches; ++i) {
+        const Batch& batch = _batches[i];
+        if (batch.characters.empty()) continue;
+
+        const std::vector<CharacterAsset::Primitive>& primitives = batch.asset->getPrimitives();
+        const std::vector<CharacterAsset::Material>& materials = batch.asset->getMaterials();
+        const GLsizei numCharacters = static_cast<GLsizei>(batch.characters.size());
+
+        GLint firstVertex = batch.firstSkinnedVertex;
+        for (const CharacterAsset::Primitive& prim : primitives) {
+            glProgramUniform1i(shaderProgramHandle, locations.firstSkinnedVertex, firstVertex);
+            glProgramUniform1i(shaderProgramHandle, locations.vertexCount, prim.vertexCount);
+            firstVertex += prim.vertexCount * numCharacters;
+
+            // set material
+            const int matIdx = (prim.materialIndex >= 0 && prim.materialIndex < (int)materials.size())
+                               ? prim.materialIndex : 0;
+            const CharacterAsset::Material& mat = materials[matIdx];
+            glProgramUniform3fv(shaderProgramHandle, locations.materialDiffuse, 1, &mat.diffuse[0]);
+            glProgramUniform3fv(shaderProgramHandle, locations.materialSpecular, 1, &mat.specular[0]);
+            glProgramUniform1f(shaderProgramHandle, locations.materialShininess, mat.shininess);
+
+            // bind texture
+            if (mat.hasTexture) {
+                glBindTexture(GL_TEXTURE_2D, mat.textureID);
+            }
+            glProgramUniform1i(shaderProgramHandle, locations.useTexture, mat.hasTexture ? 1 : 0);
+
+            glBindVertexArray(prim.vao);
+            glDrawElementsInstanced(GL_TRIANGLES, prim.indexCount, prim.indexType, nullptr, numCharacters);
+        }
+    }
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void CharacterCrowd::endFrame() {
+    _paletteBuffer->endFrame();
+}
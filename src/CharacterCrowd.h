@@ -0,0 +1,126 @@
+#ifndef CHARACTER_CROWD_H
+#define CHARACTER_CROWD_H
+
+#include "Character.h"
+#include "StreamingBuffer.h"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Draws skinned characters in instanced batches, one draw per primitive for
+// every character sharing an asset.
+//
+// Each frame the queued characters' model matrices and joint palettes are
+// streamed into a texture buffer, a character's model matrix followed by its
+// joint matrices and then its joints' normal matrices, and characters of the
+// same asset next to each other. A
+// skinning pass then runs every vertex of every character through its
+// palette once, capturing world space positions and normals with transform
+// feedback, and every view draws those with a vertex shader that only looks
+// them up from gl_InstanceID and gl_VertexID. However many passes draw the
+// characters, they are skinned once a frame.
+class CharacterCrowd {
+public:
+    // what the crowd sets on the skinning shader
+    struct SkinningLocations {
+        GLint instanceData;       // samplerBuffer of the palettes
+        GLint firstInstanceTexel; // where the batch's first character starts
+        GLint jointCount;
+        GLint hasSkin;            // whether the primitive has joints and weights
+    };
+
+    // what the crowd sets on the character shader
+    struct ShaderLocations {
+        GLint viewProjectionMatrix;
+        GLint skinnedVertices;    // samplerBuffer of the skinned vertices
+        GLint firstSkinnedVertex; // where the primitive's first character starts
+        GLint vertexCount;
+        GLint materialDiffuse;
+        GLint materialSpecular;
+        GLint materialShininess;
+        GLint useTexture;
+        GLint materialTexture;
+    };
+
+    // what the skinning shader writes for every vertex, interleaved in this
+    // order
+    struct SkinnedVertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    // the texture units the palettes are bound to while skinning and the
+    // skinned vertices while drawing
+    static constexpr GLint PALETTE_TEXTURE_UNIT = 4;
+    static constexpr GLint SKINNED_VERTICES_TEXTURE_UNIT = 5;
+
+    // room for maxInstances characters of up to maxJoints joints each frame
+    CharacterCrowd(GLsizei maxInstances, GLsizei maxJoints);
+    ~CharacterCrowd();
+
+    CharacterCrowd(const CharacterCrowd&) = delete;
+    CharacterCrowd& operator=(const CharacterCrowd&) = delete;
+
+    // forgets last frame's characters and moves to the next region of the
+    // palette buffer
+    void beginFrame();
+
+    // queues a character for this frame, up to the crowd's capacity
+    void add(const Character& character);
+
+    // writes the queued characters' palettes, after the last add() and
+    // before skin()
+    void upload();
+
+    // skins every queued character with the bound skinning program, before
+    // the first draw() of the frame. Characters beyond what a texture buffer
+    // can hold are left out
+    void skin(GLuint shaderProgramHandle, const SkinningLocations& locations);
+
+    // draws every queued character with the bound shader program
+    void draw(GLuint shaderProgramHandle, const ShaderLocations& locations,
+              const glm::mat4& viewProjectionMtx) const;
+
+    // fences the palettes, after the last draw() of the frame
+    void endFrame();
+
+    GLsizei getInstanceCount() const { return _numInstances; }
+
+private:
+    // the characters of one asset, in the order their palettes are written
+    // and their vertices skinned
+    struct Batch {
+        const CharacterAsset* asset;
+        std::vector<const Character*> characters;
+        GLint firstTexel;
+        GLint firstSkinnedVertex;
+    };
+
+    StreamingBuffer* _paletteBuffer;
+    GLuint _paletteTexture;
+    GLsizei _maxInstances;
+    GLsizei _maxJoints;
+    // whether a character with more joints was turned away yet
+    bool _tooManyJoints;
+
+    // only written and read by the GPU, so one buffer does for every frame
+    GLuint _skinnedBuffer;
+    GLuint _skinnedTexture;
+    GLsizeiptr _skinnedCapacity;    // in vertices
+    GLsizeiptr _maxSkinnedVertices; // that the texture can reach
+
+    // batches are kept between frames so queuing does not allocate, only the
+    // first _numBatches are in use
+    std::vector<Batch> _batches;
+    size_t _numBatches;
+    GLsizei _numInstances;
+
+    // the texels of one batch's palettes
+    std::vector<glm::vec4> _staging;
+
+    void _allocateSkinned(GLsizeiptr vertexCapacity);
+};
+
+#endif // CHARACTER_CROWD_H
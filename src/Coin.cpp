@@ -1,4 +1,5 @@
 #include "Coin.h"
+#include "GLResources.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
@@ -36,22 +37,14 @@ void Coin::_initializeBuffers() {
         { glm::vec3(-0.5f,  0.5f, 0.0f), glm::vec2(0.0f, 0.0f) }
     };
 
-    glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
-
-    glGenBuffers(1, &_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    _vao = GLResources::createVertexArray();
+    _vbo = GLResources::createStaticBuffer(sizeof(vertices), vertices);
 
     // position (location 0)
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    GLResources::setVertexAttribute(_vao, 0, _vbo, 3, GL_FLOAT, sizeof(Vertex), 0);
 
     // texCoord (location 1)
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-
-    glBindVertexArray(0);
+    GLResources::setVertexAttribute(_vao, 1, _vbo, 2, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, texCoord));
 
     _buffersInitialized = true;
 }
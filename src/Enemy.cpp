@@ -1,4 +1,5 @@
 #include "Enemy.h"
+#include "GLResources.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
@@ -13,6 +14,7 @@ Enemy::Enemy(const glm::vec3& position, float heading)
       _moveSpeed(5.0f),
       _alive(true),
       _falling(false),
+      _heroVisible(true),
       _verticalVelocity(0.0f),
       _animPhase(0.0f)
 {
@@ -40,22 +42,14 @@ void Enemy::_initializeBuffers() {
         { glm::vec3(-0.5f,  0.5f, 0.0f), glm::vec2(0.0f, 0.0f) }
     };
 
-    glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
-
-    glGenBuffers(1, &_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    _vao = GLResources::createVertexArray();
+    _vbo = GLResources::createStaticBuffer(sizeof(vertices), vertices);
 
     // position (location 0)
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    GLResources::setVertexAttribute(_vao, 0, _vbo, 3, GL_FLOAT, sizeof(Vertex), 0);
 
     // texCoord (location 1)
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-
-    glBindVertexArray(0);
+    GLResources::setVertexAttribute(_vao, 1, _vbo, 2, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, texCoord));
 
     _buffersInitialized = true;
 }
@@ -82,7 +76,7 @@ void Enemy::update(float deltaTime, const glm::vec3& heroPosition, float turnSpe
     glm::vec3 toHero = heroPosition - _position;
     toHero.y = 0.0f; // Only turn in horizontal plane
 
-    if (glm::length(toHero) > 0.01f) {
+    if (_heroVisible && glm::length(toHero) > 0.01f) {
         glm::vec3 desiredHeading = glm::normalize(toHero);
 
         // angle between current heading and new heading
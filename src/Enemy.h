@@ -29,6 +29,8 @@ public:
     void setHeading(const glm::vec3& heading);
     void setAlive(bool alive) { _alive = alive; }
     void setFalling(bool falling) { _falling = falling; }
+    // enemies only turn towards a hero they can see, otherwise they keep going
+    void setHeroVisible(bool visible) { _heroVisible = visible; }
 
     void bounceOff(const glm::vec3& otherPosition);
 
@@ -41,6 +43,7 @@ private:
     float _moveSpeed;
     bool _alive;
     bool _falling;
+    bool _heroVisible;
     float _verticalVelocity;
     float _animPhase;
 
@@ -1,4 +1,5 @@
 #include "FPEngine.h"
+#include "GLResources.h"
 
 #include <CSCI441/objects.hpp>
 #include <stb_image.h>
@@ -6,21 +7,62 @@
 #include <glm/gtc/constants.hpp> // for glm::pi()
 #include <glm/gtc/type_ptr.hpp>  // for glm::value_ptr()
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// every light in the scene is static, so the same values feed the shader
+// uniforms and the lighting bake
+const glm::vec3 LIGHT_DIRECTION(-1.0f, 0.1f, -0.2f);
+const glm::vec3 LIGHT_COLOR(1.0f, 0.65f, 0.3f);
+const glm::vec3 POINT_LIGHT_POSITION(1.0f, 0.0f, 1.0f);
+const glm::vec3 POINT_LIGHT_COLOR(1.0f, 0.0f, 0.0f);
+const glm::vec3 SPOT_LIGHT_POSITION(1.0f, 7.0f, 1.0f);
+const glm::vec3 SPOT_LIGHT_DIRECTION =
+    glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f) - SPOT_LIGHT_POSITION);
+const glm::vec3 SPOT_LIGHT_COLOR(0.0f, 0.0f, 1.0f);
+const glm::vec3 AMBIENT_LIGHT_COLOR(0.71f, 0.54f, 0.7f);
+// ambient term used by ground.f.glsl before the bake
+const glm::vec3 GROUND_AMBIENT_COLOR(0.3f, 0.3f, 0.3f);
+// steady wind the grass leans into, gusts come and go on top of it
+const glm::vec2 WIND_DIRECTION = glm::normalize(glm::vec2(0.8f, 0.6f));
+const float WIND_STRENGTH = 0.35f;
+} // namespace
+
 //*************************************************************************************
 //
 // Public Interface
 
 FPEngine::FPEngine()
     : CSCI441::OpenGLEngine(4, 1, 640, 480, "FP: The Big Spooky"),
+      _renderGraph(nullptr), _frameCapture(nullptr), _capturingFrames(false),
+      _captureDirectory("captures"), _offlineFrameCount(0),
+      _randomSeed(static_cast<unsigned int>(time(nullptr))),
+      _heightmapHalfSize(0.0f), _heightmapHeightScale(0.0f),
+      _openWorld(false), _proceduralTerrain(false), _proceduralSeed(0),
+      _cacheGround(false), _enemyElsterCount(1),
       _mousePosition({MOUSE_UNINITIALIZED, MOUSE_UNINITIALIZED}),
       _leftMouseButtonState(GLFW_RELEASE), _cam(nullptr),
-      _cameraSpeed({0.0f, 0.0f}), _groundVAO(0), _numGroundPoints(0),
-      _lightingShaderProgram(nullptr),
-      _lightingShaderUniformLocations({-1, -1, -1, -1, -1}),
-      _lightingShaderAttributeLocations({-1, -1}), _pCharacter(nullptr),
+      _cameraSpeed({0.0f, 0.0f}), _pCharacter(nullptr),
       _characterMoveSpeed(10.0f), _characterTurnSpeed(2.0f),
       _characterVerticalVelocity(0.0f), _characterOnGround(true),
-      _characterDead(false), _particleSystem(nullptr), _coinsCollected(0) {
+      _characterDead(false), _particleSystem(nullptr), _coinsCollected(0),
+      _frameStreamBuffer(nullptr), _characterCrowd(nullptr),
+      _terrain(WORLD_SIZE, HILL_HEIGHT),
+      _groundVAO(0), _numGroundPoints(0), _groundDeformation(nullptr),
+      _grassField(nullptr), _windTime(0.0f), _groundCache(nullptr),
+      _terrainRaycaster(nullptr), _heightmap(nullptr), _cdlodTerrain(nullptr),
+      _worldStreamer(nullptr), _terrainNoise(nullptr),
+      _lightingShaderProgram(nullptr),
+      _lightingShaderUniformLocations({-1, -1, -1, -1, -1}),
+      _lightingShaderAttributeLocations({-1, -1}),
+      _elsterShaderProgram(nullptr), _elsterSkinShaderProgram(nullptr),
+      _groundCaptureShaderProgram(nullptr), _groundMeshShaderProgram(nullptr),
+      _particleShaderProgram(nullptr),
+      _cdlodShaderProgram(nullptr), _chunkShaderProgram(nullptr),
+      _grassShaderProgram(nullptr) {
 
   for (auto &_key : _keys)
     _key = GL_FALSE;
@@ -31,11 +73,19 @@ FPEngine::~FPEngine() {
   delete _firstPersonCam;
   delete _pCharacter;
     delete _pWilfred;
-  delete _pEnemyElster;
+  for (auto elster : _enemyElsters)
+    delete elster;
   delete _elsterShaderProgram;
+  delete _elsterSkinShaderProgram;
   delete _groundTessShaderProgram;
   delete _pSkybox;
   delete _spriteShaderProgram;
+  delete _particleShaderProgram;
+  delete _cdlodShaderProgram;
+  delete _chunkShaderProgram;
+  delete _grassShaderProgram;
+  delete _groundCaptureShaderProgram;
+  delete _groundMeshShaderProgram;
   delete _particleSystem;
 
   for (auto enemy : _enemies) {
@@ -64,16 +114,6 @@ void FPEngine::handleKeyEvent(const GLint KEY, const GLint ACTION) {
     case GLFW_KEY_R:
       mReloadShaders();
       _setLightingParameters();
-      // Update Character shader references after reload
-      _pCharacter->updateShaderReferences(
-        _elsterShaderProgram->getShaderProgramHandle(),
-        _elsterShaderUniformLocations.mvpMatrix,
-        _elsterShaderUniformLocations.normalMatrix,
-        _elsterShaderUniformLocations.modelMatrix,
-        _elsterShaderUniformLocations.materialDiffuse,
-        _elsterShaderUniformLocations.materialSpecular,
-        _elsterShaderUniformLocations.materialShininess
-      );
         _pWilfred = new Wilfred(_lightingShaderProgram->getShaderProgramHandle(),
               _lightingShaderUniformLocations.mvpMatrix,
               _lightingShaderUniformLocations.normalMatrix,
@@ -104,6 +144,18 @@ void FPEngine::handleKeyEvent(const GLint KEY, const GLint ACTION) {
       fprintf(stdout, "[INFO]: Main viewport switched to Free Camera\n");
       break;
 
+    case GLFW_KEY_C:
+      // toggle frame capture
+      if (_offlineFrameCount > 0)
+        break;
+      if (!_frameCapture) {
+        _frameCapture = new FrameCapture(_captureDirectory, false);
+      }
+      _capturingFrames = !_capturingFrames;
+      fprintf(stdout, "[INFO]: Frame capture %s\n",
+              _capturingFrames ? "started" : "stopped");
+      break;
+
     default:
       break; // suppress CLion warning
     }
@@ -116,6 +168,12 @@ void FPEngine::handleMouseButtonEvent(const GLint BUTTON, const GLint ACTION) {
     // update the left mouse button's state
     _leftMouseButtonState = ACTION;
   }
+
+  // right click pokes the ground under the cursor
+  if (BUTTON == GLFW_MOUSE_BUTTON_RIGHT && ACTION == GLFW_PRESS &&
+      _mousePosition.x != MOUSE_UNINITIALIZED) {
+    _pickTerrain(_mousePosition);
+  }
 }
 
 void FPEngine::handleCursorPositionEvent(const glm::vec2 currMousePosition) {
@@ -170,6 +228,11 @@ void FPEngine::mSetupGLFW() {
   glfwSetKeyCallback(mpWindow, mp_engine_keyboard_callback);
   glfwSetMouseButtonCallback(mpWindow, mp_engine_mouse_button_callback);
   glfwSetCursorPosCallback(mpWindow, mp_engine_cursor_callback);
+
+  // offline rendering runs as fast as it can
+  if (_offlineFrameCount > 0) {
+    glfwSwapInterval(0);
+  }
 }
 
 void FPEngine::mSetupOpenGL() {
@@ -211,6 +274,10 @@ void FPEngine::mSetupShaders() {
       _lightingShaderProgram->getUniformLocation("modelMatrix");
   _lightingShaderUniformLocations.cameraPosition =
       _lightingShaderProgram->getUniformLocation("cameraPosition");
+  _lightingShaderUniformLocations.useBakedLighting =
+      _lightingShaderProgram->getUniformLocation("useBakedLighting");
+  _lightingShaderUniformLocations.bakedColor =
+      _lightingShaderProgram->getUniformLocation("bakedColor");
 
   _lightingShaderAttributeLocations.vPos =
       _lightingShaderProgram->getAttributeLocation("vPos");
@@ -222,20 +289,8 @@ void FPEngine::mSetupShaders() {
                                                     "shaders/elster.f.glsl");
 
   // get uniform locations
-  _elsterShaderUniformLocations.mvpMatrix =
-      _elsterShaderProgram->getUniformLocation("mvpMatrix");
-  _elsterShaderUniformLocations.normalMatrix =
-      _elsterShaderProgram->getUniformLocation("normalMatrix");
-  _elsterShaderUniformLocations.modelMatrix =
-      _elsterShaderProgram->getUniformLocation("modelMatrix");
   _elsterShaderUniformLocations.viewMatrix =
       _elsterShaderProgram->getUniformLocation("viewMatrix");
-  _elsterShaderUniformLocations.materialDiffuse =
-      _elsterShaderProgram->getUniformLocation("materialDiffuse");
-  _elsterShaderUniformLocations.materialSpecular =
-      _elsterShaderProgram->getUniformLocation("materialSpecular");
-  _elsterShaderUniformLocations.materialShininess =
-      _elsterShaderProgram->getUniformLocation("materialShininess");
   _elsterShaderUniformLocations.lightDirection =
       _elsterShaderProgram->getUniformLocation("lightDirection");
   _elsterShaderUniformLocations.lightPosition =
@@ -254,20 +309,37 @@ void FPEngine::mSetupShaders() {
       _elsterShaderProgram->getUniformLocation("cameraPosition");
   _elsterShaderUniformLocations.ambientLight =
       _elsterShaderProgram->getUniformLocation("ambientLight");
-  _elsterShaderUniformLocations.useSkinning =
-      _elsterShaderProgram->getUniformLocation("useSkinning");
-  _elsterShaderUniformLocations.jointMatrices =
-      _elsterShaderProgram->getUniformLocation("jointMatrices");
-
-  // get attribute locations
-  _elsterShaderAttributeLocations.vPos =
-      _elsterShaderProgram->getAttributeLocation("vPos");
-  _elsterShaderAttributeLocations.vNormal =
-      _elsterShaderProgram->getAttributeLocation("vNormal");
-  _elsterShaderAttributeLocations.vJoints =
-      _elsterShaderProgram->getAttributeLocation("vJoints");
-  _elsterShaderAttributeLocations.vWeights =
-      _elsterShaderProgram->getAttributeLocation("vWeights");
+  _crowdShaderLocations.viewProjectionMatrix =
+      _elsterShaderProgram->getUniformLocation("viewProjectionMatrix");
+  _crowdShaderLocations.skinnedVertices =
+      _elsterShaderProgram->getUniformLocation("skinnedVertices");
+  _crowdShaderLocations.firstSkinnedVertex =
+      _elsterShaderProgram->getUniformLocation("firstSkinnedVertex");
+  _crowdShaderLocations.vertexCount =
+      _elsterShaderProgram->getUniformLocation("vertexCount");
+  _crowdShaderLocations.materialDiffuse =
+      _elsterShaderProgram->getUniformLocation("materialDiffuse");
+  _crowdShaderLocations.materialSpecular =
+      _elsterShaderProgram->getUniformLocation("materialSpecular");
+  _crowdShaderLocations.materialShininess =
+      _elsterShaderProgram->getUniformLocation("materialShininess");
+  _crowdShaderLocations.useTexture =
+      _elsterShaderProgram->getUniformLocation("useTexture");
+  _crowdShaderLocations.materialTexture =
+      _elsterShaderProgram->getUniformLocation("materialTexture");
+
+  // skins the characters once a frame for the elster shader to draw
+  _elsterSkinShaderProgram = new CSCI441::TransformFeedbackShaderProgram(
+      "shaders/elsterskin.v.glsl", "", "",
+      {"skinnedPosition", "skinnedNormal"});
+  _crowdSkinningLocations.instanceData =
+      _elsterSkinShaderProgram->getUniformLocation("instanceData");
+  _crowdSkinningLocations.firstInstanceTexel =
+      _elsterSkinShaderProgram->getUniformLocation("firstInstanceTexel");
+  _crowdSkinningLocations.jointCount =
+      _elsterSkinShaderProgram->getUniformLocation("jointCount");
+  _crowdSkinningLocations.hasSkin =
+      _elsterSkinShaderProgram->getUniformLocation("hasSkin");
 
   // load tess shader for ground
   _groundTessShaderProgram = new CSCI441::ShaderProgram(
@@ -283,10 +355,18 @@ void FPEngine::mSetupShaders() {
       _groundTessShaderProgram->getUniformLocation("normalMatrix");
   _groundTessShaderUniformLocations.groundTexture =
       _groundTessShaderProgram->getUniformLocation("groundTexture");
-  _groundTessShaderUniformLocations.tessLevel =
-      _groundTessShaderProgram->getUniformLocation("tessLevel");
-  _groundTessShaderUniformLocations.hillHeight =
-      _groundTessShaderProgram->getUniformLocation("hillHeight");
+  _groundTessShaderUniformLocations.lightmapTexture =
+      _groundTessShaderProgram->getUniformLocation("lightmapTexture");
+  _groundTessShaderUniformLocations.projectionScale =
+      _groundTessShaderProgram->getUniformLocation("projectionScale");
+  _groundTessShaderUniformLocations.controlPoints =
+      _groundTessShaderProgram->getUniformLocation("controlPoints");
+  _groundTessShaderUniformLocations.displacementTexture =
+      _groundTessShaderProgram->getUniformLocation("displacementTexture");
+  _groundTessShaderUniformLocations.displacementResolution =
+      _groundTessShaderProgram->getUniformLocation("displacementResolution");
+  _groundTessShaderUniformLocations.displacementMargin =
+      _groundTessShaderProgram->getUniformLocation("displacementMargin");
   _groundTessShaderUniformLocations.lightDirection =
       _groundTessShaderProgram->getUniformLocation("lightDirection");
   _groundTessShaderUniformLocations.lightColor =
@@ -312,6 +392,70 @@ void FPEngine::mSetupShaders() {
   _groundTessShaderAttributeLocations.vTexCoord =
       _groundTessShaderProgram->getAttributeLocation("vTexCoord");
 
+  // software renderers run tessellation shaders on the CPU, there the
+  // ground is always drawn from a capture
+  const auto renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+  if (!_cacheGround && renderer &&
+      (strstr(renderer, "llvmpipe") || strstr(renderer, "softpipe") ||
+       strstr(renderer, "SwiftShader"))) {
+    fprintf(stdout, "[INFO]: caching the tessellated ground on %s\n",
+            renderer);
+    _cacheGround = true;
+  }
+
+  // the same tess shaders capturing the ground instead of drawing it, and the
+  // ground's fragment shader for the captured triangles
+  if (_cacheGround) {
+    _groundCaptureShaderProgram = new CSCI441::TransformFeedbackShaderProgram(
+        "shaders/ground.v.glsl", "shaders/ground.tcs.glsl",
+        "shaders/ground.tes.glsl",
+        {"worldPos", "fragNormal", "fragTexCoord", "fragLightmapCoord"});
+    _groundCaptureShaderUniformLocations.mvpMatrix =
+        _groundCaptureShaderProgram->getUniformLocation("mvpMatrix");
+    _groundCaptureShaderUniformLocations.modelMatrix =
+        _groundCaptureShaderProgram->getUniformLocation("modelMatrix");
+    _groundCaptureShaderUniformLocations.normalMatrix =
+        _groundCaptureShaderProgram->getUniformLocation("normalMatrix");
+    _groundCaptureShaderUniformLocations.projectionScale =
+        _groundCaptureShaderProgram->getUniformLocation("projectionScale");
+    _groundCaptureShaderUniformLocations.controlPoints =
+        _groundCaptureShaderProgram->getUniformLocation("controlPoints");
+    _groundCaptureShaderUniformLocations.displacementTexture =
+        _groundCaptureShaderProgram->getUniformLocation("displacementTexture");
+    _groundCaptureShaderUniformLocations.displacementResolution =
+        _groundCaptureShaderProgram->getUniformLocation(
+            "displacementResolution");
+    _groundCaptureShaderUniformLocations.captureAll =
+        _groundCaptureShaderProgram->getUniformLocation("captureAll");
+    _groundCaptureShaderUniformLocations.lodOrigin =
+        _groundCaptureShaderProgram->getUniformLocation("lodOrigin");
+
+    _groundMeshShaderProgram = new CSCI441::ShaderProgram(
+        "shaders/groundmesh.v.glsl", "shaders/ground.f.glsl");
+    _groundMeshShaderUniformLocations.viewProjectionMatrix =
+        _groundMeshShaderProgram->getUniformLocation("viewProjectionMatrix");
+    _groundMeshShaderUniformLocations.groundTexture =
+        _groundMeshShaderProgram->getUniformLocation("groundTexture");
+    _groundMeshShaderUniformLocations.lightmapTexture =
+        _groundMeshShaderProgram->getUniformLocation("lightmapTexture");
+    _groundMeshShaderUniformLocations.lightDirection =
+        _groundMeshShaderProgram->getUniformLocation("lightDirection");
+    _groundMeshShaderUniformLocations.lightColor =
+        _groundMeshShaderProgram->getUniformLocation("lightColor");
+    _groundMeshShaderUniformLocations.lightPosition =
+        _groundMeshShaderProgram->getUniformLocation("lightPosition");
+    _groundMeshShaderUniformLocations.pointLightColor =
+        _groundMeshShaderProgram->getUniformLocation("pointLightColor");
+    _groundMeshShaderUniformLocations.spotLightPosition =
+        _groundMeshShaderProgram->getUniformLocation("spotLightPosition");
+    _groundMeshShaderUniformLocations.spotLightDirection =
+        _groundMeshShaderProgram->getUniformLocation("spotLightDirection");
+    _groundMeshShaderUniformLocations.spotLightColor =
+        _groundMeshShaderProgram->getUniformLocation("spotLightColor");
+    _groundMeshShaderUniformLocations.cameraPosition =
+        _groundMeshShaderProgram->getUniformLocation("cameraPosition");
+  }
+
   // load sprite shader for enemies, coins, and particles
   _spriteShaderProgram = new CSCI441::ShaderProgram("shaders/sprite.v.glsl",
                                                     "shaders/sprite.f.glsl");
@@ -321,6 +465,112 @@ void FPEngine::mSetupShaders() {
       _spriteShaderProgram->getUniformLocation("mvpMatrix");
   _spriteShaderUniformLocations.spriteTexture =
       _spriteShaderProgram->getUniformLocation("spriteTexture");
+
+  // particles share the sprite fragment shader but are drawn instanced
+  _particleShaderProgram = new CSCI441::ShaderProgram(
+      "shaders/particle.v.glsl", "shaders/sprite.f.glsl");
+  _particleShaderUniformLocations.viewProjectionMatrix =
+      _particleShaderProgram->getUniformLocation("viewProjectionMatrix");
+  _particleShaderUniformLocations.cameraRight =
+      _particleShaderProgram->getUniformLocation("cameraRight");
+  _particleShaderUniformLocations.cameraUp =
+      _particleShaderProgram->getUniformLocation("cameraUp");
+  _particleShaderUniformLocations.spriteTexture =
+      _particleShaderProgram->getUniformLocation("spriteTexture");
+
+  // heightmap terrain shares the ground's fragment shader
+  if (!_heightmapFilename.empty() || _proceduralTerrain) {
+    _cdlodShaderProgram = new CSCI441::ShaderProgram(
+        "shaders/cdlod.v.glsl", "shaders/ground.f.glsl");
+    _cdlodShaderUniformLocations.mvpMatrix =
+        _cdlodShaderProgram->getUniformLocation("mvpMatrix");
+    _cdlodShaderUniformLocations.heightmapTexture =
+        _cdlodShaderProgram->getUniformLocation("heightmapTexture");
+    _cdlodShaderUniformLocations.groundTexture =
+        _cdlodShaderProgram->getUniformLocation("groundTexture");
+    _cdlodShaderUniformLocations.lightmapTexture =
+        _cdlodShaderProgram->getUniformLocation("lightmapTexture");
+    _cdlodShaderUniformLocations.terrainMin =
+        _cdlodShaderProgram->getUniformLocation("terrainMin");
+    _cdlodShaderUniformLocations.terrainSize =
+        _cdlodShaderProgram->getUniformLocation("terrainSize");
+    _cdlodShaderUniformLocations.heightmapSize =
+        _cdlodShaderProgram->getUniformLocation("heightmapSize");
+    _cdlodShaderUniformLocations.quadrantResolution =
+        _cdlodShaderProgram->getUniformLocation("quadrantResolution");
+    _cdlodShaderUniformLocations.morphRanges =
+        _cdlodShaderProgram->getUniformLocation("morphRanges");
+    _cdlodShaderUniformLocations.textureScale =
+        _cdlodShaderProgram->getUniformLocation("textureScale");
+    _cdlodShaderUniformLocations.lightDirection =
+        _cdlodShaderProgram->getUniformLocation("lightDirection");
+    _cdlodShaderUniformLocations.lightColor =
+        _cdlodShaderProgram->getUniformLocation("lightColor");
+    _cdlodShaderUniformLocations.lightPosition =
+        _cdlodShaderProgram->getUniformLocation("lightPosition");
+    _cdlodShaderUniformLocations.pointLightColor =
+        _cdlodShaderProgram->getUniformLocation("pointLightColor");
+    _cdlodShaderUniformLocations.spotLightPosition =
+        _cdlodShaderProgram->getUniformLocation("spotLightPosition");
+    _cdlodShaderUniformLocations.spotLightDirection =
+        _cdlodShaderProgram->getUniformLocation("spotLightDirection");
+    _cdlodShaderUniformLocations.spotLightColor =
+        _cdlodShaderProgram->getUniformLocation("spotLightColor");
+    _cdlodShaderUniformLocations.cameraPosition =
+        _cdlodShaderProgram->getUniformLocation("cameraPosition");
+  }
+
+  // grass blades over the tessellated ground
+  _grassShaderProgram = new CSCI441::ShaderProgram("shaders/grass.v.glsl",
+                                                   "shaders/grass.f.glsl");
+  _grassShaderUniformLocations.viewProjectionMatrix =
+      _grassShaderProgram->getUniformLocation("viewProjectionMatrix");
+  _grassShaderUniformLocations.cameraPosition =
+      _grassShaderProgram->getUniformLocation("cameraPosition");
+  _grassShaderUniformLocations.time =
+      _grassShaderProgram->getUniformLocation("time");
+  _grassShaderUniformLocations.windDirection =
+      _grassShaderProgram->getUniformLocation("windDirection");
+  _grassShaderUniformLocations.windStrength =
+      _grassShaderProgram->getUniformLocation("windStrength");
+  _grassShaderUniformLocations.densityRange =
+      _grassShaderProgram->getUniformLocation("densityRange");
+  _grassShaderUniformLocations.groundMin =
+      _grassShaderProgram->getUniformLocation("groundMin");
+  _grassShaderUniformLocations.groundSize =
+      _grassShaderProgram->getUniformLocation("groundSize");
+  _grassShaderUniformLocations.lightmapTexture =
+      _grassShaderProgram->getUniformLocation("lightmapTexture");
+
+  // and so do the open world's chunks
+  if (_openWorld) {
+    _chunkShaderProgram = new CSCI441::ShaderProgram(
+        "shaders/chunk.v.glsl", "shaders/ground.f.glsl");
+    _chunkShaderUniformLocations.mvpMatrix =
+        _chunkShaderProgram->getUniformLocation("mvpMatrix");
+    _chunkShaderUniformLocations.groundTexture =
+        _chunkShaderProgram->getUniformLocation("groundTexture");
+    _chunkShaderUniformLocations.lightmapTexture =
+        _chunkShaderProgram->getUniformLocation("lightmapTexture");
+    _chunkShaderUniformLocations.textureScale =
+        _chunkShaderProgram->getUniformLocation("textureScale");
+    _chunkShaderUniformLocations.lightDirection =
+        _chunkShaderProgram->getUniformLocation("lightDirection");
+    _chunkShaderUniformLocations.lightColor =
+        _chunkShaderProgram->getUniformLocation("lightColor");
+    _chunkShaderUniformLocations.lightPosition =
+        _chunkShaderProgram->getUniformLocation("lightPosition");
+    _chunkShaderUniformLocations.pointLightColor =
+        _chunkShaderProgram->getUniformLocation("pointLightColor");
+    _chunkShaderUniformLocations.spotLightPosition =
+        _chunkShaderProgram->getUniformLocation("spotLightPosition");
+    _chunkShaderUniformLocations.spotLightDirection =
+        _chunkShaderProgram->getUniformLocation("spotLightDirection");
+    _chunkShaderUniformLocations.spotLightColor =
+        _chunkShaderProgram->getUniformLocation("spotLightColor");
+    _chunkShaderUniformLocations.cameraPosition =
+        _chunkShaderProgram->getUniformLocation("cameraPosition");
+  }
 }
 
 void FPEngine::mSetupTextures() {
@@ -341,8 +591,92 @@ void FPEngine::mSetupBuffers() {
       _lightingShaderAttributeLocations.vPos,
       _lightingShaderAttributeLocations.vNormal);
 
-  _createGroundBuffers();
+  // the heightmap replaces the Bezier hill everywhere once it loads
+  if (!_heightmapFilename.empty()) {
+    _heightmap = new Heightmap(_heightmapHalfSize);
+    if (_heightmap->loadFromFile(_heightmapFilename, _heightmapHeightScale)) {
+      // in the open world the heightmap is only the middle of the world and
+      // drawn by the chunks
+      if (!_openWorld)
+        _cdlodTerrain = new CDLODTerrain(*_heightmap);
+    } else {
+      fprintf(stderr, "[ERROR]: falling back to the default ground\n");
+      delete _heightmap;
+      _heightmap = nullptr;
+    }
+  } else if (_proceduralTerrain) {
+    FractalNoise::Parameters parameters;
+    parameters.height = _heightmapHeightScale;
+    _terrainNoise = new FractalNoise(_proceduralSeed, parameters);
+    // the open world samples the noise chunk by chunk, everywhere
+    if (!_openWorld) {
+      const auto start = std::chrono::steady_clock::now();
+      _heightmap = new Heightmap(_heightmapHalfSize);
+      _heightmap->generate(*_terrainNoise, PROCEDURAL_RESOLUTION);
+      const std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      fprintf(stdout,
+              "[INFO]: generated %dx%d terrain from seed %u in %.1f ms (%s)\n",
+              PROCEDURAL_RESOLUTION, PROCEDURAL_RESOLUTION, _proceduralSeed,
+              elapsed.count(), FractalNoise::getKernelName());
+      _cdlodTerrain = new CDLODTerrain(*_heightmap);
+    }
+  }
+
+  if (_openWorld) {
+    WorldStreamer::Generator generator;
+    generator.height = [this](const float x, const float z) {
+      return _openWorldHeight(x, z);
+    };
+    if (_terrainNoise) {
+      generator.heightTile = [this](const float x0, const float z0,
+                                    const float spacing, const int width,
+                                    const int depth, float *out) {
+        _terrainNoise->fill(x0, z0, spacing, width, depth, out);
+      };
+    }
+    generator.groundIrradiance = [](const glm::vec3 &position,
+                                    const glm::vec3 &normal) {
+      return _computeStaticIrradiance(position, normal, GROUND_AMBIENT_COLOR,
+                                      true);
+    };
+    generator.vegetationIrradiance = [](const glm::vec3 &position) {
+      return _computeStaticIrradiance(position, glm::vec3(0.0f, 1.0f, 0.0f),
+                                      AMBIENT_LIGHT_COLOR, false);
+    };
+    _worldStreamer = new WorldStreamer(generator, _randomSeed,
+                                       OPEN_WORLD_VIEW_DISTANCE,
+                                       _getTerrainHalfSize());
+    // offline frames must not depend on how fast the workers were
+    _worldStreamer->setSynchronous(_offlineFrameCount > 0);
+  }
+
+  // whatever the ground ended up being, rays can be cast against it
+  _terrainRaycaster = new TerrainRaycaster(
+      [this](const float *xs, const float *zs, float *outHeights,
+             const size_t count) {
+        _getTerrainHeights(xs, zs, outHeights, nullptr, count);
+      },
+      _getTerrainHalfSize(), TERRAIN_RAYCAST_RESOLUTION);
+
+  if (!_cdlodTerrain && !_worldStreamer) {
+    _createGroundBuffers();
+    if (_cacheGround)
+      _groundCache = new TessellationCache(GROUND_CACHE_VERTICES);
+    _grassField = new GrassField(
+        [this](const float *xs, const float *zs, float *outHeights,
+               const size_t count) {
+          _getTerrainHeights(xs, zs, outHeights, nullptr, count);
+        },
+        WORLD_SIZE, _randomSeed);
+  }
   _generateEnvironment();
+  _bakeStaticLighting();
+
+  _frameStreamBuffer = new StreamingBuffer(GL_ARRAY_BUFFER, FRAME_STREAM_SIZE);
+  _characterCrowd =
+      new CharacterCrowd(MAX_CROWD_CHARACTERS, MAX_CROWD_JOINTS);
+  _renderGraph = new RenderGraph();
 }
 
 void FPEngine::_createGroundBuffers() {
@@ -352,60 +686,82 @@ void FPEngine::_createGroundBuffers() {
     glm::vec2 texCoord;
   };
 
-  // asingle patch covering the world
-  // scale by WORLD_SIZE for proper coverage
-  const float size = WORLD_SIZE;
-  constexpr VertexNormalTextured groundPatch[4] = {
-      {{-1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
-      {{1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-      {{-1.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
-      {{1.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}}};
-
-  // scale positions to world size
-  VertexNormalTextured scaledPatch[4];
-  for (int i = 0; i < 4; i++) {
-    scaledPatch[i].position = groundPatch[i].position * size;
-    scaledPatch[i].vNormal = groundPatch[i].vNormal;
-    scaledPatch[i].texCoord = groundPatch[i].texCoord * 10.0f;
+  // a grid of patches covering the world, sharing their corners so
+  // neighbouring patches see the same edge and pick the same tessellation
+  // level for it. The corners sit on the surface so the TCS can cull and size
+  // patches from them, the TES only uses their x and z
+  constexpr int verticesPerSide = GROUND_PATCHES_PER_SIDE + 1;
+  const float patchSize = 2.0f * WORLD_SIZE / GROUND_PATCHES_PER_SIDE;
+  std::vector<VertexNormalTextured> vertices;
+  vertices.reserve(verticesPerSide * verticesPerSide);
+  for (int row = 0; row < verticesPerSide; row++) {
+    for (int col = 0; col < verticesPerSide; col++) {
+      const float x = -WORLD_SIZE + col * patchSize;
+      const float z = -WORLD_SIZE + row * patchSize;
+      VertexNormalTextured vertex;
+      vertex.position = glm::vec3(x, _terrain.height(x, z), z);
+      vertex.vNormal = _terrain.normal(x, z);
+      // the texture repeats 10 times across the world
+      vertex.texCoord = glm::vec2(static_cast<float>(col),
+                                  static_cast<float>(row)) *
+                        (10.0f / GROUND_PATCHES_PER_SIDE);
+      vertices.push_back(vertex);
+    }
   }
 
-  _numGroundPoints = 4;
+  // four corners per patch in the order the TES expects: (-x,-z), (+x,-z),
+  // (-x,+z), (+x,+z)
+  std::vector<GLushort> indices;
+  indices.reserve(4 * GROUND_PATCHES_PER_SIDE * GROUND_PATCHES_PER_SIDE);
+  for (int row = 0; row < GROUND_PATCHES_PER_SIDE; row++) {
+    for (int col = 0; col < GROUND_PATCHES_PER_SIDE; col++) {
+      const GLushort corner = row * verticesPerSide + col;
+      indices.push_back(corner);
+      indices.push_back(corner + 1);
+      indices.push_back(corner + verticesPerSide);
+      indices.push_back(corner + verticesPerSide + 1);
+    }
+  }
 
-  glGenVertexArrays(1, &_groundVAO);
-  glBindVertexArray(_groundVAO);
+  _numGroundPoints = static_cast<GLsizei>(indices.size());
 
-  GLuint vbo;
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(scaledPatch), scaledPatch,
-               GL_STATIC_DRAW);
+  _groundVAO = GLResources::createVertexArray();
+  const GLuint vbo = GLResources::createStaticBuffer(
+      vertices.size() * sizeof(VertexNormalTextured), vertices.data());
+  const GLuint ibo = GLResources::createStaticBuffer(
+      indices.size() * sizeof(GLushort), indices.data());
 
   // vertex attribs for tess shader
   // pos
-  glEnableVertexAttribArray(_groundTessShaderAttributeLocations.vPos);
-  glVertexAttribPointer(_groundTessShaderAttributeLocations.vPos, 3, GL_FLOAT,
-                        GL_FALSE, sizeof(VertexNormalTextured),
-                        (void *)offsetof(VertexNormalTextured, position));
+  GLResources::setVertexAttribute(
+      _groundVAO, _groundTessShaderAttributeLocations.vPos, vbo, 3, GL_FLOAT,
+      sizeof(VertexNormalTextured), offsetof(VertexNormalTextured, position));
 
   // norms
-  glEnableVertexAttribArray(_groundTessShaderAttributeLocations.vNormal);
-  glVertexAttribPointer(_groundTessShaderAttributeLocations.vNormal, 3,
-                        GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured),
-                        (void *)offsetof(VertexNormalTextured, vNormal));
+  GLResources::setVertexAttribute(
+      _groundVAO, _groundTessShaderAttributeLocations.vNormal, vbo, 3,
+      GL_FLOAT, sizeof(VertexNormalTextured),
+      offsetof(VertexNormalTextured, vNormal));
 
   // tex coords
-  glEnableVertexAttribArray(_groundTessShaderAttributeLocations.vTexCoord);
-  glVertexAttribPointer(_groundTessShaderAttributeLocations.vTexCoord, 2,
-                        GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured),
-                        (void *)offsetof(VertexNormalTextured, texCoord));
+  GLResources::setVertexAttribute(
+      _groundVAO, _groundTessShaderAttributeLocations.vTexCoord, vbo, 2,
+      GL_FLOAT, sizeof(VertexNormalTextured),
+      offsetof(VertexNormalTextured, texCoord));
+
+  GLResources::setElementBuffer(_groundVAO, ibo);
 
   // Set patch size for tess
   glPatchParameteri(GL_PATCH_VERTICES, 4);
 
+  // flat until gameplay digs into it
+  _groundDeformation =
+      new TerrainDeformation(WORLD_SIZE, GROUND_DEFORMATION_RESOLUTION);
+
   fprintf(stdout,
-          "[INFO]: ground tessellation patch created with VAO/VBO %d/%d & %d "
-          "control points\n",
-          _groundVAO, vbo, _numGroundPoints);
+          "[INFO]: ground tessellation grid created with VAO/VBO/IBO %d/%d/%d "
+          "& %d patches\n",
+          _groundVAO, vbo, ibo, _numGroundPoints / 4);
 }
 
 void FPEngine::mSetupScene() {
@@ -413,6 +769,15 @@ void FPEngine::mSetupScene() {
   _arcBallCam = new CSCI441::ArcballCam();
   _arcBallCam->setPosition(glm::vec3(0.0f, 40.0f, 30.0f));
   _arcBallCam->setLookAtPoint(glm::vec3(0.0f, 35.0f, 0.0f));
+  // and keep it out of the hill
+  _arcBallCam->setObstructionTest(
+      [this](const glm::vec3 &from, const glm::vec3 &to) {
+        if (!_terrainRaycaster)
+          return 1.0f;
+        const TerrainRaycaster::Hit hit =
+            _terrainRaycaster->raycast({from, to - from, 1.0f});
+        return hit.hit ? hit.distance : 1.0f;
+      });
   _arcBallCam->recomputeOrientation();
 
   // Create and position the free camera
@@ -436,13 +801,7 @@ void FPEngine::mSetupScene() {
 
   _pSkybox = new Skybox();
 
-  _pCharacter = new Character(_elsterShaderProgram->getShaderProgramHandle(),
-                              _elsterShaderUniformLocations.mvpMatrix,
-                              _elsterShaderUniformLocations.normalMatrix,
-                              _elsterShaderUniformLocations.modelMatrix,
-                              _elsterShaderUniformLocations.materialDiffuse,
-                              _elsterShaderUniformLocations.materialSpecular,
-                              _elsterShaderUniformLocations.materialShininess);
+  _pCharacter = new Character();
 
   if (!_pCharacter->loadFromFile("./assets/models/heroes/Elster/elster.glb")) {
     fprintf(stderr, "Failed to load character model\n");
@@ -450,7 +809,7 @@ void FPEngine::mSetupScene() {
 
   // Position character at center of mountain, slightly above terrain
   // The terrain height at (0, 0) is approximately 33.75 units (0.6 *
-  // hillHeight)
+  // HILL_HEIGHT)
   _pCharacter->setPosition(glm::vec3(0.0f, 36.0f, 0.0f));
 
     _pWilfred = new Wilfred(_lightingShaderProgram->getShaderProgramHandle(),
@@ -460,27 +819,28 @@ void FPEngine::mSetupScene() {
                           _lightingShaderUniformLocations.modelMatrix);
     _pWilfred->setPosition(glm::vec3(10.0f, 25.0f, 10.0f));
 
-  // enemy Elster
-  _pEnemyElster = new Character(_elsterShaderProgram->getShaderProgramHandle(),
-                                _elsterShaderUniformLocations.mvpMatrix,
-                                _elsterShaderUniformLocations.normalMatrix,
-                                _elsterShaderUniformLocations.modelMatrix,
-                                _elsterShaderUniformLocations.materialDiffuse,
-                                _elsterShaderUniformLocations.materialSpecular,
-                                _elsterShaderUniformLocations.materialShininess);
-
-  if (!_pEnemyElster->loadFromFile("./assets/models/heroes/Elster/elster.glb")) {
-    fprintf(stderr, "Failed to load enemy Elster model\n");
-  }
+  // enemy Elsters, the first at the old starting point and the rest on a
+  // grid stretching away from the mountain, all sharing one loaded asset
+  const float elsterStartX = -10.0f;
+  const float elsterStartZ = -10.0f;
+  const float elsterSpacing = 3.0f;
+  const int elsterRowLength = static_cast<int>(
+      std::ceil(std::sqrt(static_cast<float>(_enemyElsterCount))));
+  for (int i = 0; i < _enemyElsterCount; ++i) {
+    Character *elster = new Character();
+    if (!elster->loadFromFile("./assets/models/heroes/Elster/elster.glb")) {
+      fprintf(stderr, "Failed to load enemy Elster model\n");
+    }
 
-  // starting pos for enemy elster
-  float elsterStartX = -10.0f;
-  float elsterStartZ = -10.0f;
-  float elsterStartY = _getTerrainHeight(elsterStartX, elsterStartZ) + 1.0f;
-  _pEnemyElster->setPosition(glm::vec3(elsterStartX, elsterStartY, elsterStartZ));
+    // starting pos for enemy elster
+    const float x = elsterStartX - elsterSpacing * (i % elsterRowLength);
+    const float z = elsterStartZ - elsterSpacing * (i / elsterRowLength);
+    elster->setPosition(glm::vec3(x, _getTerrainHeight(x, z) + 1.0f, z));
 
-  // enemy elster to use walking animation
-  _pEnemyElster->playAnimation("elsterWalking");
+    // enemy elster to use walking animation
+    elster->playAnimation("elsterWalking");
+    _enemyElsters.push_back(elster);
+  }
 
   // Set lighting parameters
   _setLightingParameters();
@@ -497,14 +857,13 @@ void FPEngine::mSetupScene() {
 
 void FPEngine::_setLightingParameters() {
   // TODO #6: set lighting uniforms
-  const glm::vec3 lightPosition = glm::vec3(1.0f, 0.0f, 1.0f);
-  const glm::vec3 spotLightPosition = glm::vec3(1.0f, 7.0f, 1.0f);
-  const glm::vec3 spotLightDirection =
-      glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f) - spotLightPosition);
-  const glm::vec3 spotLightColor(0.0f, 0.0f, 1.0f);
-  const glm::vec3 pointLightColor(1.0f, 0.0f, 0.0f);
-  const glm::vec3 lightDirection(-1.0f, 0.1f, -0.2f);
-  const glm::vec3 lightColor(1, 0.65, 0.3);
+  const glm::vec3 &lightPosition = POINT_LIGHT_POSITION;
+  const glm::vec3 &spotLightPosition = SPOT_LIGHT_POSITION;
+  const glm::vec3 &spotLightDirection = SPOT_LIGHT_DIRECTION;
+  const glm::vec3 &spotLightColor = SPOT_LIGHT_COLOR;
+  const glm::vec3 &pointLightColor = POINT_LIGHT_COLOR;
+  const glm::vec3 &lightDirection = LIGHT_DIRECTION;
+  const glm::vec3 &lightColor = LIGHT_COLOR;
   _lightingShaderProgram->useProgram();
   _lightingShaderProgram->setProgramUniform(
       _lightingShaderUniformLocations.lightDirection, lightDirection);
@@ -521,7 +880,7 @@ void FPEngine::_setLightingParameters() {
   _lightingShaderProgram->setProgramUniform(
       _lightingShaderUniformLocations.pointLightColor, pointLightColor);
 
-  const glm::vec3 ambientLightColor = glm::vec3(0.71, 0.54, 0.7);
+  const glm::vec3 &ambientLightColor = AMBIENT_LIGHT_COLOR;
 
   _elsterShaderProgram->useProgram();
   _elsterShaderProgram->setProgramUniform(
@@ -557,6 +916,152 @@ void FPEngine::_setLightingParameters() {
       _groundTessShaderUniformLocations.spotLightColor, spotLightColor);
   _groundTessShaderProgram->setProgramUniform(
       _groundTessShaderUniformLocations.pointLightColor, pointLightColor);
+  _groundTessShaderProgram->setProgramUniform(
+      _groundTessShaderUniformLocations.groundTexture, 0);
+  _groundTessShaderProgram->setProgramUniform(
+      _groundTessShaderUniformLocations.lightmapTexture, 1);
+
+  // the surface shape is just as static, the shader evaluates the same
+  // control points the height queries use
+  _groundTessShaderProgram->setProgramUniform(
+      _groundTessShaderUniformLocations.controlPoints, 3,
+      Terrain::NUM_CONTROL_POINTS, &_terrain.getControlPoints()[0][0]);
+
+  // and the deformation on top of it, only its margin changes later
+  if (_groundDeformation) {
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.displacementTexture, 3);
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.displacementResolution,
+        static_cast<float>(_groundDeformation->getResolution()));
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.displacementMargin,
+        _groundDeformation->getMaxOffset());
+  }
+
+  // the captured ground is lit just like the tessellated one, and captured
+  // from the same surface
+  if (_groundMeshShaderProgram) {
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.lightDirection, lightDirection);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.lightColor, lightColor);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.lightPosition, lightPosition);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.spotLightPosition, spotLightPosition);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.spotLightDirection,
+        spotLightDirection);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.spotLightColor, spotLightColor);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.pointLightColor, pointLightColor);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.groundTexture, 0);
+    _groundMeshShaderProgram->setProgramUniform(
+        _groundMeshShaderUniformLocations.lightmapTexture, 1);
+  }
+  if (_groundCaptureShaderProgram) {
+    _groundCaptureShaderProgram->setProgramUniform(
+        _groundCaptureShaderUniformLocations.controlPoints, 3,
+        Terrain::NUM_CONTROL_POINTS, &_terrain.getControlPoints()[0][0]);
+    _groundCaptureShaderProgram->setProgramUniform(
+        _groundCaptureShaderUniformLocations.captureAll, 1);
+    if (_groundDeformation) {
+      _groundCaptureShaderProgram->setProgramUniform(
+          _groundCaptureShaderUniformLocations.displacementTexture, 3);
+      _groundCaptureShaderProgram->setProgramUniform(
+          _groundCaptureShaderUniformLocations.displacementResolution,
+          static_cast<float>(_groundDeformation->getResolution()));
+    }
+  }
+
+  // grass is lit by the ground's lightmap and swayed by a steady wind
+  _grassShaderProgram->setProgramUniform(
+      _grassShaderUniformLocations.lightmapTexture, 1);
+  _grassShaderProgram->setProgramUniform(
+      _grassShaderUniformLocations.windDirection, WIND_DIRECTION);
+  _grassShaderProgram->setProgramUniform(
+      _grassShaderUniformLocations.windStrength, WIND_STRENGTH);
+  _grassShaderProgram->setProgramUniform(
+      _grassShaderUniformLocations.densityRange,
+      glm::vec2(GrassField::FULL_DENSITY_DISTANCE,
+                GrassField::GRASS_DISTANCE));
+  _grassShaderProgram->setProgramUniform(
+      _grassShaderUniformLocations.groundMin, glm::vec2(-WORLD_SIZE));
+  _grassShaderProgram->setProgramUniform(
+      _grassShaderUniformLocations.groundSize, glm::vec2(2.0f * WORLD_SIZE));
+
+  // heightmap terrain, the same lights plus the map's static layout
+  if (_cdlodTerrain) {
+    _cdlodShaderProgram->useProgram();
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.lightDirection, lightDirection);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.lightColor, lightColor);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.lightPosition, lightPosition);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.spotLightPosition, spotLightPosition);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.spotLightDirection, spotLightDirection);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.spotLightColor, spotLightColor);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.pointLightColor, pointLightColor);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.groundTexture, 0);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.lightmapTexture, 1);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.heightmapTexture, 2);
+
+    const float halfSize = _heightmap->getHalfSize();
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.terrainMin, glm::vec2(-halfSize));
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.terrainSize, glm::vec2(2.0f * halfSize));
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.heightmapSize,
+        glm::vec2(_heightmap->getWidth(), _heightmap->getDepth()));
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.quadrantResolution,
+        static_cast<float>(CDLODTerrain::QUADRANT_RESOLUTION));
+    // the same texture density as the Bezier ground, 10 repeats over it
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.textureScale,
+        10.0f / (2.0f * WORLD_SIZE));
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.morphRanges, 2,
+        _cdlodTerrain->getLODCount(), &_cdlodTerrain->getMorphRanges()[0][0]);
+  }
+
+  // open world chunks, their irradiance textures take the lightmap's unit
+  if (_worldStreamer) {
+    _chunkShaderProgram->useProgram();
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.lightDirection, lightDirection);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.lightColor, lightColor);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.lightPosition, lightPosition);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.spotLightPosition, spotLightPosition);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.spotLightDirection, spotLightDirection);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.spotLightColor, spotLightColor);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.pointLightColor, pointLightColor);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.groundTexture, 0);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.lightmapTexture, 1);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.textureScale,
+        10.0f / (2.0f * WORLD_SIZE));
+  }
 }
 
 //*************************************************************************************
@@ -569,10 +1074,24 @@ void FPEngine::mCleanupShaders() {
   _lightingShaderProgram = nullptr;
   delete _elsterShaderProgram;
   _elsterShaderProgram = nullptr;
+  delete _elsterSkinShaderProgram;
+  _elsterSkinShaderProgram = nullptr;
   delete _groundTessShaderProgram;
   _groundTessShaderProgram = nullptr;
   delete _spriteShaderProgram;
   _spriteShaderProgram = nullptr;
+  delete _particleShaderProgram;
+  _particleShaderProgram = nullptr;
+  delete _cdlodShaderProgram;
+  _cdlodShaderProgram = nullptr;
+  delete _chunkShaderProgram;
+  _chunkShaderProgram = nullptr;
+  delete _grassShaderProgram;
+  _grassShaderProgram = nullptr;
+  delete _groundCaptureShaderProgram;
+  _groundCaptureShaderProgram = nullptr;
+  delete _groundMeshShaderProgram;
+  _groundMeshShaderProgram = nullptr;
 }
 
 void FPEngine::mCleanupBuffers() {
@@ -580,9 +1099,35 @@ void FPEngine::mCleanupBuffers() {
   CSCI441::deleteObjectVAOs();
   glDeleteVertexArrays(1, &_groundVAO);
   _groundVAO = 0;
+  delete _cdlodTerrain;
+  _cdlodTerrain = nullptr;
+  // joins the workers and returns the pooled buffers
+  delete _worldStreamer;
+  _worldStreamer = nullptr;
+  delete _heightmap;
+  _heightmap = nullptr;
+  delete _groundDeformation;
+  _groundDeformation = nullptr;
+  delete _grassField;
+  _grassField = nullptr;
+  delete _terrainRaycaster;
+  _terrainRaycaster = nullptr;
+  delete _groundCache;
+  _groundCache = nullptr;
+  delete _terrainNoise;
+  _terrainNoise = nullptr;
 
   fprintf(stdout, "[INFO]: ...deleting VBOs....\n");
   CSCI441::deleteObjectVBOs();
+  delete _frameStreamBuffer;
+  _frameStreamBuffer = nullptr;
+  delete _characterCrowd;
+  _characterCrowd = nullptr;
+  delete _renderGraph;
+  _renderGraph = nullptr;
+  // flushes any frames still in flight
+  delete _frameCapture;
+  _frameCapture = nullptr;
 
     delete _pWilfred;
 _pWilfred = nullptr;
@@ -602,22 +1147,23 @@ void FPEngine::mCleanupScene() {
 void FPEngine::_generateEnvironment() {
   //******************************************************************
   // parameters to make up our grid size and spacing, feel free to
-  // play around with this
-  constexpr GLfloat GRID_WIDTH = WORLD_SIZE * 2.0f;
-  constexpr GLfloat GRID_LENGTH = WORLD_SIZE * 2.0f;
+  // play around with this. The grid covers whatever ground was loaded
+  const GLfloat halfSize = _getTerrainHalfSize();
+  const GLfloat GRID_WIDTH = halfSize * 2.0f;
+  const GLfloat GRID_LENGTH = halfSize * 2.0f;
   constexpr GLfloat GRID_SPACING_WIDTH = 2.0f;
   constexpr GLfloat GRID_SPACING_LENGTH = 2.0f;
   // precomputed parameters based on above
-  constexpr GLfloat LEFT_END_POINT = -GRID_WIDTH / 2.0f + 4.0f;
-  constexpr GLfloat RIGHT_END_POINT = GRID_WIDTH / 2.0f - 2.0f;
-  constexpr GLfloat BOTTOM_END_POINT = -GRID_LENGTH / 2.0f + 4.0f;
-  constexpr GLfloat TOP_END_POINT = GRID_LENGTH / 2.0f - 2.0f;
+  const GLfloat LEFT_END_POINT = -GRID_WIDTH / 2.0f + 4.0f;
+  const GLfloat RIGHT_END_POINT = GRID_WIDTH / 2.0f - 2.0f;
+  const GLfloat BOTTOM_END_POINT = -GRID_LENGTH / 2.0f + 4.0f;
+  const GLfloat TOP_END_POINT = GRID_LENGTH / 2.0f - 2.0f;
   //******************************************************************
 
-  srand(time(0)); // seed our RNG
+  srand(_randomSeed); // seed our RNG
 
   // coin corner positions
-  const float coinOffset = WORLD_SIZE * 0.8f;
+  const float coinOffset = halfSize * 0.8f;
   const glm::vec2 coinCorners[4] = {
       glm::vec2(-coinOffset, -coinOffset), glm::vec2(coinOffset, -coinOffset),
       glm::vec2(-coinOffset, coinOffset), glm::vec2(coinOffset, coinOffset)};
@@ -709,66 +1255,193 @@ void FPEngine::_generateEnvironment() {
   }
 }
 
-void FPEngine::_renderScene(const glm::mat4 &viewMtx, const glm::mat4 &projMtx,
-                            const glm::vec3 &cameraPos) const {
-  _pSkybox->draw(viewMtx, projMtx);
+glm::vec3 FPEngine::_computeStaticIrradiance(const glm::vec3 &position,
+                                             const glm::vec3 &normal,
+                                             const glm::vec3 &ambient,
+                                             const bool includeDirectional) {
+  // mirrors the diffuse terms of ground.f.glsl and mp.v.glsl
+  glm::vec3 irradiance = ambient;
+
+  // DIRECTIONAL LIGHT
+  if (includeDirectional) {
+    const glm::vec3 lightVec = glm::normalize(LIGHT_DIRECTION);
+    irradiance += LIGHT_COLOR * glm::max(glm::dot(normal, lightVec), 0.0f);
+  }
 
-  // tess ground
-  _groundTessShaderProgram->useProgram();
+  // POINT LIGHT
+  const glm::vec3 posLightVec = glm::normalize(POINT_LIGHT_POSITION - position);
+  const float pointDistance = glm::length(POINT_LIGHT_POSITION - position);
+  const float pointAttenuation =
+      1.0f / (1.0f + 0.09f * pointDistance +
+              0.032f * (pointDistance * pointDistance));
+  irradiance += POINT_LIGHT_COLOR *
+                glm::max(glm::dot(normal, posLightVec), 0.0f) *
+                pointAttenuation;
+
+  // SPOTLIGHT
+  const glm::vec3 spotLightDir = glm::normalize(SPOT_LIGHT_POSITION - position);
+  const float innerCut = cosf(glm::radians(30.0f));
+  const float outerCut = cosf(glm::radians(35.0f));
+  const float theta =
+      glm::dot(spotLightDir, glm::normalize(-SPOT_LIGHT_DIRECTION));
+  const float intensity = glm::smoothstep(outerCut, innerCut, theta);
+  const float distance = glm::length(SPOT_LIGHT_POSITION - position);
+  const float attenuation =
+      1.0f / (1.0f + 0.09f * distance + 0.032f * (distance * distance));
+  irradiance += SPOT_LIGHT_COLOR *
+                glm::max(glm::dot(normal, spotLightDir), 0.0f) * intensity *
+                attenuation;
+
+  return irradiance;
+}
 
-  // transformation matrices
-  glm::mat4 groundModelMtx = glm::mat4(1.0f);
-  glm::mat4 mvpMtx = projMtx * viewMtx * groundModelMtx;
-  glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(groundModelMtx)));
+void FPEngine::_bakeStaticLighting() {
+  // ground lightmap - one texel per sample of the surface, covering the
+  // whole ground so the tessellation (or heightmap) coordinates can address
+  // it directly
+  std::vector<glm::vec3> lightmap(LIGHTMAP_SIZE * LIGHTMAP_SIZE);
+  const float halfSize = _getTerrainHalfSize();
+  const float texelSize = 2.0f * halfSize / LIGHTMAP_SIZE;
+
+  // one batched query per row of texels
+  std::vector<float> xs(LIGHTMAP_SIZE), zs(LIGHTMAP_SIZE), heights(LIGHTMAP_SIZE);
+  std::vector<glm::vec3> normals(LIGHTMAP_SIZE);
+  for (GLsizei col = 0; col < LIGHTMAP_SIZE; ++col) {
+    xs[col] = -halfSize + (col + 0.5f) * texelSize;
+  }
 
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.mvpMatrix, mvpMtx);
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.modelMatrix, groundModelMtx);
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.normalMatrix, normalMtx);
+  for (GLsizei row = 0; row < LIGHTMAP_SIZE; ++row) {
+    const float z = -halfSize + (row + 0.5f) * texelSize;
+    std::fill(zs.begin(), zs.end(), z);
+    _getTerrainHeights(xs.data(), zs.data(), heights.data(), normals.data(),
+                       LIGHTMAP_SIZE);
 
-  // tess parameters
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.tessLevel, 32.0f);
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.hillHeight, 56.25f);
+    for (GLsizei col = 0; col < LIGHTMAP_SIZE; ++col) {
+      const glm::vec3 position(xs[col], heights[col], z);
+      lightmap[row * LIGHTMAP_SIZE + col] = _computeStaticIrradiance(
+          position, normals[col], GROUND_AMBIENT_COLOR, true);
+    }
+  }
 
-  // Set lighting uniforms
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.lightDirection,
-      glm::vec3(-1.0f, 0.1f, -0.2f));
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.lightColor,
-      glm::vec3(1.0f, 0.65f, 0.3f));
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.lightPosition,
-      glm::vec3(1.0f, 0.0f, 1.0f));
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.pointLightColor,
-      glm::vec3(1.0f, 0.0f, 0.0f));
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.spotLightPosition,
-      glm::vec3(1.0f, 7.0f, 1.0f));
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.spotLightDirection,
-      glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f) -
-                     glm::vec3(1.0f, 7.0f, 1.0f)));
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.spotLightColor,
-      glm::vec3(0.0f, 0.0f, 1.0f));
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.cameraPosition, cameraPos);
+  // irradiance can exceed 1, so keep it in a float format
+  _texHandles[TEXTURE_ID::LIGHTMAP] = GLResources::createTexture2D(
+      LIGHTMAP_SIZE, LIGHTMAP_SIZE, GL_RGB16F, GL_RGB, GL_FLOAT,
+      lightmap.data(), GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE,
+      GL_CLAMP_TO_EDGE);
+
+  // bushes - the directional light varies over the sphere and stays per
+  // vertex, the attenuated point & spot lights are sampled at the top of
+  // the bush which is the part the cameras see
+  for (auto &bush : _bushes) {
+    const glm::vec3 top = bush.position + glm::vec3(0.0f, bush.size, 0.0f);
+    bush.bakedColor =
+        bush.color * _computeStaticIrradiance(top, glm::vec3(0.0f, 1.0f, 0.0f),
+                                              AMBIENT_LIGHT_COLOR, false);
+  }
 
-  // Bind ground texture
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GROUND]);
-  _groundTessShaderProgram->setProgramUniform(
-      _groundTessShaderUniformLocations.groundTexture, 0);
+  fprintf(stdout,
+          "[INFO]: baked static lighting into %dx%d lightmap with handle %d "
+          "and %zu bushes\n",
+          LIGHTMAP_SIZE, LIGHTMAP_SIZE, _texHandles[TEXTURE_ID::LIGHTMAP],
+          _bushes.size());
+}
 
-  // Draw ground patches
-  glBindVertexArray(_groundVAO);
-  glDrawArrays(GL_PATCHES, 0, _numGroundPoints);
+void FPEngine::_renderScene(const glm::mat4 &viewMtx, const glm::mat4 &projMtx,
+                            const glm::vec3 &cameraPos,
+                            GLsizei viewportHeight) const {
+  if (_worldStreamer) {
+    // open world ground
+    _chunkShaderProgram->useProgram();
+    const glm::mat4 viewProjMtx = projMtx * viewMtx;
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.mvpMatrix, viewProjMtx);
+    _chunkShaderProgram->setProgramUniform(
+        _chunkShaderUniformLocations.cameraPosition, cameraPos);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GROUND]);
+
+    _worldStreamer->drawTerrain(viewProjMtx);
+  } else if (_cdlodTerrain) {
+    // heightmap ground
+    _cdlodShaderProgram->useProgram();
+    const glm::mat4 viewProjMtx = projMtx * viewMtx;
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.mvpMatrix, viewProjMtx);
+    _cdlodShaderProgram->setProgramUniform(
+        _cdlodShaderUniformLocations.cameraPosition, cameraPos);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, _cdlodTerrain->getHeightmapTexture());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::LIGHTMAP]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GROUND]);
+
+    _cdlodTerrain->draw(viewProjMtx, cameraPos, *_frameStreamBuffer);
+  } else {
+    // tess ground
+    _groundTessShaderProgram->useProgram();
+
+    // transformation matrices
+    glm::mat4 groundModelMtx = glm::mat4(1.0f);
+    glm::mat4 mvpMtx = projMtx * viewMtx * groundModelMtx;
+    glm::mat3 normalMtx =
+        glm::transpose(glm::inverse(glm::mat3(groundModelMtx)));
+
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.mvpMatrix, mvpMtx);
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.modelMatrix, groundModelMtx);
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.normalMatrix, normalMtx);
+
+    // tess parameters, pixels covered by one unit at distance one so the TCS
+    // can size edges on screen
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.projectionScale,
+        projMtx[1][1] * 0.5f * static_cast<float>(viewportHeight));
+
+    // lights are static and set once in _setLightingParameters(), only the
+    // camera changes per view
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.cameraPosition, cameraPos);
+
+    // Bind ground texture, its baked lightmap and the deformation
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, _groundDeformation->getTexture());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::LIGHTMAP]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GROUND]);
+
+    if (_groundCache) {
+      // the triangles captured in _updateGroundCache(), no tessellation
+      _groundMeshShaderProgram->useProgram();
+      _groundMeshShaderProgram->setProgramUniform(
+          _groundMeshShaderUniformLocations.viewProjectionMatrix,
+          projMtx * viewMtx);
+      _groundMeshShaderProgram->setProgramUniform(
+          _groundMeshShaderUniformLocations.cameraPosition, cameraPos);
+      _groundCache->draw();
+    } else {
+      // Draw ground patches
+      glBindVertexArray(_groundVAO);
+      glDrawElements(GL_PATCHES, _numGroundPoints, GL_UNSIGNED_SHORT, nullptr);
+    }
+
+    // grass on top, still lit by the lightmap on unit 1
+    if (_grassField) {
+      _grassShaderProgram->useProgram();
+      _grassShaderProgram->setProgramUniform(
+          _grassShaderUniformLocations.viewProjectionMatrix, projMtx * viewMtx);
+      _grassShaderProgram->setProgramUniform(
+          _grassShaderUniformLocations.cameraPosition, cameraPos);
+      _grassShaderProgram->setProgramUniform(
+          _grassShaderUniformLocations.time, _windTime);
+      _grassField->draw(projMtx * viewMtx, cameraPos);
+    }
+  }
 
   // to character shader
   _elsterShaderProgram->useProgram();
@@ -777,52 +1450,30 @@ void FPEngine::_renderScene(const glm::mat4 &viewMtx, const glm::mat4 &projMtx,
   _elsterShaderProgram->setProgramUniform(
       _elsterShaderUniformLocations.cameraPosition, cameraPos);
 
-  // draw character (only if you didn't get murdered by goombas, or fell to your
-  // tragic death)
-  if (!_characterDead) {
-    glUniform1i(_elsterShaderUniformLocations.useSkinning, true);
-    _pCharacter->draw(glm::mat4(1.0f), viewMtx, projMtx);
-  }
-
-  // draw enemy Elster
-  glUniform1i(_elsterShaderUniformLocations.useSkinning, true);
-  _pEnemyElster->draw(glm::mat4(1.0f), viewMtx, projMtx);
+  // draw the character and the enemy Elsters, queued in _renderFrame()
+  _characterCrowd->draw(_elsterShaderProgram->getShaderProgramHandle(),
+                        _crowdShaderLocations, projMtx * viewMtx);
 
   // lighting shader
   _lightingShaderProgram->useProgram();
 
-  const glm::vec3 lightPosition = glm::vec3(1.0f, 0.0f, 1.0f);
-  const glm::vec3 spotLightPosition = glm::vec3(1.0f, 7.0f, 1.0f);
-  const glm::vec3 spotLightDirection =
-      glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f) - spotLightPosition);
-  const glm::vec3 spotLightColor(0.0f, 0.0f, 1.0f);
-  const glm::vec3 pointLightColor(1.0f, 0.0f, 0.0f);
-  const glm::vec3 lightDirection(-1.0f, 0.1f, -0.2f);
-  const glm::vec3 lightColor(1.0f, 0.65f, 0.3f);
-
-  _lightingShaderProgram->setProgramUniform(
-      _lightingShaderUniformLocations.lightDirection, lightDirection);
-  _lightingShaderProgram->setProgramUniform(
-      _lightingShaderUniformLocations.lightPosition, lightPosition);
-  _lightingShaderProgram->setProgramUniform(
-      _lightingShaderUniformLocations.spotLightPosition, spotLightPosition);
-  _lightingShaderProgram->setProgramUniform(
-      _lightingShaderUniformLocations.spotLightDirection, spotLightDirection);
-  _lightingShaderProgram->setProgramUniform(
-      _lightingShaderUniformLocations.lightColor, lightColor);
-  _lightingShaderProgram->setProgramUniform(
-      _lightingShaderUniformLocations.spotLightColor, spotLightColor);
-  _lightingShaderProgram->setProgramUniform(
-      _lightingShaderUniformLocations.pointLightColor, pointLightColor);
   _lightingShaderProgram->setProgramUniform(
       _lightingShaderUniformLocations.cameraPosition, cameraPos);
 
+  // Wilfred moves around, so he is fully lit every frame
+  _lightingShaderProgram->setProgramUniform(
+      _lightingShaderUniformLocations.useBakedLighting, 0);
+
     /// OLD MAN TIME
     glm::mat4 wilfredModelMtx(1.0f);
     _pWilfred->_animateBro(); // get this man an animation
     _pWilfred->drawWilfred(wilfredModelMtx, viewMtx, projMtx);
     /// OLD MAN NO MORE
 
+  // bushes only add the per-vertex directional light on top of their bake
+  _lightingShaderProgram->setProgramUniform(
+      _lightingShaderUniformLocations.useBakedLighting, 1);
+
   for (const auto& bush : _bushes) {
     glm::mat4 bushModelMtx = glm::translate(glm::mat4(1.0f), bush.position);
     bushModelMtx = glm::scale(bushModelMtx, glm::vec3(bush.size));
@@ -830,10 +1481,35 @@ void FPEngine::_renderScene(const glm::mat4 &viewMtx, const glm::mat4 &projMtx,
     _computeAndSendMatrixUniforms(bushModelMtx, viewMtx, projMtx);
     _lightingShaderProgram->setProgramUniform(
         _lightingShaderUniformLocations.materialColor, bush.color);
+    _lightingShaderProgram->setProgramUniform(
+        _lightingShaderUniformLocations.bakedColor, bush.bakedColor);
 
     CSCI441::drawSolidSphere(1.0f, 16, 16);
   }
 
+  // and the open world's, visible chunks only
+  if (_worldStreamer) {
+    _worldStreamer->forEachVisibleVegetation(
+        projMtx * viewMtx, [&](const WorldStreamer::VegetationInstance &bush) {
+          glm::mat4 bushModelMtx =
+              glm::translate(glm::mat4(1.0f), bush.position);
+          bushModelMtx = glm::scale(bushModelMtx, glm::vec3(bush.size));
+
+          _computeAndSendMatrixUniforms(bushModelMtx, viewMtx, projMtx);
+          _lightingShaderProgram->setProgramUniform(
+              _lightingShaderUniformLocations.materialColor, bush.color);
+          _lightingShaderProgram->setProgramUniform(
+              _lightingShaderUniformLocations.bakedColor, bush.bakedColor);
+
+          CSCI441::drawSolidSphere(1.0f, 16, 16);
+        });
+  }
+
+  // the sky goes after the opaque geometry so it only shades the pixels
+  // nothing else covered, which also means the color buffer never needs
+  // clearing
+  _pSkybox->draw(viewMtx, projMtx);
+
   // Draw enemies (only if they also didn't fall tragically to their deaths)
   for (auto enemy : _enemies) {
     if (enemy->isAlive()) {
@@ -855,21 +1531,44 @@ void FPEngine::_renderScene(const glm::mat4 &viewMtx, const glm::mat4 &projMtx,
   }
 
   // particles
-  _particleSystem->draw(_spriteShaderProgram->getShaderProgramHandle(),
-                        _spriteShaderUniformLocations.mvpMatrix,
-                        _spriteShaderUniformLocations.spriteTexture, viewMtx,
-                        projMtx, _texHandles[TEXTURE_ID::PARTICLE]);
+  _particleSystem->draw(_particleShaderProgram->getShaderProgramHandle(),
+                        _particleShaderUniformLocations.viewProjectionMatrix,
+                        _particleShaderUniformLocations.cameraRight,
+                        _particleShaderUniformLocations.cameraUp,
+                        _particleShaderUniformLocations.spriteTexture, viewMtx,
+                        projMtx, _texHandles[TEXTURE_ID::PARTICLE],
+                        *_frameStreamBuffer);
 }
 
-void FPEngine::_updateScene() {
-  // Calculate delta time for character animations
-  static float lastTime = 0.0f;
-  float currentTime = static_cast<float>(glfwGetTime());
-  float deltaTime = currentTime - lastTime;
-  lastTime = currentTime;
-
+void FPEngine::_updateScene(const float deltaTime) {
   bool moved = false;
 
+  // grow the grass around the player
+  _windTime += deltaTime;
+  if (_grassField)
+    _grassField->update(_pCharacter->getPosition());
+
+  // stream the open world around the player and populate the new chunks
+  if (_worldStreamer) {
+    _worldStreamer->update(_pCharacter->getPosition());
+    // enemies that died or whose chunk was evicted make room for new ones
+    for (auto enemy = _enemies.begin(); enemy != _enemies.end();) {
+      const glm::vec3 position = (*enemy)->getPosition();
+      if ((*enemy)->isAlive() &&
+          _worldStreamer->isInRange(position.x, position.z)) {
+        ++enemy;
+        continue;
+      }
+      delete *enemy;
+      enemy = _enemies.erase(enemy);
+    }
+    for (const auto &spawnPoint : _worldStreamer->getNewSpawnPoints()) {
+      if (_enemies.size() >= MAX_OPEN_WORLD_ENEMIES)
+        break;
+      _enemies.push_back(new Enemy(spawnPoint.position, spawnPoint.heading));
+    }
+  }
+
   // Handle free camera controls if active (only if player is alive)
   if (_cam == _freeCam && !_characterDead) {
     // Move forward/backward with space
@@ -1033,36 +1732,55 @@ void FPEngine::_updateScene() {
     glm::vec3 newwilfPos = _checkAndResolveCollisions(glm::vec3(wilfPos.x, _getTerrainHeight(wilfPos.x, wilfPos.z) + 1.0f, wilfPos.z), 0.5f);
     _pWilfred->setPosition(glm::vec3(newwilfPos.x, wilfPos.y, newwilfPos.z));
 
-  // update enemy elster
-  _pEnemyElster->update(deltaTime, _pCharacter->getPosition(), enemyTurnSpeed);
-  glm::vec3 elsterPos = _pEnemyElster->getPosition();
-  float elsterTerrainHeight = _getTerrainHeight(elsterPos.x, elsterPos.z) + 1.0f;
-  glm::vec3 newElsterPos = _checkAndResolveCollisions(glm::vec3(elsterPos.x, elsterTerrainHeight, elsterPos.z), 0.5f);
-  _pEnemyElster->setPosition(glm::vec3(newElsterPos.x, elsterTerrainHeight, newElsterPos.z));
+  // update enemy elsters
+  for (auto elster : _enemyElsters) {
+    elster->update(deltaTime, _pCharacter->getPosition(), enemyTurnSpeed);
+    glm::vec3 elsterPos = elster->getPosition();
+    float elsterTerrainHeight = _getTerrainHeight(elsterPos.x, elsterPos.z) + 1.0f;
+    glm::vec3 newElsterPos = _checkAndResolveCollisions(glm::vec3(elsterPos.x, elsterTerrainHeight, elsterPos.z), 0.5f);
+    elster->setPosition(glm::vec3(newElsterPos.x, elsterTerrainHeight, newElsterPos.z));
+  }
 
+  // enemies only chase the player while the terrain does not hide them, one
+  // batch of rays from every walking enemy's eyes to the player's
+  if (_terrainRaycaster) {
+    const glm::vec3 heroEyes =
+        _pCharacter->getPosition() + glm::vec3(0.0f, 1.0f, 0.0f);
+    _lineOfSightRays.clear();
+    for (auto enemy : _enemies) {
+      if (enemy->isAlive() && !enemy->isFalling()) {
+        const glm::vec3 eyes = enemy->getPosition() + glm::vec3(0.0f, 0.5f, 0.0f);
+        _lineOfSightRays.push_back({eyes, heroEyes - eyes, 1.0f});
+      }
+    }
+    _lineOfSightHits.resize(_lineOfSightRays.size());
+    _terrainRaycaster->raycast(_lineOfSightRays.data(),
+                               _lineOfSightHits.data(),
+                               _lineOfSightRays.size());
+    size_t ray = 0;
+    for (auto enemy : _enemies) {
+      if (enemy->isAlive() && !enemy->isFalling())
+        enemy->setHeroVisible(!_lineOfSightHits[ray++].hit);
+    }
+  }
+
+  // move the walking enemies first and then look up all of their terrain
+  // heights in one batch
+  _groundedEnemies.clear();
+  _enemyXs.clear();
+  _enemyZs.clear();
   for (auto enemy : _enemies) {
     if (enemy->isAlive() && !enemy->isFalling()) {
       enemy->update(deltaTime, _pCharacter->getPosition(), enemyTurnSpeed);
 
-      // Check if enemy has fallen off the world
-      glm::vec3 enemyPos = enemy->getPosition();
-
       // Apply collision detection with bushes
       const float ENEMY_RADIUS = enemy->getRadius();
-      enemyPos = _checkAndResolveCollisions(enemyPos, ENEMY_RADIUS);
-
-      float terrainHeight = _getTerrainHeight(enemyPos.x, enemyPos.z);
-
-      if (terrainHeight < -500.0f) {
-        // Enemy is off the edge, start falling and spawn particles
-        enemy->setFalling(true);
-        _particleSystem->spawnBurst(enemyPos, 15);
-        fprintf(stdout, "[INFO]: Enemy fell off the edge!\n");
-      } else if (!enemy->isFalling()) {
-        // Keep enemy on terrain
-        enemyPos.y = terrainHeight + 1.0f;
-        enemy->setPosition(enemyPos);
-      }
+      const glm::vec3 enemyPos =
+          _checkAndResolveCollisions(enemy->getPosition(), ENEMY_RADIUS);
+
+      _groundedEnemies.push_back(enemy);
+      _enemyXs.push_back(enemyPos.x);
+      _enemyZs.push_back(enemyPos.z);
     } else if (enemy->isFalling()) {
       // Update falling enemy
       enemy->update(deltaTime, _pCharacter->getPosition(), enemyTurnSpeed);
@@ -1075,6 +1793,46 @@ void FPEngine::_updateScene() {
     }
   }
 
+  _enemyHeights.resize(_groundedEnemies.size());
+  _getTerrainHeights(_enemyXs.data(), _enemyZs.data(), _enemyHeights.data(),
+                     nullptr, _groundedEnemies.size());
+
+  for (size_t i = 0; i < _groundedEnemies.size(); ++i) {
+    Enemy *enemy = _groundedEnemies[i];
+    const float terrainHeight = _enemyHeights[i];
+
+    // Check if enemy has fallen off the world
+    if (terrainHeight < -500.0f) {
+      // Enemy is off the edge, start falling and spawn particles
+      enemy->setFalling(true);
+      // and the ground gives way where it went over
+      if (_groundDeformation) {
+        const float halfSize = _getTerrainHalfSize();
+        const float craterX = glm::clamp(_enemyXs[i], -halfSize, halfSize);
+        const float craterZ = glm::clamp(_enemyZs[i], -halfSize, halfSize);
+        _groundDeformation->addCrater(craterX, craterZ, CRATER_RADIUS,
+                                      CRATER_DEPTH);
+        // the grass and the rays have to follow the new ground, rim included
+        if (_terrainRaycaster)
+          _terrainRaycaster->refresh(
+              craterX - 2.0f * CRATER_RADIUS, craterZ - 2.0f * CRATER_RADIUS,
+              craterX + 2.0f * CRATER_RADIUS, craterZ + 2.0f * CRATER_RADIUS);
+        if (_groundCache)
+          _groundCache->invalidate();
+        if (_grassField)
+          _grassField->invalidate(
+              craterX - 2.0f * CRATER_RADIUS, craterZ - 2.0f * CRATER_RADIUS,
+              craterX + 2.0f * CRATER_RADIUS, craterZ + 2.0f * CRATER_RADIUS);
+      }
+      _particleSystem->spawnBurst(enemy->getPosition(), 15);
+      fprintf(stdout, "[INFO]: Enemy fell off the edge!\n");
+    } else {
+      // Keep enemy on terrain
+      enemy->setPosition(
+          glm::vec3(_enemyXs[i], terrainHeight + 1.0f, _enemyZs[i]));
+    }
+  }
+
   // Update coins
   for (auto coin : _coins) {
     coin->update(deltaTime);
@@ -1108,14 +1866,18 @@ void FPEngine::run() {
   while (!glfwWindowShouldClose(
       mpWindow)) {         // check if the window was instructed to be closed
     glDrawBuffer(GL_BACK); // work with our back frame buffer
-    glClear(GL_COLOR_BUFFER_BIT |
-            GL_DEPTH_BUFFER_BIT); // clear the current color contents and depth
-                                  // buffer in the window
 
-    // Calculate delta time
+    // claim this frame's region of the streaming buffer
+    _frameStreamBuffer->beginFrame();
+    _characterCrowd->beginFrame();
+
+    // Calculate delta time, offline frames always advance by the same step
     float currentTime = static_cast<float>(glfwGetTime());
     float deltaTime = currentTime - lastTime;
     lastTime = currentTime;
+    if (_offlineFrameCount > 0) {
+      deltaTime = OFFLINE_TIME_STEP;
+    }
 
     // Get the size of our framebuffer.  Ideally this should be the same
     // dimensions as our window, but when using a Retina display the actual
@@ -1124,49 +1886,264 @@ void FPEngine::run() {
     GLint framebufferWidth, framebufferHeight;
     glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
 
-    float mainAspectRatio = static_cast<float>(framebufferWidth) /
-                            static_cast<float>(framebufferHeight);
-
-    // Create projection matrix for main viewport
-    glm::mat4 mainProjectionMatrix =
-        glm::perspective(45.0f, mainAspectRatio, 0.1f, 1000.0f);
-
-    // Render main camera view (full screen)
-    glViewport(0, 0, framebufferWidth, framebufferHeight);
-    _renderScene(_cam->getViewMatrix(), mainProjectionMatrix,
-                 _cam->getPosition());
+    // clears, targets and pass order are all handled by the render graph
+    _renderFrame(framebufferWidth, framebufferHeight);
 
-    // Clear depth buffer for PiP viewport
-    glClear(GL_DEPTH_BUFFER_BIT);
+    // both views have been submitted, the region can be fenced
+    _frameStreamBuffer->endFrame();
+    _characterCrowd->endFrame();
 
-    // Picture-in-picture viewport dimensions
-    GLint pipWidth = framebufferWidth / 4;
-    GLint pipHeight = framebufferHeight / 4;
-    GLint pipX = 10;
-    GLint pipY = 10;
-
-    float pipAspectRatio =
-        static_cast<float>(pipWidth) / static_cast<float>(pipHeight);
-    glm::mat4 pipProjectionMatrix =
-        glm::perspective(45.0f, pipAspectRatio, 0.1f, 1000.0f);
-
-    // render first person camera view
-    glViewport(pipX, pipY, pipWidth, pipHeight);
-    _renderScene(_firstPersonCam->getViewMatrix(), pipProjectionMatrix,
-                 _firstPersonCam->getPosition());
+    // hand any finished readbacks to the encoder
+    if (_frameCapture) {
+      _frameCapture->poll();
+    }
 
-    _updateScene();
+    _updateScene(deltaTime);
 
     glfwSwapBuffers(
         mpWindow); // flush the OpenGL commands and make sure they get rendered!
     glfwPollEvents(); // check for any events and signal to redraw screen
+
+    if (_offlineFrameCount > 0 && --_offlineFrameCount == 0) {
+      setWindowShouldClose();
+    }
   }
+
+  if (_frameCapture) {
+    _frameCapture->finish();
+  }
+}
+
+void FPEngine::setHeightmap(const std::string &filename, const float halfSize,
+                            const float heightScale) {
+  _heightmapFilename = filename;
+  _heightmapHalfSize = halfSize;
+  _heightmapHeightScale = heightScale;
+}
+
+void FPEngine::setOpenWorld(const bool enabled) { _openWorld = enabled; }
+
+void FPEngine::setCachedGround(const bool enabled) { _cacheGround = enabled; }
+
+void FPEngine::setEnemyElsters(const int count) {
+  _enemyElsterCount = std::max(1, std::min(count, MAX_CROWD_CHARACTERS - 1));
+}
+
+void FPEngine::setProceduralTerrain(const unsigned int seed,
+                                    const float halfSize,
+                                    const float heightScale) {
+  _proceduralTerrain = true;
+  _proceduralSeed = seed;
+  _heightmapHalfSize = halfSize;
+  _heightmapHeightScale = heightScale;
+}
+
+float FPEngine::_openWorldHeight(const float x, const float z) const {
+  if (_terrainNoise)
+    return _terrainNoise->sample(x, z);
+
+  const float halfSize = _getTerrainHalfSize();
+  const float edgeX = glm::clamp(x, -halfSize, halfSize);
+  const float edgeZ = glm::clamp(z, -halfSize, halfSize);
+  const float edgeHeight = _heightmap ? _heightmap->height(edgeX, edgeZ)
+                                      : _terrain.height(edgeX, edgeZ);
+  const float outside = glm::length(glm::vec2(x - edgeX, z - edgeZ));
+  return edgeHeight * std::exp(-outside / OPEN_WORLD_FALLOFF);
+}
+
+void FPEngine::setOfflineMode(const int numFrames,
+                              const std::string &outputDirectory) {
+  _offlineFrameCount = numFrames;
+  _captureDirectory = outputDirectory;
+  _randomSeed = OFFLINE_RANDOM_SEED;
+  _capturingFrames = numFrames > 0;
 }
 
 //*************************************************************************************
 //
 // Private Helper Functions
 
+glm::mat4 FPEngine::_getMainProjectionMatrix(const GLint framebufferWidth,
+                                            const GLint framebufferHeight) {
+  const float mainAspectRatio = static_cast<float>(framebufferWidth) /
+                                static_cast<float>(framebufferHeight);
+  return glm::perspective(45.0f, mainAspectRatio, 0.1f, 1000.0f);
+}
+
+void FPEngine::_pickTerrain(const glm::vec2 windowPosition) {
+  if (!_terrainRaycaster)
+    return;
+
+  GLint windowWidth, windowHeight, framebufferWidth, framebufferHeight;
+  glfwGetWindowSize(mpWindow, &windowWidth, &windowHeight);
+  glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+  if (windowWidth <= 0 || windowHeight <= 0 || framebufferHeight <= 0)
+    return;
+
+  // unproject the cursor onto the near and far planes, window y points down
+  const glm::vec2 ndc(2.0f * windowPosition.x / windowWidth - 1.0f,
+                      1.0f - 2.0f * windowPosition.y / windowHeight);
+  const glm::mat4 inverseViewProjection = glm::inverse(
+      _getMainProjectionMatrix(framebufferWidth, framebufferHeight) *
+      _cam->getViewMatrix());
+  glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+  glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+  nearPoint /= nearPoint.w;
+  farPoint /= farPoint.w;
+
+  const TerrainRaycaster::Hit hit = _terrainRaycaster->raycast(
+      {glm::vec3(nearPoint), glm::vec3(farPoint - nearPoint), 1.0f});
+  if (hit.hit) {
+    _particleSystem->spawnBurst(hit.position, 20);
+    fprintf(stdout, "[INFO]: picked the ground at (%.1f, %.1f, %.1f)\n",
+            hit.position.x, hit.position.y, hit.position.z);
+  }
+}
+
+void FPEngine::_updateGroundCache(const GLint framebufferHeight) {
+  // edges are sized for the main view, the picture in picture is smaller
+  // and gets at least as much detail as it needs
+  const glm::vec3 lodOrigin = _cam->getPosition();
+  const float projectionScale =
+      _getMainProjectionMatrix(1, 1)[1][1] * 0.5f *
+      static_cast<float>(framebufferHeight);
+  if (!_groundCache->isStale(lodOrigin, projectionScale))
+    return;
+
+  const glm::mat4 groundModelMtx(1.0f);
+  _groundCaptureShaderProgram->useProgram();
+  _groundCaptureShaderProgram->setProgramUniform(
+      _groundCaptureShaderUniformLocations.mvpMatrix, groundModelMtx);
+  _groundCaptureShaderProgram->setProgramUniform(
+      _groundCaptureShaderUniformLocations.modelMatrix, groundModelMtx);
+  _groundCaptureShaderProgram->setProgramUniform(
+      _groundCaptureShaderUniformLocations.normalMatrix,
+      glm::mat3(groundModelMtx));
+  _groundCaptureShaderProgram->setProgramUniform(
+      _groundCaptureShaderUniformLocations.projectionScale, projectionScale);
+  _groundCaptureShaderProgram->setProgramUniform(
+      _groundCaptureShaderUniformLocations.lodOrigin, lodOrigin);
+
+  glActiveTexture(GL_TEXTURE3);
+  glBindTexture(GL_TEXTURE_2D, _groundDeformation->getTexture());
+  glActiveTexture(GL_TEXTURE0);
+
+  _groundCache->capture(lodOrigin, projectionScale, [this]() {
+    glBindVertexArray(_groundVAO);
+    glDrawElements(GL_PATCHES, _numGroundPoints, GL_UNSIGNED_SHORT, nullptr);
+  });
+}
+
+void FPEngine::_renderFrame(const GLint framebufferWidth,
+                            const GLint framebufferHeight) {
+  // nothing to draw into while the window is minimized
+  if (framebufferWidth < 4 || framebufferHeight < 4)
+    return;
+
+  // send this tick's craters to the GPU, only the areas they touched
+  if (_groundDeformation) {
+    _groundDeformation->upload();
+    _groundTessShaderProgram->setProgramUniform(
+        _groundTessShaderUniformLocations.displacementMargin,
+        _groundDeformation->getMaxOffset());
+  }
+  if (_groundCache)
+    _updateGroundCache(framebufferHeight);
+
+  // the characters' palettes are written once and drawn in both views (only
+  // if you didn't get murdered by goombas, or fell to your tragic death)
+  if (!_characterDead)
+    _characterCrowd->add(*_pCharacter);
+  for (auto elster : _enemyElsters)
+    _characterCrowd->add(*elster);
+  _characterCrowd->upload();
+  _elsterSkinShaderProgram->useProgram();
+  _characterCrowd->skin(_elsterSkinShaderProgram->getShaderProgramHandle(),
+                        _crowdSkinningLocations);
+
+  _renderGraph->beginFrame();
+
+  const RenderGraph::Handle backbufferColor = _renderGraph->importBackbuffer(
+      "backbuffer color", {framebufferWidth, framebufferHeight, GL_RGBA8});
+  const RenderGraph::Handle backbufferDepth = _renderGraph->importBackbuffer(
+      "backbuffer depth",
+      {framebufferWidth, framebufferHeight, GL_DEPTH_COMPONENT24});
+
+  // Picture-in-picture viewport dimensions
+  const GLint pipWidth = framebufferWidth / 4;
+  const GLint pipHeight = framebufferHeight / 4;
+  const GLint pipX = 10;
+  const GLint pipY = 10;
+
+  const RenderGraph::Handle pipColor =
+      _renderGraph->createTexture("pip color", {pipWidth, pipHeight, GL_RGBA8});
+  const RenderGraph::Handle pipDepth = _renderGraph->createTexture(
+      "pip depth", {pipWidth, pipHeight, GL_DEPTH_COMPONENT24});
+
+  // Render main camera view (full screen), the skybox fills every pixel the
+  // scene leaves empty
+  _renderGraph
+      ->addPass("main view",
+                [=](const RenderGraph::PassContext &) {
+                  const glm::mat4 mainProjectionMatrix =
+                      _getMainProjectionMatrix(framebufferWidth,
+                                               framebufferHeight);
+                  _renderScene(_cam->getViewMatrix(), mainProjectionMatrix,
+                               _cam->getPosition(), framebufferHeight);
+                })
+      .writeColor(backbufferColor, true)
+      .writeDepth(backbufferDepth);
+
+  // render first person camera view into its own target
+  _renderGraph
+      ->addPass("first person view",
+                [=](const RenderGraph::PassContext &) {
+                  const float pipAspectRatio = static_cast<float>(pipWidth) /
+                                               static_cast<float>(pipHeight);
+                  const glm::mat4 pipProjectionMatrix =
+                      glm::perspective(45.0f, pipAspectRatio, 0.1f, 1000.0f);
+                  _renderScene(_firstPersonCam->getViewMatrix(),
+                               pipProjectionMatrix,
+                               _firstPersonCam->getPosition(), pipHeight);
+                })
+      .writeColor(pipColor, true)
+      .writeDepth(pipDepth);
+
+  // and copy it into the corner of the window
+  _renderGraph
+      ->addPass("picture in picture",
+                [=](const RenderGraph::PassContext &context) {
+                  glBindFramebuffer(GL_READ_FRAMEBUFFER,
+                                    context.framebuffer(pipColor));
+                  glBlitFramebuffer(0, 0, pipWidth, pipHeight, pipX, pipY,
+                                    pipX + pipWidth, pipY + pipHeight,
+                                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+                })
+      .read(pipColor)
+      .writeColor(backbufferColor);
+
+  // read the finished frame back, nothing reads this in the graph so it is
+  // kept alive as a side effect
+  if (_capturingFrames) {
+    if (!_frameCapture) {
+      // offline captures keep every frame
+      _frameCapture =
+          new FrameCapture(_captureDirectory, _offlineFrameCount > 0);
+    }
+    _renderGraph
+        ->addPass("frame capture",
+                  [=](const RenderGraph::PassContext &) {
+                    _frameCapture->capture(0, 0, framebufferWidth,
+                                           framebufferHeight);
+                  })
+        .read(backbufferColor)
+        .setSideEffect();
+  }
+
+  _renderGraph->execute();
+}
+
 void FPEngine::_computeAndSendMatrixUniforms(const glm::mat4 &modelMtx,
                                              const glm::mat4 &viewMtx,
                                              const glm::mat4 &projMtx) const {
@@ -1185,111 +2162,13 @@ void FPEngine::_computeAndSendMatrixUniforms(const glm::mat4 &modelMtx,
       _lightingShaderUniformLocations.modelMatrix, modelMtx);
 }
 
-float FPEngine::_getTerrainHeight(float x, float z) const {
-  // Check if position is within terrain bounds
-  if (x < -WORLD_SIZE || x > WORLD_SIZE || z < -WORLD_SIZE || z > WORLD_SIZE) {
-    return -1000.0f; // Return very low height if out of bounds (for falling)
-  }
-
-  // Convert world coordinates to normalized UV coordinates [0, 1]
-  float u = (x + WORLD_SIZE) / (2.0f * WORLD_SIZE);
-  float v = (z + WORLD_SIZE) / (2.0f * WORLD_SIZE);
-
-  // Clamp to [0, 1] just in case
-  u = glm::clamp(u, 0.0f, 1.0f);
-  v = glm::clamp(v, 0.0f, 1.0f);
-
-  // Hill height parameter (matching shader)
-  const float hillHeight = 56.25f;
-
-  // Corner positions of the patch (matching the ground buffer)
-  glm::vec3 p00(-WORLD_SIZE, 0.0f, -WORLD_SIZE);
-  glm::vec3 p10(WORLD_SIZE, 0.0f, -WORLD_SIZE);
-  glm::vec3 p01(-WORLD_SIZE, 0.0f, WORLD_SIZE);
-  glm::vec3 p11(WORLD_SIZE, 0.0f, WORLD_SIZE);
-
-  // Bezier blending functions (matching shader)
-  auto B0 = [](float t) { return (1.0f - t) * (1.0f - t) * (1.0f - t); };
-  auto B1 = [](float t) { return 3.0f * t * (1.0f - t) * (1.0f - t); };
-  auto B2 = [](float t) { return 3.0f * t * t * (1.0f - t); };
-  auto B3 = [](float t) { return t * t * t; };
-
-  // Get control point function (matching shader logic)
-  auto getControlPoint = [&](int i, int j) -> glm::vec3 {
-    // Row 0 (bottom edge - low height)
-    if (i == 0 && j == 0)
-      return p00;
-    if (i == 0 && j == 1)
-      return glm::mix(p00, p10, 0.333f) + glm::vec3(0, hillHeight * 0.1f, 0);
-    if (i == 0 && j == 2)
-      return glm::mix(p00, p10, 0.667f) + glm::vec3(0, hillHeight * 0.1f, 0);
-    if (i == 0 && j == 3)
-      return p10;
-
-    // Row 1 (first interior row - medium height)
-    if (i == 1 && j == 0)
-      return glm::mix(p00, p01, 0.333f) + glm::vec3(0, hillHeight * 0.1f, 0);
-    if (i == 1 && j == 1)
-      return glm::mix(glm::mix(p00, p10, 0.333f), glm::mix(p01, p11, 0.333f),
-                      0.333f) +
-             glm::vec3(0, hillHeight * 0.6f, 0);
-    if (i == 1 && j == 2)
-      return glm::mix(glm::mix(p00, p10, 0.667f), glm::mix(p01, p11, 0.667f),
-                      0.333f) +
-             glm::vec3(0, hillHeight * 0.6f, 0);
-    if (i == 1 && j == 3)
-      return glm::mix(p10, p11, 0.333f) + glm::vec3(0, hillHeight * 0.1f, 0);
-
-    // Row 2 (second interior row - medium height)
-    if (i == 2 && j == 0)
-      return glm::mix(p00, p01, 0.667f) + glm::vec3(0, hillHeight * 0.1f, 0);
-    if (i == 2 && j == 1)
-      return glm::mix(glm::mix(p00, p10, 0.333f), glm::mix(p01, p11, 0.333f),
-                      0.667f) +
-             glm::vec3(0, hillHeight * 0.6f, 0);
-    if (i == 2 && j == 2)
-      return glm::mix(glm::mix(p00, p10, 0.667f), glm::mix(p01, p11, 0.667f),
-                      0.667f) +
-             glm::vec3(0, hillHeight * 0.6f, 0);
-    if (i == 2 && j == 3)
-      return glm::mix(p10, p11, 0.667f) + glm::vec3(0, hillHeight * 0.1f, 0);
-
-    // Row 3 (top edge - low height)
-    if (i == 3 && j == 0)
-      return p01;
-    if (i == 3 && j == 1)
-      return glm::mix(p01, p11, 0.333f) + glm::vec3(0, hillHeight * 0.1f, 0);
-    if (i == 3 && j == 2)
-      return glm::mix(p01, p11, 0.667f) + glm::vec3(0, hillHeight * 0.1f, 0);
-    if (i == 3 && j == 3)
-      return p11;
-
-    return glm::vec3(0.0f);
-  };
-
-  // Compute position using bicubic Bezier interpolation
-  glm::vec3 pos(0.0f);
-  for (int i = 0; i < 4; i++) {
-    float bu = (i == 0) ? B0(u) : (i == 1) ? B1(u) : (i == 2) ? B2(u) : B3(u);
-    for (int j = 0; j < 4; j++) {
-      float bv = (j == 0) ? B0(v) : (j == 1) ? B1(v) : (j == 2) ? B2(v) : B3(v);
-      pos += getControlPoint(i, j) * bu * bv;
-    }
-  }
-
-  return pos.y;
-}
-
 glm::vec3 FPEngine::_checkAndResolveCollisions(const glm::vec3 &position,
                                                float characterRadius) const {
   glm::vec3 correctedPos = position;
   const float characterHeight = 1.0f;
 
-  // Check collision with bushes
-  for (const auto &bush : _bushes) {
-    glm::vec3 bushCenter = bush.position;
-    float bushRadius = bush.size;
-
+  // pushes the character out of one bush
+  auto resolve = [&](const glm::vec3 &bushCenter, const float bushRadius) {
     // Check vertical overlap first
     float bushBottom = bushCenter.y - bushRadius;
     float bushTop = bushCenter.y + bushRadius;
@@ -1315,6 +2194,18 @@ glm::vec3 FPEngine::_checkAndResolveCollisions(const glm::vec3 &position,
         correctedPos.z += correction.y;
       }
     }
+  };
+
+  // Check collision with bushes
+  for (const auto &bush : _bushes)
+    resolve(bush.position, bush.size);
+  // and with the streamed vegetation around, seen or not
+  if (_worldStreamer) {
+    _worldStreamer->forEachVegetationNear(
+        position.x, position.z, characterRadius,
+        [&](const WorldStreamer::VegetationInstance &bush) {
+          resolve(bush.position, bush.size);
+        });
   }
 
   return correctedPos;
@@ -1355,25 +2246,16 @@ GLuint FPEngine::_loadAndRegisterTexture(const char *FILENAME) {
 
   // if data was read from file
   if (data) {
-    const GLint STORAGE_TYPE = (imageChannels == 4 ? GL_RGBA : GL_RGB);
-
-    // TODO #01 - generate a texture handle
-    glGenTextures(1, &textureHandle);
-    // TODO #02 - bind it to be active
-    glBindTexture(GL_TEXTURE_2D, textureHandle);
-    // set texture parameters
-    // TODO #03 - mag filter
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // TODO #04 - min filter
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    // TODO #05 - wrap s
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    // TODO #06 - wrap t
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // TODO #07 - transfer image data to the GPU
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, STORAGE_TYPE, imageWidth, imageHeight, 0,
-                 STORAGE_TYPE, GL_UNSIGNED_BYTE, data);
+    const GLint STORAGE_CHANNELS = (imageChannels == 4 ? 4 : 3);
+    const GLenum STORAGE_TYPE = GLResources::pixelFormat(STORAGE_CHANNELS);
+
+    // generate the handle, set the linear/repeat parameters and transfer the
+    // image data to the GPU in one go
+    textureHandle = GLResources::createTexture2D(
+        imageWidth, imageHeight,
+        GLResources::sizedInternalFormat(STORAGE_CHANNELS, GL_UNSIGNED_BYTE),
+        STORAGE_TYPE, GL_UNSIGNED_BYTE, data, GL_LINEAR, GL_LINEAR, GL_REPEAT,
+        GL_REPEAT);
 
     fprintf(stdout, "[INFO]: %s texture map read in with handle %d\n", FILENAME,
             textureHandle);
@@ -1390,12 +2272,13 @@ GLuint FPEngine::_loadAndRegisterTexture(const char *FILENAME) {
 }
 
 void FPEngine::_spawnEnemies(int numEnemies) {
-  srand(time(0));
+  srand(_randomSeed);
+  const float halfSize = _getTerrainHalfSize();
 
   for (int i = 0; i < numEnemies; ++i) {
     // random position around the world
-    float x = (getRand() - 0.5f) * WORLD_SIZE * 1.5f;
-    float z = (getRand() - 0.5f) * WORLD_SIZE * 1.5f;
+    float x = (getRand() - 0.5f) * halfSize * 1.5f;
+    float z = (getRand() - 0.5f) * halfSize * 1.5f;
 
     // dont spawn too close to center
     if (abs(x) < 15.0f && abs(z) < 15.0f) {
@@ -1417,7 +2300,7 @@ void FPEngine::_spawnEnemies(int numEnemies) {
 
 void FPEngine::_spawnCoins() {
   // spawn 4 coins at the corners of the map
-  const float offset = WORLD_SIZE * 0.8f;
+  const float offset = _getTerrainHalfSize() * 0.8f;
 
   glm::vec3 corners[4] = {
       glm::vec3(-offset, 0.0f, -offset), // Bottom left
@@ -1493,19 +2376,21 @@ void FPEngine::_checkPlayerEnemyCollision() {
     return;
   }
 
-  // Check collision with enemy Elster
-  glm::vec3 elsterPos = _pEnemyElster->getPosition();
-  float elsterDistance = glm::length(
-      glm::vec2(playerPos.x - elsterPos.x, playerPos.z - elsterPos.z));
-  float elsterMinDistance = playerRadius + 0.5f; // Elster's radius
-  float elsterVerticalDistance = abs(playerPos.y - elsterPos.y);
+  // Check collision with the enemy Elsters
+  for (auto elster : _enemyElsters) {
+    glm::vec3 elsterPos = elster->getPosition();
+    float elsterDistance = glm::length(
+        glm::vec2(playerPos.x - elsterPos.x, playerPos.z - elsterPos.z));
+    float elsterMinDistance = playerRadius + 0.5f; // Elster's radius
+    float elsterVerticalDistance = abs(playerPos.y - elsterPos.y);
 
-  if (elsterDistance < elsterMinDistance && elsterVerticalDistance < maxVerticalDistance) {
-    _characterDead = true;
-    _particleSystem->spawnBurst(playerPos, 30);
-    fprintf(stdout, "[INFO]: Player hit by enemy Elster! Game Over!\n");
-    fprintf(stdout, "[INFO]: Coins collected: %d / 4\n", _coinsCollected);
-    return;
+    if (elsterDistance < elsterMinDistance && elsterVerticalDistance < maxVerticalDistance) {
+      _characterDead = true;
+      _particleSystem->spawnBurst(playerPos, 30);
+      fprintf(stdout, "[INFO]: Player hit by enemy Elster! Game Over!\n");
+      fprintf(stdout, "[INFO]: Coins collected: %d / 4\n", _coinsCollected);
+      return;
+    }
   }
 
   for (auto enemy : _enemies) {
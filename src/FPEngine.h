@@ -7,11 +7,25 @@
 #include <CSCI441/ShaderProgram.hpp>
 
 #include "ArcballCam.hpp"
+#include "CDLODTerrain.h"
 #include "Character.h"
+#include "CharacterCrowd.h"
 #include "Coin.h"
 #include "Enemy.h"
+#include "FractalNoise.h"
+#include "FrameCapture.h"
+#include "GrassField.h"
+#include "Heightmap.h"
 #include "ParticleSystem.h"
+#include "RenderGraph.h"
+#include "Terrain.h"
+#include "TerrainDeformation.h"
+#include "TerrainRaycaster.h"
+#include "TessellationCache.h"
+#include "TransformFeedbackShaderProgram.hpp"
+#include "StreamingBuffer.h"
 #include "Wilfred.h"
+#include "WorldStreamer.h"
 
 #include <vector>
 #include "Skybox.h"
@@ -25,6 +39,54 @@ public:
 
   void run() override;
 
+  /// \desc renders numFrames frames with a fixed time step and random seed as
+  /// fast as possible, writing every frame to outputDirectory, then quits
+  /// \note must be called before initialize()
+  /// \param numFrames length of the sequence to render
+  /// \param outputDirectory where the numbered PNGs are written
+  void setOfflineMode(int numFrames, const std::string &outputDirectory);
+
+  /// \desc replaces the Bezier hill with a heightmap image drawn through a
+  /// CDLOD quadtree, the player collides with the same heights
+  /// \note must be called before initialize()
+  /// \param filename grayscale image, white is the highest point
+  /// \param halfSize the map spans [-halfSize, halfSize] in x and z
+  /// \param heightScale height of a white pixel
+  void setHeightmap(const std::string &filename, float halfSize,
+                    float heightScale);
+
+  /// \desc surrounds the ground with an endless world streamed in chunks
+  /// around the player, instead of a drop to your death past its edge
+  /// \note must be called before initialize()
+  void setOpenWorld(bool enabled);
+
+  /// \desc replaces the Bezier hill with fractal noise terrain, a heightmap
+  /// generated at startup or, in the open world, noise sampled per chunk
+  /// \note must be called before initialize(), a heightmap image wins
+  /// \param seed the same seed always gives the same terrain
+  /// \param halfSize the generated heightmap spans [-halfSize, halfSize]
+  /// \param heightScale height of the highest possible point
+  void setProceduralTerrain(unsigned int seed, float halfSize,
+                            float heightScale);
+
+  /// \desc draws the tessellated ground from a transform feedback capture
+  /// that is only redone when the camera has moved far enough or the ground
+  /// changed, instead of tessellating it for every view of every frame
+  /// \note must be called before initialize(), software renderers always
+  /// cache
+  void setCachedGround(bool enabled);
+
+  /// \desc sets how many enemy Elsters chase the player, spread on a grid
+  /// around the first one's starting point
+  /// \note must be called before initialize()
+  /// \param count at least one, at most MAX_CROWD_CHARACTERS - 1
+  void setEnemyElsters(int count);
+
+  /// \desc simulated seconds per frame in offline mode
+  static constexpr GLfloat OFFLINE_TIME_STEP = 1.0f / 60.0f;
+  /// \desc seed for the world generation in offline mode
+  static constexpr unsigned int OFFLINE_RANDOM_SEED = 441;
+
   /// \desc handle any key events inside the engine
   /// \param KEY key as represented by GLFW_KEY_ macros
   /// \param ACTION key event action as represented by GLFW_ macros
@@ -59,10 +121,59 @@ private:
   /// \param viewMtx the current view matrix for our camera
   /// \param projMtx the current projection matrix for our camera
   //  param cameraPos: the position of the camera for lighting shenanigans
+  /// \param viewportHeight height in pixels of the target being drawn to
   void _renderScene(const glm::mat4 &viewMtx, const glm::mat4 &projMtx,
-                    const glm::vec3 &cameraPos) const;
+                    const glm::vec3 &cameraPos, GLsizei viewportHeight) const;
   /// \desc handles moving our camera as determined by keyboard input
-  void _updateScene();
+  /// \param deltaTime seconds since the last update
+  void _updateScene(float deltaTime);
+
+  /// \desc declares this frame's passes (main view, picture-in-picture and
+  /// its composite) in the render graph and runs it
+  /// \param framebufferWidth width of the window's framebuffer
+  /// \param framebufferHeight height of the window's framebuffer
+  void _renderFrame(GLint framebufferWidth, GLint framebufferHeight);
+
+  /// \desc projection of the main view
+  /// \param framebufferWidth width of the window's framebuffer
+  /// \param framebufferHeight height of the window's framebuffer
+  static glm::mat4 _getMainProjectionMatrix(GLint framebufferWidth,
+                                            GLint framebufferHeight);
+
+  /// \desc casts a ray through a window position in the main view and
+  /// bursts particles where it meets the terrain
+  /// \param windowPosition cursor position in window coordinates
+  void _pickTerrain(glm::vec2 windowPosition);
+
+  /// \desc schedules the passes of each frame and owns their render targets
+  RenderGraph *_renderGraph;
+
+  /// \desc asynchronous PNG capture of the window, created on first use
+  FrameCapture *_frameCapture;
+  /// \desc whether frames are currently being captured (C key)
+  bool _capturingFrames;
+  /// \desc where captured frames are written
+  std::string _captureDirectory;
+  /// \desc frames left to render in offline mode, 0 when running normally
+  int _offlineFrameCount;
+  /// \desc seed for the world generation, the current time unless offline
+  unsigned int _randomSeed;
+
+  /// \desc heightmap image to load instead of the Bezier hill, empty for the
+  /// hill
+  std::string _heightmapFilename;
+  GLfloat _heightmapHalfSize;
+  GLfloat _heightmapHeightScale;
+  /// \desc whether the world is streamed in chunks past the ground's edge
+  bool _openWorld;
+  /// \desc whether the terrain is generated from noise, sized by
+  /// _heightmapHalfSize and _heightmapHeightScale
+  bool _proceduralTerrain;
+  unsigned int _proceduralSeed;
+  /// \desc whether the tessellated ground is drawn through _groundCache
+  bool _cacheGround;
+  /// \desc how many enemy Elsters setupScene() creates
+  int _enemyElsterCount;
 
   /// \desc tracks the number of different keys that can be present as
   /// determined by GLFW
@@ -78,7 +189,7 @@ private:
   GLint _leftMouseButtonState;
 
   /// \desc total number of textures in our scene
-  static constexpr GLuint NUM_TEXTURES = 4;
+  static constexpr GLuint NUM_TEXTURES = 5;
   /// \desc used to index through our texture array to give named access
   enum TEXTURE_ID {
     /// \desc ground texture
@@ -89,6 +200,8 @@ private:
     COIN = 2,
     // particle texture
     PARTICLE = 3,
+    // baked diffuse lighting for the ground
+    LIGHTMAP = 4,
   };
   /// \desc texture handles for our textures
   GLuint _texHandles[NUM_TEXTURES] = {0};
@@ -105,7 +218,7 @@ private:
   // i have eliminated the other characters, it is only elster left...
   Character *_pCharacter;
     Wilfred *_pWilfred;
-  Character *_pEnemyElster;
+  std::vector<Character *> _enemyElsters;
   float _characterMoveSpeed;
   float _characterTurnSpeed;
   float _characterVerticalVelocity;
@@ -117,16 +230,90 @@ private:
   // game objects
   std::vector<Enemy *> _enemies;
   std::vector<Coin *> _coins;
+  /// \desc per-tick scratch for the batched enemy terrain queries
+  std::vector<Enemy *> _groundedEnemies;
+  std::vector<float> _enemyXs, _enemyZs, _enemyHeights;
   ParticleSystem *_particleSystem;
   int _coinsCollected;
 
+  /// \desc ring buffer for the data rewritten every frame (particle and
+  /// terrain node instances)
+  StreamingBuffer *_frameStreamBuffer;
+  /// \desc bytes the scene may stream during one frame, enough for a full
+  /// particle and terrain draw in both viewports
+  static constexpr GLsizeiptr FRAME_STREAM_SIZE =
+      2 * ParticleSystem::MAX_PARTICLES *
+          sizeof(ParticleSystem::ParticleInstance) +
+      2 * CDLODTerrain::MAX_INSTANCES *
+          sizeof(CDLODTerrain::QuadrantInstance) +
+      512;
+
+  /// \desc draws the player and the enemy Elsters, their joint palettes
+  /// written once a frame for both viewports
+  CharacterCrowd *_characterCrowd;
+  /// \desc most characters the crowd draws in one frame
+  static constexpr GLsizei MAX_CROWD_CHARACTERS = 512;
+  /// \desc most joints a crowd character may have
+  static constexpr GLsizei MAX_CROWD_JOINTS = 128;
+
   /// \desc the size of the world (controls the ground size and locations of
   /// buildings)
   static constexpr GLfloat WORLD_SIZE = 110.0f;
+  /// \desc height scale of the Bezier ground's control points
+  static constexpr GLfloat HILL_HEIGHT = 56.25f;
+  /// \desc height queries against the ground surface
+  Terrain _terrain;
   /// \desc VAO for our ground
   GLuint _groundVAO;
-  /// \desc the number of points that make up our ground object
+  /// \desc the number of patch corner indices that make up our ground object
   GLsizei _numGroundPoints;
+  /// \desc the ground is split into this many patches along x and along z
+  static constexpr int GROUND_PATCHES_PER_SIDE = 16;
+  /// \desc gameplay dents in the tessellated ground, nullptr when the ground
+  /// is a heightmap or the open world
+  TerrainDeformation *_groundDeformation;
+  /// \desc samples along each side of _groundDeformation
+  static constexpr int GROUND_DEFORMATION_RESOLUTION = 257;
+  /// \desc crater left where an enemy tumbles off the ground
+  static constexpr GLfloat CRATER_RADIUS = 4.0f;
+  static constexpr GLfloat CRATER_DEPTH = 1.5f;
+  /// \desc grass growing on the tessellated ground, nullptr on the other
+  /// grounds
+  GrassField *_grassField;
+  /// \desc seconds of wind animation, advanced with the simulation
+  GLfloat _windTime;
+  /// \desc the tessellated ground captured as triangles, nullptr unless
+  /// caching
+  TessellationCache *_groundCache;
+  /// \desc vertices the ground cache starts out with room for
+  static constexpr GLsizeiptr GROUND_CACHE_VERTICES = 1 << 18;
+  /// \desc ray casts against the ground for picking, camera collision and
+  /// line of sight
+  TerrainRaycaster *_terrainRaycaster;
+  /// \desc samples along each side of the raycaster's grid
+  static constexpr int TERRAIN_RAYCAST_RESOLUTION = 513;
+  /// \desc per-tick scratch for the batched enemy line of sight rays
+  std::vector<TerrainRaycaster::Ray> _lineOfSightRays;
+  std::vector<TerrainRaycaster::Hit> _lineOfSightHits;
+  /// \desc heightmap replacing _terrain when one was given, nullptr otherwise
+  Heightmap *_heightmap;
+  /// \desc draws _heightmap, nullptr without one
+  CDLODTerrain *_cdlodTerrain;
+  /// \desc the open world's chunks, nullptr unless open world mode is on
+  WorldStreamer *_worldStreamer;
+  /// \desc procedural terrain heights, nullptr unless procedural terrain is
+  /// on. Fills _heightmap, or the chunks in the open world
+  FractalNoise *_terrainNoise;
+  /// \desc samples along each side of the generated heightmap, one more than
+  /// a power of two so CDLOD leaves line up with samples
+  static constexpr int PROCEDURAL_RESOLUTION = 2049;
+  /// \desc chunks kept loaded around the player in each direction
+  static constexpr int OPEN_WORLD_VIEW_DISTANCE = 4;
+  /// \desc distance over which the ground's edge flattens out into the
+  /// open world
+  static constexpr GLfloat OPEN_WORLD_FALLOFF = 40.0f;
+  /// \desc enemies spawned from open world chunks stop past this many
+  static constexpr size_t MAX_OPEN_WORLD_ENEMIES = 40;
 
   /// \desc smart container to store information specific to each tree we wish
   /// to draw
@@ -146,12 +333,32 @@ private:
     glm::vec3 position;
     glm::vec3 color;
     GLfloat size;
+    /// \desc ambient + point/spot light contribution, baked once since
+    /// neither the bush nor the lights ever move
+    glm::vec3 bakedColor;
   };
   std::vector<BushData> _bushes;
 
+  /// \desc number of texels along each side of the ground lightmap
+  static constexpr GLsizei LIGHTMAP_SIZE = 128;
+
   /// \desc generates tree information to make up our scene
   void _generateEnvironment();
 
+  /// \desc precomputes the diffuse lighting of the static scene: a lightmap
+  /// texture for the ground and a lit color for each bush
+  void _bakeStaticLighting();
+
+  /// \desc evaluates the diffuse irradiance of all three static lights
+  /// \param position world space position of the surface
+  /// \param normal world space surface normal
+  /// \param ambient ambient light to add to the result
+  /// \param includeDirectional whether the directional light is included
+  static glm::vec3 _computeStaticIrradiance(const glm::vec3 &position,
+                                            const glm::vec3 &normal,
+                                            const glm::vec3 &ambient,
+                                            bool includeDirectional);
+
   /// \desc loads an image into CPU memory and registers it with the GPU
   /// \note sets the texture parameters and sends the data to the GPU
   /// \param FILENAME external image filename to load
@@ -180,6 +387,10 @@ private:
     GLint normalMatrix;
     GLint modelMatrix;
     GLint cameraPosition;
+    /// \desc toggles the baked vegetation lighting path
+    GLint useBakedLighting;
+    /// \desc baked per-instance lit color location
+    GLint bakedColor;
   } _lightingShaderUniformLocations;
   /// \desc stores the locations of all of our shader attributes
   struct LightingShaderAttributeLocations {
@@ -193,13 +404,7 @@ private:
   // Shaders for elster
   CSCI441::ShaderProgram *_elsterShaderProgram;
   struct ElsterShaderUniformLocations {
-    GLint mvpMatrix;
-    GLint normalMatrix;
-    GLint modelMatrix;
     GLint viewMatrix;
-    GLint materialDiffuse;
-    GLint materialSpecular;
-    GLint materialShininess;
     GLint lightDirection;
     GLint lightPosition;
     GLint pointLightColor;
@@ -209,16 +414,14 @@ private:
     GLint lightColor;
     GLint cameraPosition;
     GLint ambientLight;
-    GLint useSkinning;
-    GLint jointMatrices;
   } _elsterShaderUniformLocations;
+  /// \desc the elster shader uniforms CharacterCrowd sets
+  CharacterCrowd::ShaderLocations _crowdShaderLocations;
 
-  struct ElsterShaderAttributeLocations {
-    GLint vPos;
-    GLint vNormal;
-    GLint vJoints;
-    GLint vWeights;
-  } _elsterShaderAttributeLocations;
+  /// \desc skins the characters into CharacterCrowd's vertices once a frame,
+  /// every view then draws them with the elster shader
+  CSCI441::TransformFeedbackShaderProgram *_elsterSkinShaderProgram;
+  CharacterCrowd::SkinningLocations _crowdSkinningLocations;
 
   // tess shaders for ground
   CSCI441::ShaderProgram *_groundTessShaderProgram;
@@ -227,8 +430,12 @@ private:
     GLint modelMatrix;
     GLint normalMatrix;
     GLint groundTexture;
-    GLint tessLevel;
-    GLint hillHeight;
+    GLint lightmapTexture;
+    GLint projectionScale;
+    GLint controlPoints;
+    GLint displacementTexture;
+    GLint displacementResolution;
+    GLint displacementMargin;
     GLint lightDirection;
     GLint lightColor;
     GLint lightPosition;
@@ -245,6 +452,37 @@ private:
     GLint vTexCoord;
   } _groundTessShaderAttributeLocations;
 
+  /// \desc the ground tess shaders without a fragment shader, capturing the
+  /// tessellated ground into _groundCache. Only created when caching
+  CSCI441::TransformFeedbackShaderProgram *_groundCaptureShaderProgram;
+  struct GroundCaptureShaderUniformLocations {
+    GLint mvpMatrix;
+    GLint modelMatrix;
+    GLint normalMatrix;
+    GLint projectionScale;
+    GLint controlPoints;
+    GLint displacementTexture;
+    GLint displacementResolution;
+    GLint captureAll;
+    GLint lodOrigin;
+  } _groundCaptureShaderUniformLocations;
+
+  /// \desc draws the captured ground with the ground's fragment shader
+  CSCI441::ShaderProgram *_groundMeshShaderProgram;
+  struct GroundMeshShaderUniformLocations {
+    GLint viewProjectionMatrix;
+    GLint groundTexture;
+    GLint lightmapTexture;
+    GLint lightDirection;
+    GLint lightColor;
+    GLint lightPosition;
+    GLint pointLightColor;
+    GLint spotLightPosition;
+    GLint spotLightDirection;
+    GLint spotLightColor;
+    GLint cameraPosition;
+  } _groundMeshShaderUniformLocations;
+
   // sprite shader for enemies, coins, and particles
   CSCI441::ShaderProgram *_spriteShaderProgram;
   struct SpriteShaderUniformLocations {
@@ -252,9 +490,77 @@ private:
     GLint spriteTexture;
   } _spriteShaderUniformLocations;
 
+  /// \desc instanced billboard shader for particles
+  CSCI441::ShaderProgram *_particleShaderProgram;
+  struct ParticleShaderUniformLocations {
+    GLint viewProjectionMatrix;
+    GLint cameraRight;
+    GLint cameraUp;
+    GLint spriteTexture;
+  } _particleShaderUniformLocations;
+
+  /// \desc heightmap terrain shader, only created with a heightmap
+  CSCI441::ShaderProgram *_cdlodShaderProgram;
+  struct CDLODShaderUniformLocations {
+    GLint mvpMatrix;
+    GLint heightmapTexture;
+    GLint groundTexture;
+    GLint lightmapTexture;
+    GLint terrainMin;
+    GLint terrainSize;
+    GLint heightmapSize;
+    GLint quadrantResolution;
+    GLint morphRanges;
+    GLint textureScale;
+    GLint lightDirection;
+    GLint lightColor;
+    GLint lightPosition;
+    GLint pointLightColor;
+    GLint spotLightPosition;
+    GLint spotLightDirection;
+    GLint spotLightColor;
+    GLint cameraPosition;
+  } _cdlodShaderUniformLocations;
+
+  /// \desc open world chunk shader, only created in open world mode
+  CSCI441::ShaderProgram *_chunkShaderProgram;
+  struct ChunkShaderUniformLocations {
+    GLint mvpMatrix;
+    GLint groundTexture;
+    GLint lightmapTexture;
+    GLint textureScale;
+    GLint lightDirection;
+    GLint lightColor;
+    GLint lightPosition;
+    GLint pointLightColor;
+    GLint spotLightPosition;
+    GLint spotLightDirection;
+    GLint spotLightColor;
+    GLint cameraPosition;
+  } _chunkShaderUniformLocations;
+
+  /// \desc instanced grass blade shader
+  CSCI441::ShaderProgram *_grassShaderProgram;
+  struct GrassShaderUniformLocations {
+    GLint viewProjectionMatrix;
+    GLint cameraPosition;
+    GLint time;
+    GLint windDirection;
+    GLint windStrength;
+    GLint densityRange;
+    GLint groundMin;
+    GLint groundSize;
+    GLint lightmapTexture;
+  } _grassShaderUniformLocations;
+
   /// \desc set the lighting parameters to the shader
   void _setLightingParameters();
 
+  /// \desc recaptures the ground cache if the main camera has moved too far
+  /// from where it was captured
+  /// \param framebufferHeight height of the main view, sizes the edges
+  void _updateGroundCache(GLint framebufferHeight);
+
   // spawn enemies around the world
   void _spawnEnemies(int numEnemies);
 
@@ -270,8 +576,41 @@ private:
   // check collision between player and coins
   void _checkCoinCollection();
 
-  // calculates the height of the Bezier terrain at a given position
-  float _getTerrainHeight(float x, float z) const;
+  // calculates the height of the terrain (the open world, else the
+  // heightmap if there is one, else the Bezier hill and its deformation) at
+  // a given position
+  float _getTerrainHeight(float x, float z) const {
+    if (_worldStreamer)
+      return _worldStreamer->height(x, z);
+    if (_heightmap)
+      return _heightmap->height(x, z);
+    return _terrain.height(x, z) +
+           (_groundDeformation ? _groundDeformation->height(x, z) : 0.0f);
+  }
+
+  // batched _getTerrainHeight, normals may be null
+  void _getTerrainHeights(const float *xs, const float *zs, float *outHeights,
+                          glm::vec3 *outNormals, size_t count) const {
+    if (_worldStreamer)
+      _worldStreamer->heights(xs, zs, outHeights, outNormals, count);
+    else if (_heightmap)
+      _heightmap->heights(xs, zs, outHeights, outNormals, count);
+    else {
+      _terrain.heights(xs, zs, outHeights, outNormals, count);
+      if (_groundDeformation)
+        _groundDeformation->apply(xs, zs, outHeights, outNormals, count);
+    }
+  }
+
+  // height the open world generates at (x, z): the ground itself within its
+  // bounds, flattening out from its edge beyond them. Safe to call from the
+  // streaming workers
+  float _openWorldHeight(float x, float z) const;
+
+  // half the extent of the ground in x and z
+  float _getTerrainHalfSize() const {
+    return _heightmap ? _heightmap->getHalfSize() : WORLD_SIZE;
+  }
 
   // checks collision between character and vegetation and returns corrected
   // position
@@ -0,0 +1,370 @@
+#include "FractalNoise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FRACTAL_NOISE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC emits any intrinsic without per function targets
+#define FRACTAL_NOISE_TARGET_SSE41
+#define FRACTAL_NOISE_TARGET_AVX2
+#else
+#define FRACTAL_NOISE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define FRACTAL_NOISE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+    // odd constants mixing the lattice coordinates into the hash
+    constexpr uint32_t HASH_X = 0x8da6b343u;
+    constexpr uint32_t HASH_Z = 0xd8163841u;
+    constexpr uint32_t HASH_MIX = 0x85ebca6bu;
+    // decorrelates the octaves' seeds
+    constexpr uint32_t OCTAVE_SEED_STEP = 0x9e3779b9u;
+
+    struct Octaves {
+        const float* frequencies;
+        const float* amplitudes;
+        const uint32_t* seeds;
+        int count;
+        float normalization;
+        float halfHeight;
+    };
+
+    using RowKernel = void (*)(const Octaves& octaves, float x0, float z, float spacing, int count, float* out);
+
+    // -------------------------------------------------------------------------
+    // scalar
+
+    inline uint32_t hashLattice(int32_t ix, int32_t iz, uint32_t seed) {
+        uint32_t h = seed ^ (static_cast<uint32_t>(ix) * HASH_X) ^ (static_cast<uint32_t>(iz) * HASH_Z);
+        h = (h ^ (h >> 13)) * HASH_MIX;
+        return h ^ (h >> 16);
+    }
+
+    inline float flipSign(float value, uint32_t signBit) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits ^= signBit;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // dot product with one of the four diagonal gradients (+-1, +-1)
+    inline float gradient(uint32_t h, float x, float z) {
+        return flipSign(x, h << 31) + flipSign(z, (h >> 1) << 31);
+    }
+
+    inline float fade(float t) {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    float gradientNoise(float x, float z, uint32_t seed) {
+        const float xFloor = std::floor(x);
+        const float zFloor = std::floor(z);
+        const int32_t ix = static_cast<int32_t>(xFloor);
+        const int32_t iz = static_cast<int32_t>(zFloor);
+        const float fx = x - xFloor;
+        const float fz = z - zFloor;
+
+        const float g00 = gradient(hashLattice(ix, iz, seed), fx, fz);
+        const float g10 = gradient(hashLattice(ix + 1, iz, seed), fx - 1.0f, fz);
+        const float g01 = gradient(hashLattice(ix, iz + 1, seed), fx, fz - 1.0f);
+        const float g11 = gradient(hashLattice(ix + 1, iz + 1, seed), fx - 1.0f, fz - 1.0f);
+
+        const float u = fade(fx);
+        const float v = fade(fz);
+        const float a = g00 + u * (g10 - g00);
+        const float b = g01 + u * (g11 - g01);
+        return a + v * (b - a);
+    }
+
+    float fractalNoise(const Octaves& octaves, float x, float z) {
+        float sum = 0.0f;
+        for (int o = 0; o < octaves.count; ++o) {
+            const float frequency = octaves.frequencies[o];
+            sum = sum + gradientNoise(x * frequency, z * frequency, octaves.seeds[o]) * octaves.amplitudes[o];
+        }
+        return (sum * octaves.normalization + 1.0f) * octaves.halfHeight;
+    }
+
+    // columns [firstCol, count) of a row, also the tail of the SIMD kernels
+    void fillColumnsScalar(const Octaves& octaves, float x0, float z, float spacing, int firstCol, int count,
+                           float* out) {
+        for (int col = firstCol; col < count; ++col) {
+            out[col] = fractalNoise(octaves, x0 + static_cast<float>(col) * spacing, z);
+        }
+    }
+
+    void fillRowScalar(const Octaves& octaves, float x0, float z, float spacing, int count, float* out) {
+        fillColumnsScalar(octaves, x0, z, spacing, 0, count, out);
+    }
+
+#ifdef FRACTAL_NOISE_X86
+    // -------------------------------------------------------------------------
+    // SSE4.1, four samples at a time
+
+    FRACTAL_NOISE_TARGET_SSE41
+    inline __m128i hashLattice4(__m128i hx, __m128i hz, __m128i seed) {
+        __m128i h = _mm_xor_si128(seed, _mm_xor_si128(hx, hz));
+        h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_srli_epi32(h, 13)), _mm_set1_epi32(static_cast<int>(HASH_MIX)));
+        return _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+    }
+
+    FRACTAL_NOISE_TARGET_SSE41
+    inline __m128 gradient4(__m128i h, __m128 x, __m128 z) {
+        const __m128 xSign = _mm_castsi128_ps(_mm_slli_epi32(h, 31));
+        const __m128 zSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(h, 1), 31));
+        return _mm_add_ps(_mm_xor_ps(x, xSign), _mm_xor_ps(z, zSign));
+    }
+
+    FRACTAL_NOISE_TARGET_SSE41
+    inline __m128 fade4(__m128 t) {
+        const __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))),
+                                        _mm_set1_ps(10.0f));
+        return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+    }
+
+    FRACTAL_NOISE_TARGET_SSE41
+    inline __m128 gradientNoise4(__m128 x, __m128 z, uint32_t seed) {
+        const __m128 xFloor = _mm_floor_ps(x);
+        const __m128 zFloor = _mm_floor_ps(z);
+        const __m128 fx = _mm_sub_ps(x, xFloor);
+        const __m128 fz = _mm_sub_ps(z, zFloor);
+
+        // (i + 1) * C wraps to the same bits as i * C + C
+        const __m128i hashX = _mm_set1_epi32(static_cast<int>(HASH_X));
+        const __m128i hashZ = _mm_set1_epi32(static_cast<int>(HASH_Z));
+        const __m128i hx0 = _mm_mullo_epi32(_mm_cvttps_epi32(xFloor), hashX);
+        const __m128i hz0 = _mm_mullo_epi32(_mm_cvttps_epi32(zFloor), hashZ);
+        const __m128i hx1 = _mm_add_epi32(hx0, hashX);
+        const __m128i hz1 = _mm_add_epi32(hz0, hashZ);
+        const __m128i seedVector = _mm_set1_epi32(static_cast<int>(seed));
+
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 fx1 = _mm_sub_ps(fx, one);
+        const __m128 fz1 = _mm_sub_ps(fz, one);
+        const __m128 g00 = gradient4(hashLattice4(hx0, hz0, seedVector), fx, fz);
+        const __m128 g10 = gradient4(hashLattice4(hx1, hz0, seedVector), fx1, fz);
+        const __m128 g01 = gradient4(hashLattice4(hx0, hz1, seedVector), fx, fz1);
+        const __m128 g11 = gradient4(hashLattice4(hx1, hz1, seedVector), fx1, fz1);
+
+        const __m128 u = fade4(fx);
+        const __m128 v = fade4(fz);
+        const __m128 a = _mm_add_ps(g00, _mm_mul_ps(u, _mm_sub_ps(g10, g00)));
+        const __m128 b = _mm_add_ps(g01, _mm_mul_ps(u, _mm_sub_ps(g11, g01)));
+        return _mm_add_ps(a, _mm_mul_ps(v, _mm_sub_ps(b, a)));
+    }
+
+    FRACTAL_NOISE_TARGET_SSE41
+    void fillRowSSE41(const Octaves& octaves, float x0, float z, float spacing, int count, float* out) {
+        const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        int col = 0;
+        for (; col + 4 <= count; col += 4) {
+            const __m128 columns = _mm_add_ps(_mm_set1_ps(static_cast<float>(col)), lanes);
+            const __m128 x = _mm_add_ps(_mm_set1_ps(x0), _mm_mul_ps(columns, _mm_set1_ps(spacing)));
+            __m128 sum = _mm_setzero_ps();
+            for (int o = 0; o < octaves.count; ++o) {
+                const float frequency = octaves.frequencies[o];
+                const __m128 noise = gradientNoise4(_mm_mul_ps(x, _mm_set1_ps(frequency)),
+                                                    _mm_set1_ps(z * frequency), octaves.seeds[o]);
+                sum = _mm_add_ps(sum, _mm_mul_ps(noise, _mm_set1_ps(octaves.amplitudes[o])));
+            }
+            const __m128 height = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sum, _mm_set1_ps(octaves.normalization)),
+                                                        _mm_set1_ps(1.0f)),
+                                             _mm_set1_ps(octaves.halfHeight));
+            _mm_storeu_ps(out + col, height);
+        }
+        fillColumnsScalar(octaves, x0, z, spacing, col, count, out);
+    }
+
+    // -------------------------------------------------------------------------
+    // AVX2, eight samples at a time
+
+    FRACTAL_NOISE_TARGET_AVX2
+    inline __m256i hashLattice8(__m256i hx, __m256i hz, __m256i seed) {
+        __m256i h = _mm256_xor_si256(seed, _mm256_xor_si256(hx, hz));
+        h = _mm256_mullo_epi32(_mm256_xor_si256(h, _mm256_srli_epi32(h, 13)),
+                               _mm256_set1_epi32(static_cast<int>(HASH_MIX)));
+        return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    }
+
+    FRACTAL_NOISE_TARGET_AVX2
+    inline __m256 gradient8(__m256i h, __m256 x, __m256 z) {
+        const __m256 xSign = _mm256_castsi256_ps(_mm256_slli_epi32(h, 31));
+        const __m256 zSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(h, 1), 31));
+        return _mm256_add_ps(_mm256_xor_ps(x, xSign), _mm256_xor_ps(z, zSign));
+    }
+
+    FRACTAL_NOISE_TARGET_AVX2
+    inline __m256 fade8(__m256 t) {
+        const __m256 inner = _mm256_add_ps(
+            _mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))),
+            _mm256_set1_ps(10.0f));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+    }
+
+    FRACTAL_NOISE_TARGET_AVX2
+    inline __m256 gradientNoise8(__m256 x, __m256 z, uint32_t seed) {
+        const __m256 xFloor = _mm256_floor_ps(x);
+        const __m256 zFloor = _mm256_floor_ps(z);
+        const __m256 fx = _mm256_sub_ps(x, xFloor);
+        const __m256 fz = _mm256_sub_ps(z, zFloor);
+
+        const __m256i hashX = _mm256_set1_epi32(static_cast<int>(HASH_X));
+        const __m256i hashZ = _mm256_set1_epi32(static_cast<int>(HASH_Z));
+        const __m256i hx0 = _mm256_mullo_epi32(_mm256_cvttps_epi32(xFloor), hashX);
+        const __m256i hz0 = _mm256_mullo_epi32(_mm256_cvttps_epi32(zFloor), hashZ);
+        const __m256i hx1 = _mm256_add_epi32(hx0, hashX);
+        const __m256i hz1 = _mm256_add_epi32(hz0, hashZ);
+        const __m256i seedVector = _mm256_set1_epi32(static_cast<int>(seed));
+
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 fx1 = _mm256_sub_ps(fx, one);
+        const __m256 fz1 = _mm256_sub_ps(fz, one);
+        const __m256 g00 = gradient8(hashLattice8(hx0, hz0, seedVector), fx, fz);
+        const __m256 g10 = gradient8(hashLattice8(hx1, hz0, seedVector), fx1, fz);
+        const __m256 g01 = gradient8(hashLattice8(hx0, hz1, seedVector), fx, fz1);
+        const __m256 g11 = gradient8(hashLattice8(hx1, hz1, seedVector), fx1, fz1);
+
+        const __m256 u = fade8(fx);
+        const __m256 v = fade8(fz);
+        const __m256 a = _mm256_add_ps(g00, _mm256_mul_ps(u, _mm256_sub_ps(g10, g00)));
+        const __m256 b = _mm256_add_ps(g01, _mm256_mul_ps(u, _mm256_sub_ps(g11, g01)));
+        return _mm256_add_ps(a, _mm256_mul_ps(v, _mm256_sub_ps(b, a)));
+    }
+
+    FRACTAL_NOISE_TARGET_AVX2
+    void fillRowAVX2(const Octaves& octaves, float x0, float z, float spacing, int count, float* out) {
+        const __m256 lanes = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+        int col = 0;
+        for (; col + 8 <= count; col += 8) {
+            const __m256 columns = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(col)), lanes);
+            const __m256 x = _mm256_add_ps(_mm256_set1_ps(x0), _mm256_mul_ps(columns, _mm256_set1_ps(spacing)));
+            __m256 sum = _mm256_setzero_ps();
+            for (int o = 0; o < octaves.count; ++o) {
+                const float frequency = octaves.frequencies[o];
+                const __m256 noise = gradientNoise8(_mm256_mul_ps(x, _mm256_set1_ps(frequency)),
+                                                    _mm256_set1_ps(z * frequency), octaves.seeds[o]);
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(noise, _mm256_set1_ps(octaves.amplitudes[o])));
+            }
+            const __m256 height = _mm256_mul_ps(
+                _mm256_add_ps(_mm256_mul_ps(sum, _mm256_set1_ps(octaves.normalization)), _mm256_set1_ps(1.0f)),
+                _mm256_set1_ps(octaves.halfHeight));
+            _mm256_storeu_ps(out + col, height);
+        }
+        fillColumnsScalar(octaves, x0, z, spacing, col, count, out);
+    }
+
+    // -------------------------------------------------------------------------
+    // dispatch
+
+    bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        // the OS has to save the AVX registers too
+        const bool osSavesAVX = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return osSavesAVX && (info[1] & (1 << 5));
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    bool cpuHasSSE41() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        return info[2] & (1 << 19);
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+#endif
+    }
+#endif // FRACTAL_NOISE_X86
+
+    struct Kernel {
+        RowKernel fillRow;
+        const char* name;
+    };
+
+    const Kernel& selectKernel() {
+        static const Kernel kernel = [] {
+#ifdef FRACTAL_NOISE_X86
+            if (cpuHasAVX2()) return Kernel{fillRowAVX2, "AVX2"};
+            if (cpuHasSSE41()) return Kernel{fillRowSSE41, "SSE4.1"};
+#endif
+            return Kernel{fillRowScalar, "scalar"};
+        }();
+        return kernel;
+    }
+}
+
+FractalNoise::FractalNoise(const unsigned int seed, const Parameters& parameters)
+    : _normalization(1.0f),
+      _halfHeight(0.5f * parameters.height)
+{
+    const int octaves = std::max(parameters.octaves, 1);
+    float frequency = parameters.frequency;
+    float amplitude = 1.0f;
+    float amplitudeSum = 0.0f;
+    for (int o = 0; o < octaves; ++o) {
+        _frequencies.push_back(frequency);
+        _amplitudes.push_back(amplitude);
+        _seeds.push_back(seed + static_cast<uint32_t>(o) * OCTAVE_SEED_STEP);
+        amplitudeSum += amplitude;
+        frequency *= parameters.lacunarity;
+        amplitude *= parameters.gain;
+    }
+    _normalization = 1.0f / amplitudeSum;
+}
+
+float FractalNoise::sample(const float x, const float z) const {
+    const Octaves octaves{_frequencies.data(), _amplitudes.data(), _seeds.data(),
+                          static_cast<int>(_frequencies.size()), _normalization, _halfHeight};
+    return fractalNoise(octaves, x, z);
+}
+
+void FractalNoise::fill(const float x0, const float z0, const float spacing, const int width, const int depth,
+                        float* out) const {
+    const int hardwareThreads = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    const int numThreads = std::clamp(depth / MIN_ROWS_PER_THREAD, 1, hardwareThreads);
+    if (numThreads == 1) {
+        _fillRows(x0, z0, spacing, width, 0, depth, out);
+        return;
+    }
+
+    // contiguous bands of rows, the calling thread takes the first
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for (int band = 1; band < numThreads; ++band) {
+        threads.emplace_back(&FractalNoise::_fillRows, this, x0, z0, spacing, width,
+                             depth * band / numThreads, depth * (band + 1) / numThreads, out);
+    }
+    _fillRows(x0, z0, spacing, width, 0, depth / numThreads, out);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void FractalNoise::_fillRows(const float x0, const float z0, const float spacing, const int width,
+                             const int firstRow, const int lastRow, float* out) const {
+    const Octaves octaves{_frequencies.data(), _amplitudes.data(), _seeds.data(),
+                          static_cast<int>(_frequencies.size()), _normalization, _halfHeight};
+    const RowKernel fillRow = selectKernel().fillRow;
+    for (int row = firstRow; row < lastRow; ++row) {
+        fillRow(octaves, x0, z0 + static_cast<float>(row) * spacing, spacing, width,
+                out + static_cast<size_t>(row) * width);
+    }
+}
+
+const char* FractalNoise::getKernelName() {
+    return selectKernel().name;
+}
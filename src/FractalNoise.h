@@ -0,0 +1,58 @@
+#ifndef FRACTAL_NOISE_H
+#define FRACTAL_NOISE_H
+
+#include <cstdint>
+#include <vector>
+
+// Fractal Brownian motion (fBm) of 2D gradient noise, used as terrain height.
+//
+// Every octave is lattice gradient noise with a quintic fade whose corner
+// gradients come from an integer hash of the lattice coordinates and the
+// octave's seed, so there are no permutation tables to look up and the same
+// seed always gives the same terrain. Rows of samples are filled 8 or 4 at a
+// time with AVX2 or SSE4.1 when the CPU has them, picked once at run time,
+// and one at a time otherwise. All paths do the same float operations in the
+// same order, so they return identical heights and sample() agrees with
+// fill() bit for bit.
+class FractalNoise {
+public:
+    struct Parameters {
+        int octaves = 6;
+        // lattice cells per world unit of the first octave
+        float frequency = 1.0f / 160.0f;
+        // frequency multiplier from one octave to the next
+        float lacunarity = 2.0f;
+        // amplitude multiplier from one octave to the next
+        float gain = 0.5f;
+        // heights span [0, height]
+        float height = 60.0f;
+    };
+
+    FractalNoise(unsigned int seed, const Parameters& parameters);
+
+    // height at (x, z)
+    float sample(float x, float z) const;
+
+    // fills a width x depth grid of heights, row major, whose first sample is
+    // at (x0, z0) and whose samples are spacing apart. Large grids are split
+    // into bands of rows filled on several threads
+    void fill(float x0, float z0, float spacing, int width, int depth, float* out) const;
+
+    // name of the kernel fill() uses on this CPU, for the log
+    static const char* getKernelName();
+
+    // fewest rows worth starting a thread for
+    static constexpr int MIN_ROWS_PER_THREAD = 64;
+
+private:
+    std::vector<float> _frequencies;
+    std::vector<float> _amplitudes;
+    std::vector<uint32_t> _seeds;
+    // maps the octave sum onto [-1, 1]
+    float _normalization;
+    float _halfHeight;
+
+    void _fillRows(float x0, float z0, float spacing, int width, int firstRow, int lastRow, float* out) const;
+};
+
+#endif // FRACTAL_NOISE_H
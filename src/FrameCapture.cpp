@@ -0,0 +1,188 @@
+#include "FrameCapture.h"
+
+#include <stb_image_write.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+FrameCapture::FrameCapture(const std::string& outputDirectory, bool blockWhenFull)
+    : _nextPixelBuffer(0),
+      _outputDirectory(outputDirectory),
+      _blockWhenFull(blockWhenFull),
+      _nextFrameIndex(0),
+      _framesDropped(0),
+      _jobsInProgress(0),
+      _framesWritten(0),
+      _stopping(false)
+{
+    for (auto& buffer : _pixelBuffers) {
+        glGenBuffers(1, &buffer.handle);
+        buffer.fence = nullptr;
+        buffer.capacity = 0;
+        buffer.width = 0;
+        buffer.height = 0;
+        buffer.frameIndex = -1;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(_outputDirectory, error);
+    if (error) {
+        fprintf(stderr, "[ERROR]: could not create capture directory \"%s\": %s\n",
+                _outputDirectory.c_str(), error.message().c_str());
+    }
+
+    // GL reads rows bottom up
+    stbi_flip_vertically_on_write(true);
+
+    _worker = std::thread(&FrameCapture::_workerLoop, this);
+
+    fprintf(stdout, "[INFO]: capturing frames to %s/\n", _outputDirectory.c_str());
+}
+
+FrameCapture::~FrameCapture() {
+    finish();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _jobAvailable.notify_all();
+    _worker.join();
+
+    for (auto& buffer : _pixelBuffers) {
+        glDeleteBuffers(1, &buffer.handle);
+    }
+
+    fprintf(stdout, "[INFO]: frame capture wrote %d frames, dropped %d\n",
+            getFramesWritten(), _framesDropped);
+}
+
+void FrameCapture::capture(GLint x, GLint y, GLsizei width, GLsizei height) {
+    PixelBuffer& buffer = _pixelBuffers[_nextPixelBuffer];
+
+    // the oldest read is still in flight
+    if (buffer.fence && !_collect(buffer, _blockWhenFull)) {
+        ++_framesDropped;
+        return;
+    }
+
+    const GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.handle);
+    if (size > buffer.capacity) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        buffer.capacity = size;
+    }
+
+    // with a pack buffer bound the read only records a GPU side copy
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    buffer.width = width;
+    buffer.height = height;
+    buffer.frameIndex = _nextFrameIndex++;
+
+    _nextPixelBuffer = (_nextPixelBuffer + 1) % NUM_PIXEL_BUFFERS;
+}
+
+void FrameCapture::poll() {
+    // oldest first, so frames reach the encoder in order
+    for (int i = 0; i < NUM_PIXEL_BUFFERS; ++i) {
+        PixelBuffer& buffer = _pixelBuffers[(_nextPixelBuffer + i) % NUM_PIXEL_BUFFERS];
+        if (buffer.fence && !_collect(buffer, false)) break;
+    }
+}
+
+void FrameCapture::finish() {
+    for (int i = 0; i < NUM_PIXEL_BUFFERS; ++i) {
+        PixelBuffer& buffer = _pixelBuffers[(_nextPixelBuffer + i) % NUM_PIXEL_BUFFERS];
+        if (buffer.fence) _collect(buffer, true);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _jobFinished.wait(lock, [this] { return _jobs.empty() && _jobsInProgress == 0; });
+}
+
+int FrameCapture::getFramesWritten() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _framesWritten;
+}
+
+bool FrameCapture::_collect(PixelBuffer& buffer, bool wait) {
+    const GLenum status = glClientWaitSync(buffer.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                           wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status == GL_TIMEOUT_EXPIRED) return false;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_jobs.size() >= MAX_QUEUED_FRAMES) {
+            if (!wait) return false;
+            _jobFinished.wait(lock, [this] { return _jobs.size() < MAX_QUEUED_FRAMES; });
+        }
+    }
+
+    glDeleteSync(buffer.fence);
+    buffer.fence = nullptr;
+
+    EncodeJob job;
+    job.frameIndex = buffer.frameIndex;
+    job.width = buffer.width;
+    job.height = buffer.height;
+    job.pixels.resize(static_cast<size_t>(buffer.width) * buffer.height * 4);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.handle);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, job.pixels.size(), GL_MAP_READ_BIT);
+    if (mapped) {
+        memcpy(job.pixels.data(), mapped, job.pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        fprintf(stderr, "[ERROR]: could not map capture buffer for frame %d\n", job.frameIndex);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (mapped) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back(std::move(job));
+        }
+        _jobAvailable.notify_one();
+    } else {
+        ++_framesDropped;
+    }
+    return true;
+}
+
+void FrameCapture::_workerLoop() {
+    while (true) {
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobAvailable.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_jobs.empty()) return; // stopping with nothing left to do
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            ++_jobsInProgress;
+        }
+        // a slot in the queue opened up
+        _jobFinished.notify_all();
+
+        char filename[512];
+        snprintf(filename, sizeof(filename), "%s/frame_%05d.png", _outputDirectory.c_str(), job.frameIndex);
+        const bool written = stbi_write_png(filename, job.width, job.height, 4,
+                                            job.pixels.data(), job.width * 4) != 0;
+        if (!written) {
+            fprintf(stderr, "[ERROR]: could not write frame \"%s\"\n", filename);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_jobsInProgress;
+            if (written) ++_framesWritten;
+        }
+        _jobFinished.notify_all();
+    }
+}
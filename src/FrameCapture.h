@@ -0,0 +1,87 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/gl.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Asynchronous readback of rendered frames to numbered PNG files.
+//
+// capture() only queues a glReadPixels into one of NUM_PIXEL_BUFFERS pixel
+// buffer objects and fences it, so the copy happens on the GPU timeline. Once
+// the fence has signaled (checked without waiting in poll()) the pixels are
+// copied out of the mapped buffer and handed to a worker thread that does the
+// PNG encoding. In the default mode nothing ever waits: if every buffer is
+// still in flight or the encoder is backed up, the frame is dropped and
+// counted. With blockWhenFull set every frame is kept instead, which is what
+// offline rendering wants.
+class FrameCapture {
+public:
+    FrameCapture(const std::string& outputDirectory, bool blockWhenFull);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // queue a read of the given rectangle of the default framebuffer's back
+    // buffer, call after the frame is rendered and before swapping
+    void capture(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // hand finished reads to the encoder, never waits on the GPU
+    void poll();
+
+    // wait for every queued frame to be read back and written to disk
+    void finish();
+
+    int getFramesWritten() const;
+    int getFramesDropped() const { return _framesDropped; }
+
+    static constexpr int NUM_PIXEL_BUFFERS = 3;
+    // frames waiting for the encoder before new ones are dropped or waited on
+    static constexpr size_t MAX_QUEUED_FRAMES = 8;
+
+private:
+    struct PixelBuffer {
+        GLuint handle;
+        GLsync fence;        // nullptr when the buffer is free
+        GLsizeiptr capacity;
+        GLsizei width;
+        GLsizei height;
+        int frameIndex;
+    };
+    PixelBuffer _pixelBuffers[NUM_PIXEL_BUFFERS];
+    int _nextPixelBuffer;
+
+    struct EncodeJob {
+        int frameIndex;
+        GLsizei width;
+        GLsizei height;
+        std::vector<unsigned char> pixels;
+    };
+
+    std::string _outputDirectory;
+    bool _blockWhenFull;
+    int _nextFrameIndex;
+    int _framesDropped;
+
+    // encoder thread state, guarded by _mutex
+    std::thread _worker;
+    mutable std::mutex _mutex;
+    std::condition_variable _jobAvailable;
+    std::condition_variable _jobFinished;
+    std::deque<EncodeJob> _jobs;
+    int _jobsInProgress;
+    int _framesWritten;
+    bool _stopping;
+
+    // returns true if the buffer's read finished and was handed off
+    bool _collect(PixelBuffer& buffer, bool wait);
+    void _workerLoop();
+};
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,35 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// The six planes of a view frustum, for culling axis aligned boxes on the CPU.
+struct Frustum {
+    // planes from the rows of a view projection matrix, normals point inwards
+    explicit Frustum(const glm::mat4& viewProjectionMtx) {
+        const glm::vec4 w(viewProjectionMtx[0][3], viewProjectionMtx[1][3],
+                          viewProjectionMtx[2][3], viewProjectionMtx[3][3]);
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec4 row(viewProjectionMtx[0][i], viewProjectionMtx[1][i],
+                                viewProjectionMtx[2][i], viewProjectionMtx[3][i]);
+            planes[2 * i] = w + row;
+            planes[2 * i + 1] = w - row;
+        }
+    }
+
+    // false only if the box is entirely behind one of the planes
+    bool intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+        for (const glm::vec4& plane : planes) {
+            // the box corner furthest along the plane normal
+            const glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                                   plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                                   plane.z >= 0.0f ? boxMax.z : boxMin.z);
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) return false;
+        }
+        return true;
+    }
+
+    glm::vec4 planes[6];
+};
+
+#endif // FRUSTUM_H
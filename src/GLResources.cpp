@@ -0,0 +1,250 @@
+#include "GLResources.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    bool usesMipmaps(GLint minFilter) {
+        return minFilter == GL_NEAREST_MIPMAP_NEAREST || minFilter == GL_LINEAR_MIPMAP_NEAREST ||
+               minFilter == GL_NEAREST_MIPMAP_LINEAR || minFilter == GL_LINEAR_MIPMAP_LINEAR;
+    }
+
+    GLsizei mipLevelCount(GLsizei width, GLsizei height) {
+        return 1 + static_cast<GLsizei>(std::floor(std::log2(static_cast<float>(std::max(width, height)))));
+    }
+
+    // rows of 8-bit RGB images are rarely 4 byte aligned, so uploads read
+    // tightly packed rows. The caller's alignment is put back afterwards, code
+    // outside these helpers uploads with whatever it expects
+    class TightUnpackAlignment {
+    public:
+        TightUnpackAlignment() : _previous(4) {
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &_previous);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        }
+        ~TightUnpackAlignment() { glPixelStorei(GL_UNPACK_ALIGNMENT, _previous); }
+
+    private:
+        GLint _previous;
+    };
+}
+
+bool GLResources::hasDirectStateAccess() {
+    // the context version can't change once created
+    static const bool available = GLAD_GL_VERSION_4_5 || GLAD_GL_ARB_direct_state_access;
+    return available;
+}
+
+GLuint GLResources::createStaticBuffer(GLsizeiptr size, const void* data) {
+    GLuint buffer = 0;
+    if (hasDirectStateAccess()) {
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, size, data, 0);
+    } else {
+        // the copy target is not part of any VAO state
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    return buffer;
+}
+
+GLuint GLResources::createDynamicBuffer(GLsizeiptr size, const void* data) {
+    GLuint buffer = 0;
+    if (hasDirectStateAccess()) {
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, size, data, GL_DYNAMIC_STORAGE_BIT);
+    } else {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    return buffer;
+}
+
+void GLResources::updateBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data) {
+    if (hasDirectStateAccess()) {
+        glNamedBufferSubData(buffer, offset, size, data);
+    } else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+GLuint GLResources::createVertexArray() {
+    GLuint vao = 0;
+    if (hasDirectStateAccess()) {
+        glCreateVertexArrays(1, &vao);
+    } else {
+        glGenVertexArrays(1, &vao);
+    }
+    return vao;
+}
+
+void GLResources::setVertexAttribute(GLuint vao, GLuint location, GLuint buffer,
+                                     GLint size, GLenum type, GLsizei stride, GLintptr offset,
+                                     GLboolean normalized) {
+    if (hasDirectStateAccess()) {
+        // one binding point per attribute keeps separate and interleaved
+        // buffers on the same path
+        glVertexArrayVertexBuffer(vao, location, buffer, offset, stride);
+        glVertexArrayAttribFormat(vao, location, size, type, normalized, 0);
+        glVertexArrayAttribBinding(vao, location, location);
+        glEnableVertexArrayAttrib(vao, location);
+    } else {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glVertexAttribPointer(location, size, type, normalized, stride, (void*)offset);
+        glEnableVertexAttribArray(location);
+        glBindVertexArray(0);
+        // the array buffer binding is not VAO state, it would outlive the call
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void GLResources::setIntegerVertexAttribute(GLuint vao, GLuint location, GLuint buffer,
+                                            GLint size, GLenum type, GLsizei stride, GLintptr offset) {
+    if (hasDirectStateAccess()) {
+        glVertexArrayVertexBuffer(vao, location, buffer, offset, stride);
+        glVertexArrayAttribIFormat(vao, location, size, type, 0);
+        glVertexArrayAttribBinding(vao, location, location);
+        glEnableVertexArrayAttrib(vao, location);
+    } else {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glVertexAttribIPointer(location, size, type, stride, (void*)offset);
+        glEnableVertexAttribArray(location);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void GLResources::setElementBuffer(GLuint vao, GLuint buffer) {
+    if (hasDirectStateAccess()) {
+        glVertexArrayElementBuffer(vao, buffer);
+    } else {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        glBindVertexArray(0);
+    }
+}
+
+GLenum GLResources::sizedInternalFormat(int channels, GLenum type) {
+    if (type == GL_UNSIGNED_SHORT) {
+        switch (channels) {
+            case 1: return GL_R16;
+            case 2: return GL_RG16;
+            case 3: return GL_RGB16;
+            default: return GL_RGBA16;
+        }
+    }
+    if (type == GL_FLOAT) {
+        switch (channels) {
+            case 1: return GL_R16F;
+            case 2: return GL_RG16F;
+            case 3: return GL_RGB16F;
+            default: return GL_RGBA16F;
+        }
+    }
+    switch (channels) {
+        case 1: return GL_R8;
+        case 2: return GL_RG8;
+        case 3: return GL_RGB8;
+        default: return GL_RGBA8;
+    }
+}
+
+GLenum GLResources::pixelFormat(int channels) {
+    switch (channels) {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 3: return GL_RGB;
+        default: return GL_RGBA;
+    }
+}
+
+GLuint GLResources::createTexture2D(GLsizei width, GLsizei height, GLenum internalFormat,
+                                    GLenum format, GLenum type, const void* data,
+                                    GLint minFilter, GLint magFilter, GLint wrapS, GLint wrapT) {
+    const bool mipmapped = usesMipmaps(minFilter);
+    GLuint texture = 0;
+    const TightUnpackAlignment alignment;
+
+    if (hasDirectStateAccess()) {
+        glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, minFilter);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, magFilter);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, wrapS);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, wrapT);
+        glTextureStorage2D(texture, mipmapped ? mipLevelCount(width, height) : 1,
+                           internalFormat, width, height);
+        if (data) {
+            glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type, data);
+            if (mipmapped) glGenerateTextureMipmap(texture);
+        }
+    } else {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
+        if (data && mipmapped) glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    return texture;
+}
+
+void GLResources::updateTexture2D(GLuint texture, GLint x, GLint y, GLsizei width, GLsizei height,
+                                  GLenum format, GLenum type, const void* data) {
+    const TightUnpackAlignment alignment;
+    if (hasDirectStateAccess()) {
+        glTextureSubImage2D(texture, 0, x, y, width, height, format, type, data);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, data);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+GLuint GLResources::createCubemap(GLsizei size, GLenum internalFormat) {
+    GLuint texture = 0;
+    if (hasDirectStateAccess()) {
+        glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &texture);
+        glTextureStorage2D(texture, 1, internalFormat, size, size);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    } else {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    }
+    return texture;
+}
+
+void GLResources::uploadCubemapFace(GLuint texture, int face, GLsizei size, GLenum internalFormat,
+                                    GLenum format, GLenum type, const void* data) {
+    const TightUnpackAlignment alignment;
+    if (hasDirectStateAccess()) {
+        // with DSA a cube map is addressed as six layers
+        glTextureSubImage3D(texture, 0, 0, 0, face, size, size, 1, format, type, data);
+    } else {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, internalFormat, size, size, 0,
+                     format, type, data);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    }
+}
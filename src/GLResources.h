@@ -0,0 +1,68 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+
+#include <glad/gl.h>
+
+// Helpers for creating GPU resources at load time, and for refilling the few
+// that change afterwards.
+//
+// When the context supports GL 4.5 or ARB_direct_state_access the objects are
+// created and filled through their names (glCreateBuffers,
+// glNamedBufferStorage, glVertexArrayAttribFormat, glTextureStorage2D, ...)
+// and get immutable storage. Otherwise the classic bind-to-edit GL 4.1 calls
+// are used. Either way the caller does not need to care what is bound.
+namespace GLResources {
+    // true if the direct state access path is in use
+    bool hasDirectStateAccess();
+
+    // creates a buffer holding size bytes of data that is never modified
+    GLuint createStaticBuffer(GLsizeiptr size, const void* data);
+
+    // creates a buffer of size bytes that is rewritten with updateBuffer(),
+    // data may be null
+    GLuint createDynamicBuffer(GLsizeiptr size, const void* data);
+
+    // replaces size bytes at offset of a buffer from createDynamicBuffer()
+    void updateBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+
+    GLuint createVertexArray();
+
+    // sources the floating point attribute at location from buffer
+    void setVertexAttribute(GLuint vao, GLuint location, GLuint buffer,
+                            GLint size, GLenum type, GLsizei stride, GLintptr offset,
+                            GLboolean normalized = GL_FALSE);
+
+    // sources the integer attribute at location from buffer, as
+    // glVertexAttribIPointer does
+    void setIntegerVertexAttribute(GLuint vao, GLuint location, GLuint buffer,
+                                   GLint size, GLenum type, GLsizei stride, GLintptr offset);
+
+    void setElementBuffer(GLuint vao, GLuint buffer);
+
+    // sized internal format for an image with the given channel count and
+    // component type, GL_RGBA8 if it is not one we know
+    GLenum sizedInternalFormat(int channels, GLenum type);
+
+    // unsized pixel transfer format for the given channel count
+    GLenum pixelFormat(int channels);
+
+    // creates a 2D texture with a single image, mipmaps are generated when
+    // the min filter uses them
+    GLuint createTexture2D(GLsizei width, GLsizei height, GLenum internalFormat,
+                           GLenum format, GLenum type, const void* data,
+                           GLint minFilter, GLint magFilter, GLint wrapS, GLint wrapT);
+
+    // replaces a width x height rectangle of mip level 0 of a 2D texture,
+    // data is tightly packed
+    void updateTexture2D(GLuint texture, GLint x, GLint y, GLsizei width, GLsizei height,
+                         GLenum format, GLenum type, const void* data);
+
+    // creates a cube map of six size x size faces with storage but no data
+    GLuint createCubemap(GLsizei size, GLenum internalFormat);
+
+    // fills face (0 = +X ... 5 = -Z) of a cube map made by createCubemap
+    void uploadCubemapFace(GLuint texture, int face, GLsizei size, GLenum internalFormat,
+                           GLenum format, GLenum type, const void* data);
+}
+
+#endif // GL_RESOURCES_H
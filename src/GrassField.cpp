@@ -0,0 +1,242 @@
+#include "GrassField.h"
+#include "Frustum.h"
+#include "GLResources.h"
+#include "GridSeed.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+
+namespace {
+    // blade sizes, the shader's wind sway stays within the tallest blade
+    constexpr float MIN_BLADE_HEIGHT = 0.5f;
+    constexpr float MAX_BLADE_HEIGHT = 1.1f;
+    constexpr float MIN_BLADE_WIDTH = 0.08f;
+    constexpr float MAX_BLADE_WIDTH = 0.14f;
+    // tiles are only released this far past the grass distance, so walking
+    // back and forth over a tile edge does not regenerate it every time
+    constexpr float RELEASE_MARGIN = GrassField::TILE_SIZE;
+}
+
+GrassField::GrassField(const HeightFunction& terrainHeights, const float halfSize, const unsigned int seed)
+    : _terrainHeights(terrainHeights),
+      _halfSize(halfSize),
+      _seed(seed),
+      _tilesPerSide(static_cast<int>(std::ceil(2.0f * halfSize / TILE_SIZE))),
+      _outOfSlots(false),
+      _vao(0),
+      _bladeVBO(0),
+      _instanceBuffer(0),
+      _nearFirstVertex(0),
+      _nearVertexCount(0),
+      _farFirstVertex(0),
+      _farVertexCount(0),
+      _drawnBlades(0)
+{
+    _tiles.assign(static_cast<size_t>(_tilesPerSide) * _tilesPerSide, Tile{-1, false, 0, 0.0f, 0.0f});
+    for (int slot = MAX_RESIDENT_TILES - 1; slot >= 0; --slot) {
+        _freeSlots.push_back(slot);
+    }
+
+    // blades are strips across x in [-1, 1] and up y in [0, 1], grass.v.glsl
+    // tapers, sizes and bends them. The near blade has a pair of vertices per
+    // segment and a single tip, the far blade is one triangle
+    std::vector<glm::vec2> vertices;
+    _nearFirstVertex = 0;
+    for (int segment = 0; segment < NEAR_BLADE_SEGMENTS; ++segment) {
+        const float t = static_cast<float>(segment) / NEAR_BLADE_SEGMENTS;
+        vertices.emplace_back(-1.0f, t);
+        vertices.emplace_back(1.0f, t);
+    }
+    vertices.emplace_back(0.0f, 1.0f);
+    _nearVertexCount = static_cast<GLsizei>(vertices.size());
+
+    _farFirstVertex = static_cast<GLint>(vertices.size());
+    vertices.emplace_back(-1.0f, 0.0f);
+    vertices.emplace_back(1.0f, 0.0f);
+    vertices.emplace_back(0.0f, 1.0f);
+    _farVertexCount = 3;
+
+    _vao = GLResources::createVertexArray();
+    _bladeVBO = GLResources::createStaticBuffer(vertices.size() * sizeof(glm::vec2), vertices.data());
+    GLResources::setVertexAttribute(_vao, 0, _bladeVBO, 2, GL_FLOAT, sizeof(glm::vec2), 0);
+
+    // every resident tile owns a slot of BLADES_PER_TILE instances
+    _instanceBuffer = GLResources::createDynamicBuffer(
+        static_cast<GLsizeiptr>(MAX_RESIDENT_TILES) * BLADES_PER_TILE * sizeof(BladeInstance), nullptr);
+
+    // the instance attributes (locations 1 and 2) advance once per blade,
+    // they point at a different slot for every tile and are set in draw()
+    glBindVertexArray(_vao);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+
+    _blades.resize(BLADES_PER_TILE);
+    _xs.resize(BLADES_PER_TILE);
+    _zs.resize(BLADES_PER_TILE);
+    _heights.resize(BLADES_PER_TILE);
+
+    fprintf(stdout, "[INFO]: grass field of %dx%d tiles, %d blades each, %d resident at most\n",
+            _tilesPerSide, _tilesPerSide, BLADES_PER_TILE, MAX_RESIDENT_TILES);
+}
+
+GrassField::~GrassField() {
+    glDeleteVertexArrays(1, &_vao);
+    glDeleteBuffers(1, &_bladeVBO);
+    glDeleteBuffers(1, &_instanceBuffer);
+}
+
+float GrassField::_density(const float distance) {
+    return std::clamp((GRASS_DISTANCE - distance) / (GRASS_DISTANCE - FULL_DENSITY_DISTANCE), 0.0f, 1.0f);
+}
+
+float GrassField::_distanceToTile(const int col, const int row, const glm::vec3& position) const {
+    const Tile& tile = _tiles[row * _tilesPerSide + col];
+    const glm::vec3 boxMin(-_halfSize + col * TILE_SIZE, tile.minHeight, -_halfSize + row * TILE_SIZE);
+    const glm::vec3 boxMax(boxMin.x + TILE_SIZE, tile.maxHeight, boxMin.z + TILE_SIZE);
+    // tiles not generated yet have no heights, measure them flat at position
+    const glm::vec3 closest = tile.slot < 0
+        ? glm::vec3(glm::clamp(position.x, boxMin.x, boxMax.x), position.y, glm::clamp(position.z, boxMin.z, boxMax.z))
+        : glm::clamp(position, boxMin, boxMax);
+    return glm::length(closest - position);
+}
+
+void GrassField::update(const glm::vec3& focus) {
+    // closest first, so the grass under the player never waits on far tiles
+    std::vector<std::pair<float, int>> wanted;
+    for (int row = 0; row < _tilesPerSide; ++row) {
+        for (int col = 0; col < _tilesPerSide; ++col) {
+            Tile& tile = _tiles[row * _tilesPerSide + col];
+            const float distance = _distanceToTile(col, row, focus);
+            if (tile.slot >= 0 && distance > GRASS_DISTANCE + RELEASE_MARGIN) {
+                _release(tile);
+            } else if ((tile.slot < 0 || tile.stale) && distance <= GRASS_DISTANCE) {
+                wanted.emplace_back(distance, row * _tilesPerSide + col);
+            }
+        }
+    }
+
+    std::sort(wanted.begin(), wanted.end());
+    const size_t numGenerated = std::min(wanted.size(), static_cast<size_t>(MAX_TILES_PER_UPDATE));
+    for (size_t i = 0; i < numGenerated; ++i) {
+        _generate(wanted[i].second % _tilesPerSide, wanted[i].second / _tilesPerSide);
+    }
+}
+
+void GrassField::invalidate(const float x0, const float z0, const float x1, const float z1) {
+    const int col0 = std::max(static_cast<int>(std::floor((x0 + _halfSize) / TILE_SIZE)), 0);
+    const int row0 = std::max(static_cast<int>(std::floor((z0 + _halfSize) / TILE_SIZE)), 0);
+    const int col1 = std::min(static_cast<int>(std::floor((x1 + _halfSize) / TILE_SIZE)), _tilesPerSide - 1);
+    const int row1 = std::min(static_cast<int>(std::floor((z1 + _halfSize) / TILE_SIZE)), _tilesPerSide - 1);
+    for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+            Tile& tile = _tiles[row * _tilesPerSide + col];
+            if (tile.slot >= 0) tile.stale = true;
+        }
+    }
+}
+
+void GrassField::_generate(const int col, const int row) {
+    Tile& tile = _tiles[row * _tilesPerSide + col];
+    if (tile.slot < 0) {
+        if (_freeSlots.empty()) {
+            if (!_outOfSlots) {
+                fprintf(stderr, "[ERROR]: all %d grass tiles are in use, tile (%d, %d) stays bare\n",
+                        MAX_RESIDENT_TILES, col, row);
+                _outOfSlots = true;
+            }
+            return;
+        }
+        tile.slot = _freeSlots.back();
+        _freeSlots.pop_back();
+    }
+    tile.stale = false;
+
+    // the same tile always grows the same grass, the last row and column of
+    // tiles are cut off at the edge of the ground
+    std::mt19937 random(gridSeed(_seed, col, row));
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float x0 = -_halfSize + col * TILE_SIZE;
+    const float z0 = -_halfSize + row * TILE_SIZE;
+    const float width = std::min(TILE_SIZE, _halfSize - x0);
+    const float depth = std::min(TILE_SIZE, _halfSize - z0);
+
+    for (int i = 0; i < BLADES_PER_TILE; ++i) {
+        _xs[i] = x0 + unit(random) * width;
+        _zs[i] = z0 + unit(random) * depth;
+    }
+    _terrainHeights(_xs.data(), _zs.data(), _heights.data(), BLADES_PER_TILE);
+
+    // blades are scattered independently, so their generation order is
+    // already a random order to thin them out in
+    tile.minHeight = _heights[0];
+    tile.maxHeight = _heights[0];
+    for (int i = 0; i < BLADES_PER_TILE; ++i) {
+        BladeInstance& blade = _blades[i];
+        blade.root = glm::vec3(_xs[i], _heights[i], _zs[i]);
+        blade.facing = unit(random) * 6.2831853f;
+        blade.height = MIN_BLADE_HEIGHT + unit(random) * (MAX_BLADE_HEIGHT - MIN_BLADE_HEIGHT);
+        blade.width = MIN_BLADE_WIDTH + unit(random) * (MAX_BLADE_WIDTH - MIN_BLADE_WIDTH);
+        blade.phase = unit(random) * 6.2831853f;
+        blade.rank = static_cast<float>(i) / BLADES_PER_TILE;
+        tile.minHeight = std::min(tile.minHeight, _heights[i]);
+        tile.maxHeight = std::max(tile.maxHeight, _heights[i]);
+    }
+    tile.bladeCount = BLADES_PER_TILE;
+
+    GLResources::updateBuffer(_instanceBuffer,
+                              static_cast<GLintptr>(tile.slot) * BLADES_PER_TILE * sizeof(BladeInstance),
+                              BLADES_PER_TILE * sizeof(BladeInstance), _blades.data());
+}
+
+void GrassField::_release(Tile& tile) {
+    _freeSlots.push_back(tile.slot);
+    _outOfSlots = false;
+    tile.slot = -1;
+    tile.stale = false;
+    tile.bladeCount = 0;
+}
+
+void GrassField::draw(const glm::mat4& viewProjectionMtx, const glm::vec3& cameraPos) const {
+    _drawnBlades = 0;
+    const Frustum frustum(viewProjectionMtx);
+
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+
+    for (int row = 0; row < _tilesPerSide; ++row) {
+        for (int col = 0; col < _tilesPerSide; ++col) {
+            const Tile& tile = _tiles[row * _tilesPerSide + col];
+            if (tile.slot < 0) continue;
+
+            // the tile's nearest blade sets how many of its blades can show
+            const float distance = _distanceToTile(col, row, cameraPos);
+            const GLsizei numBlades = static_cast<GLsizei>(std::ceil(_density(distance) * tile.bladeCount));
+            if (numBlades == 0) continue;
+
+            const glm::vec3 boxMin(-_halfSize + col * TILE_SIZE, tile.minHeight, -_halfSize + row * TILE_SIZE);
+            const glm::vec3 boxMax(boxMin.x + TILE_SIZE, tile.maxHeight + MAX_BLADE_HEIGHT, boxMin.z + TILE_SIZE);
+            if (!frustum.intersects(boxMin, boxMax)) continue;
+
+            const GLintptr offset = static_cast<GLintptr>(tile.slot) * BLADES_PER_TILE * sizeof(BladeInstance);
+            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(BladeInstance), (void*)offset);
+            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(BladeInstance),
+                                  (void*)(offset + offsetof(BladeInstance, height)));
+
+            if (distance < NEAR_LOD_DISTANCE) {
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, _nearFirstVertex, _nearVertexCount, numBlades);
+            } else {
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, _farFirstVertex, _farVertexCount, numBlades);
+            }
+            _drawnBlades += numBlades;
+        }
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
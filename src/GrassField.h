@@ -0,0 +1,118 @@
+#ifndef GRASS_FIELD_H
+#define GRASS_FIELD_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Instanced grass blades over the ground, generated tile by tile around the
+// player.
+//
+// The ground is divided into square tiles. Tiles within GRASS_DISTANCE of
+// the focus point get their blades generated (a seeded, repeatable scatter
+// placed on the terrain) into a slot of one shared instance buffer; tiles
+// that fall behind give their slot back. Only nearby tiles ever hold
+// blades, so the cost is bounded by the draw distance rather than the size
+// of the ground.
+//
+// Every tile's blades are stored in random order, each tagged with its rank
+// in that order. Drawing a tile draws the first blades up to its density,
+// which falls off with camera distance, and grass.v.glsl shrinks each blade
+// away as the density at its position drops below its rank, so thinning out
+// never pops. Near tiles use a curved blade of several segments, far tiles a
+// single triangle. Wind is animated entirely in the vertex shader.
+class GrassField {
+public:
+    // heights of count points on the terrain
+    using HeightFunction = std::function<void(const float* xs, const float* zs, float* outHeights, size_t count)>;
+
+    // halfSize: grass covers [-halfSize, halfSize] in x and z
+    GrassField(const HeightFunction& terrainHeights, float halfSize, unsigned int seed);
+    ~GrassField();
+
+    GrassField(const GrassField&) = delete;
+    GrassField& operator=(const GrassField&) = delete;
+
+    // generates the tiles that came into range of focus, a few per call, and
+    // releases the ones that left it
+    void update(const glm::vec3& focus);
+
+    // regenerates the resident tiles overlapping [x0, x1] x [z0, z1], after
+    // the terrain under them changed
+    void invalidate(float x0, float z0, float x1, float z1);
+
+    // draws the resident tiles in the frustum, the grass shader program must
+    // be bound
+    void draw(const glm::mat4& viewProjectionMtx, const glm::vec3& cameraPos) const;
+
+    // blades drawn by the last draw()
+    size_t getDrawnBladeCount() const { return _drawnBlades; }
+
+    static constexpr float TILE_SIZE = 16.0f;
+    static constexpr int BLADES_PER_TILE = 1024;
+    // full density up to FULL_DENSITY_DISTANCE, thinning out to nothing at
+    // GRASS_DISTANCE
+    static constexpr float FULL_DENSITY_DISTANCE = 12.0f;
+    static constexpr float GRASS_DISTANCE = 48.0f;
+    // tiles nearer than this use the segmented blade
+    static constexpr float NEAR_LOD_DISTANCE = 20.0f;
+    static constexpr int NEAR_BLADE_SEGMENTS = 4;
+    static constexpr int MAX_RESIDENT_TILES = 96;
+    // tiles generated per update(), keeps the cost of one frame flat
+    static constexpr int MAX_TILES_PER_UPDATE = 4;
+
+    // per-blade data read by grass.v.glsl
+    struct BladeInstance {
+        glm::vec3 root;
+        float facing; // radians around y
+        float height;
+        float width;
+        float phase;  // offsets the wind sway
+        float rank;   // position in the tile's random order, in [0, 1)
+    };
+
+private:
+    struct Tile {
+        // slot in the instance buffer, -1 when not resident
+        int slot;
+        bool stale;
+        GLsizei bladeCount;
+        float minHeight;
+        float maxHeight;
+    };
+
+    HeightFunction _terrainHeights;
+    float _halfSize;
+    unsigned int _seed;
+    int _tilesPerSide;
+    std::vector<Tile> _tiles;
+    std::vector<int> _freeSlots;
+    // set once a tile found no free slot, so running out is reported once
+    // rather than every update until a slot frees up
+    bool _outOfSlots;
+
+    GLuint _vao;
+    GLuint _bladeVBO;
+    GLuint _instanceBuffer;
+    // both blade meshes are triangle strips in _bladeVBO
+    GLint _nearFirstVertex;
+    GLsizei _nearVertexCount;
+    GLint _farFirstVertex;
+    GLsizei _farVertexCount;
+
+    mutable size_t _drawnBlades;
+
+    // scratch for tile generation
+    std::vector<BladeInstance> _blades;
+    std::vector<float> _xs, _zs, _heights;
+
+    void _generate(int col, int row);
+    void _release(Tile& tile);
+    float _distanceToTile(int col, int row, const glm::vec3& position) const;
+    static float _density(float distance);
+};
+
+#endif // GRASS_FIELD_H
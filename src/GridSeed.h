@@ -0,0 +1,13 @@
+#ifndef GRID_SEED_H
+#define GRID_SEED_H
+
+// Seed for the random sequence of one cell of a grid (a grass tile, a world
+// chunk), so a cell grows the same content every time it is generated no
+// matter in which order cells are visited. Spatial hash primes from Teschner
+// et al. spread neighbouring cells apart.
+inline unsigned int gridSeed(const unsigned int seed, const int x, const int z) {
+    return seed ^ (static_cast<unsigned int>(x) * 73856093u)
+                ^ (static_cast<unsigned int>(z) * 19349663u);
+}
+
+#endif // GRID_SEED_H
@@ -0,0 +1,123 @@
+#include "Heightmap.h"
+#include "FractalNoise.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+Heightmap::Heightmap(float halfSize)
+    : _halfSize(halfSize),
+      _width(0),
+      _depth(0),
+      _spacing(0.0f)
+{
+}
+
+bool Heightmap::loadFromFile(const std::string& filename, float heightScale) {
+    int width, depth, channels;
+    stbi_us* pixels = stbi_load_16(filename.c_str(), &width, &depth, &channels, 1);
+    if (!pixels) {
+        fprintf(stderr, "[ERROR]: could not load heightmap \"%s\": %s\n",
+                filename.c_str(), stbi_failure_reason());
+        return false;
+    }
+    if (width < 2 || depth < 2) {
+        fprintf(stderr, "[ERROR]: heightmap \"%s\" needs at least 2x2 samples\n", filename.c_str());
+        stbi_image_free(pixels);
+        return false;
+    }
+
+    _width = width;
+    _depth = depth;
+    _spacing = glm::vec2(2.0f * _halfSize / (_width - 1), 2.0f * _halfSize / (_depth - 1));
+    _samples.resize(static_cast<size_t>(_width) * _depth);
+    const float scale = heightScale / 65535.0f;
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        _samples[i] = pixels[i] * scale;
+    }
+    stbi_image_free(pixels);
+
+    fprintf(stdout, "[INFO]: loaded %dx%d heightmap \"%s\"\n", _width, _depth, filename.c_str());
+    return true;
+}
+
+void Heightmap::generate(const FractalNoise& noise, int resolution) {
+    resolution = std::max(resolution, 2);
+    _width = resolution;
+    _depth = resolution;
+    _spacing = glm::vec2(2.0f * _halfSize / (resolution - 1));
+    _samples.resize(static_cast<size_t>(_width) * _depth);
+    noise.fill(-_halfSize, -_halfSize, _spacing.x, _width, _depth, _samples.data());
+}
+
+float Heightmap::sample(int col, int row) const {
+    col = std::clamp(col, 0, _width - 1);
+    row = std::clamp(row, 0, _depth - 1);
+    return _samples[static_cast<size_t>(row) * _width + col];
+}
+
+float Heightmap::_interpolate(float x, float z) const {
+    const float s = std::clamp((x + _halfSize) / _spacing.x, 0.0f, static_cast<float>(_width - 1));
+    const float t = std::clamp((z + _halfSize) / _spacing.y, 0.0f, static_cast<float>(_depth - 1));
+    const int col = std::min(static_cast<int>(s), _width - 2);
+    const int row = std::min(static_cast<int>(t), _depth - 2);
+    const float fs = s - col;
+    const float ft = t - row;
+
+    const float* r0 = &_samples[static_cast<size_t>(row) * _width + col];
+    const float* r1 = r0 + _width;
+    const float h0 = r0[0] + (r0[1] - r0[0]) * fs;
+    const float h1 = r1[0] + (r1[1] - r1[0]) * fs;
+    return h0 + (h1 - h0) * ft;
+}
+
+float Heightmap::height(float x, float z) const {
+    if (_samples.empty() || x < -_halfSize || x > _halfSize || z < -_halfSize || z > _halfSize) {
+        return OUT_OF_BOUNDS_HEIGHT;
+    }
+    return _interpolate(x, z);
+}
+
+glm::vec3 Heightmap::normal(float x, float z) const {
+    if (_samples.empty() || x < -_halfSize || x > _halfSize || z < -_halfSize || z > _halfSize) {
+        return glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    // central differences one sample apart, the same as cdlod.v.glsl
+    const float dhdx = (_interpolate(x + _spacing.x, z) - _interpolate(x - _spacing.x, z)) / (2.0f * _spacing.x);
+    const float dhdz = (_interpolate(x, z + _spacing.y) - _interpolate(x, z - _spacing.y)) / (2.0f * _spacing.y);
+    return glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+}
+
+void Heightmap::heights(const float* xs, const float* zs, float* outHeights,
+                        glm::vec3* outNormals, size_t count) const {
+    for (size_t n = 0; n < count; ++n) {
+        outHeights[n] = height(xs[n], zs[n]);
+    }
+
+    if (!outNormals) return;
+
+    for (size_t n = 0; n < count; ++n) {
+        outNormals[n] = normal(xs[n], zs[n]);
+    }
+}
+
+void Heightmap::minMax(float x0, float z0, float x1, float z1, float& lowest, float& highest) const {
+    // every sample that can influence a bilinear lookup inside the rectangle
+    const int col0 = std::clamp(static_cast<int>(std::floor((x0 + _halfSize) / _spacing.x)), 0, _width - 1);
+    const int col1 = std::clamp(static_cast<int>(std::ceil((x1 + _halfSize) / _spacing.x)), 0, _width - 1);
+    const int row0 = std::clamp(static_cast<int>(std::floor((z0 + _halfSize) / _spacing.y)), 0, _depth - 1);
+    const int row1 = std::clamp(static_cast<int>(std::ceil((z1 + _halfSize) / _spacing.y)), 0, _depth - 1);
+
+    lowest = sample(col0, row0);
+    highest = lowest;
+    for (int row = row0; row <= row1; ++row) {
+        const float* samples = &_samples[static_cast<size_t>(row) * _width];
+        for (int col = col0; col <= col1; ++col) {
+            lowest = std::min(lowest, samples[col]);
+            highest = std::max(highest, samples[col]);
+        }
+    }
+}
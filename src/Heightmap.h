@@ -0,0 +1,70 @@
+#ifndef HEIGHTMAP_H
+#define HEIGHTMAP_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class FractalNoise;
+
+// A regular grid of height samples spanning [-halfSize, halfSize] in x and z.
+//
+// The first and last samples of each row and column sit exactly on the edges
+// of the map. Lookups between samples are bilinear, which is what a linearly
+// filtered texture of the same samples returns when it is addressed at texel
+// centers, so the heights the game collides with are the heights the GPU
+// draws.
+class Heightmap {
+public:
+    // halfSize: the map spans [-halfSize, halfSize] in x and z
+    explicit Heightmap(float halfSize);
+
+    // reads a grayscale image (8 or 16 bits per channel, anything stb_image
+    // reads), white becomes heightScale and black 0
+    bool loadFromFile(const std::string& filename, float heightScale);
+
+    // fills resolution x resolution samples from procedural noise
+    void generate(const FractalNoise& noise, int resolution);
+
+    // height at (x, z), OUT_OF_BOUNDS_HEIGHT outside the map
+    float height(float x, float z) const;
+
+    // unit surface normal at (x, z), straight up outside the map
+    glm::vec3 normal(float x, float z) const;
+
+    // heights (and optionally normals) of count points, normals may be null
+    void heights(const float* xs, const float* zs, float* outHeights,
+                 glm::vec3* outNormals, size_t count) const;
+
+    // lowest and highest sample in the rectangle [x0, x1] x [z0, z1], clamped
+    // to the map
+    void minMax(float x0, float z0, float x1, float z1, float& lowest, float& highest) const;
+
+    // the sample in column col and row row, clamped to the map
+    float sample(int col, int row) const;
+
+    int getWidth() const { return _width; }
+    int getDepth() const { return _depth; }
+    float getHalfSize() const { return _halfSize; }
+    // world units between neighbouring samples along x and z
+    glm::vec2 getSpacing() const { return _spacing; }
+    const float* getSamples() const { return _samples.data(); }
+
+    // returned for positions off the map, so things fall to their death
+    static constexpr float OUT_OF_BOUNDS_HEIGHT = -1000.0f;
+
+private:
+    float _halfSize;
+    int _width;
+    int _depth;
+    glm::vec2 _spacing;
+    // row major, _samples[row * _width + col]
+    std::vector<float> _samples;
+
+    // bilinear lookup with (x, z) clamped onto the map
+    float _interpolate(float x, float z) const;
+};
+
+#endif // HEIGHTMAP_H
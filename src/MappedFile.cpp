@@ -0,0 +1,68 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+    : _data(nullptr),
+      _size(0),
+      _file(INVALID_HANDLE_VALUE),
+      _mapping(nullptr)
+{
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) return;
+
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping) return;
+
+    const void* view = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) return;
+    _data = static_cast<const unsigned char*>(view);
+    _size = static_cast<size_t>(size.QuadPart);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) UnmapViewOfFile(_data);
+    if (_mapping) CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+    : _data(nullptr),
+      _size(0)
+{
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return;
+
+    // the mapping keeps the file open by itself
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if (view != MAP_FAILED) {
+            _data = static_cast<const unsigned char*>(view);
+            _size = static_cast<size_t>(status.st_size);
+        }
+    }
+    close(file);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) munmap(const_cast<unsigned char*>(_data), _size);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read only into memory, unmapped when destroyed. Pages
+// are only read from disk as they are touched, and the data can be handed to
+// GL straight from the mapping without a copy.
+class MappedFile {
+public:
+    // maps the file at path, isOpen() is false if it does not exist, is empty
+    // or cannot be mapped
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return _data != nullptr; }
+    const unsigned char* getData() const { return _data; }
+    size_t getSize() const { return _size; }
+
+private:
+    const unsigned char* _data;
+    size_t _size;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -1,4 +1,5 @@
 #include "ParticleSystem.h"
+#include "StreamingBuffer.h"
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
@@ -56,6 +57,13 @@ void ParticleSystem::_initializeBuffers() {
   glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                         (void *)offsetof(Vertex, texCoord));
 
+  // Instance attributes (locations 2 & 3) advance once per particle, their
+  // buffer and offset change every draw and are set in draw()
+  glEnableVertexAttribArray(2);
+  glVertexAttribDivisor(2, 1);
+  glEnableVertexAttribArray(3);
+  glVertexAttribDivisor(3, 1);
+
   glBindVertexArray(0);
 
   _buffersInitialized = true;
@@ -120,12 +128,33 @@ void ParticleSystem::update(float deltaTime) {
                    _particles.end());
 }
 
-void ParticleSystem::draw(GLuint shaderProgramHandle, GLint mvpMatrixLoc,
-                          GLint textureLoc, const glm::mat4 &viewMtx,
-                          const glm::mat4 &projMtx, GLuint textureHandle) {
+void ParticleSystem::draw(GLuint shaderProgramHandle,
+                          GLint viewProjectionMatrixLoc, GLint cameraRightLoc,
+                          GLint cameraUpLoc, GLint textureLoc,
+                          const glm::mat4 &viewMtx, const glm::mat4 &projMtx,
+                          GLuint textureHandle,
+                          StreamingBuffer &instanceBuffer) {
   if (_particles.empty())
     return;
 
+  // gather the instance data
+  _instances.clear();
+  for (const auto &particle : _particles) {
+    if (!particle.active)
+      continue;
+    _instances.push_back(
+        {particle.position, particle.size, particle.rotation});
+  }
+  const GLsizei numInstances = static_cast<GLsizei>(
+      std::min(_instances.size(), static_cast<size_t>(MAX_PARTICLES)));
+  if (numInstances == 0)
+    return;
+
+  const GLintptr offset = instanceBuffer.write(
+      _instances.data(), numInstances * sizeof(ParticleInstance));
+  if (offset < 0)
+    return;
+
   glUseProgram(shaderProgramHandle);
 
   // Enable blending for transparency
@@ -137,43 +166,28 @@ void ParticleSystem::draw(GLuint shaderProgramHandle, GLint mvpMatrixLoc,
   glBindTexture(GL_TEXTURE_2D, textureHandle);
   glUniform1i(textureLoc, 0);
 
-  // Extract camera vectors for billboarding
+  // Extract camera vectors for billboarding, the rotation and scale of each
+  // particle is applied in the vertex shader
   glm::vec3 cameraRight =
       glm::vec3(viewMtx[0][0], viewMtx[1][0], viewMtx[2][0]);
   glm::vec3 cameraUp = glm::vec3(viewMtx[0][1], viewMtx[1][1], viewMtx[2][1]);
 
-  glBindVertexArray(_vao);
+  glm::mat4 viewProjectionMtx = projMtx * viewMtx;
+  glUniformMatrix4fv(viewProjectionMatrixLoc, 1, GL_FALSE,
+                     glm::value_ptr(viewProjectionMtx));
+  glUniform3fv(cameraRightLoc, 1, glm::value_ptr(cameraRight));
+  glUniform3fv(cameraUpLoc, 1, glm::value_ptr(cameraUp));
 
-  for (const auto &particle : _particles) {
-    if (!particle.active)
-      continue;
-
-    // Create model matrix for the particle
-    glm::mat4 modelMtx = glm::translate(glm::mat4(1.0f), particle.position);
-
-    // Build billboard rotation matrix
-    glm::mat4 billboardMtx = glm::mat4(1.0f);
-    billboardMtx[0] = glm::vec4(cameraRight, 0.0f);
-    billboardMtx[1] = glm::vec4(cameraUp, 0.0f);
-    billboardMtx[2] = glm::vec4(glm::cross(cameraRight, cameraUp), 0.0f);
-
-    modelMtx = modelMtx * billboardMtx;
-
-    // Add rotation
-    modelMtx =
-        glm::rotate(modelMtx, particle.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-
-    // Scale based on size
-    modelMtx = glm::scale(modelMtx, glm::vec3(particle.size));
-
-    glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
+  glBindVertexArray(_vao);
 
-    // Set MVP uniform
-    glUniformMatrix4fv(mvpMatrixLoc, 1, GL_FALSE, glm::value_ptr(mvpMtx));
+  // point the instance attributes at this frame's slice of the stream
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.getHandle());
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance),
+                        (void *)(offset + offsetof(ParticleInstance, position)));
+  glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance),
+                        (void *)(offset + offsetof(ParticleInstance, rotation)));
 
-    // Draw particle
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-  }
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 6, numInstances);
 
   glBindVertexArray(0);
   glDisable(GL_BLEND);
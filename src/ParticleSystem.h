@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <vector>
 
+class StreamingBuffer;
+
 class ParticleSystem {
 public:
     ParticleSystem();
@@ -16,13 +18,27 @@ public:
     // Update all particles
     void update(float deltaTime);
 
-    // Draw all particles
+    // Draw all particles with a single instanced draw call, the per-particle
+    // data is streamed through instanceBuffer
     void draw(GLuint shaderProgramHandle,
-              GLint mvpMatrixLoc,
+              GLint viewProjectionMatrixLoc,
+              GLint cameraRightLoc,
+              GLint cameraUpLoc,
               GLint textureLoc,
               const glm::mat4& viewMtx,
               const glm::mat4& projMtx,
-              GLuint textureHandle);
+              GLuint textureHandle,
+              StreamingBuffer& instanceBuffer);
+
+    // most particles sent in one draw call
+    static constexpr int MAX_PARTICLES = 2048;
+
+    // per-particle data read by particle.v.glsl
+    struct ParticleInstance {
+        glm::vec3 position;
+        float size;
+        float rotation;
+    };
 
 private:
     struct Particle {
@@ -37,8 +53,11 @@ private:
     };
 
     std::vector<Particle> _particles;
+    // CPU staging for the instance data of the current draw
+    std::vector<ParticleInstance> _instances;
 
-    // Static VAO/VBO for particle rendering
+    // Static VAO/VBO for particle rendering, the quad is shared by all
+    // instances
     static GLuint _vao;
     static GLuint _vbo;
     static bool _buffersInitialized;
@@ -0,0 +1,338 @@
+#include "RenderGraph.h"
+#include "GLResources.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <queue>
+
+//*************************************************************************************
+//
+// Pass declaration
+
+GLuint RenderGraph::PassContext::texture(Handle resource) const {
+    return _graph->_textureOf(resource);
+}
+
+GLuint RenderGraph::PassContext::framebuffer(Handle resource) const {
+    const Resource& r = _graph->_resources[resource];
+    if (r.imported) return 0;
+    const GLuint tex = _graph->_textureOf(resource);
+    return r.isDepth ? _graph->_getFramebuffer(0, tex) : _graph->_getFramebuffer(tex, 0);
+}
+
+const RenderGraph::TextureDesc& RenderGraph::PassContext::desc(Handle resource) const {
+    return _graph->_resources[resource].desc;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(Handle resource) {
+    _graph->_passes[_pass].reads.push_back(resource);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeColor(Handle resource, bool coversAllPixels) {
+    _graph->_passes[_pass].colorTarget = resource;
+    _graph->_passes[_pass].colorCoversAll = coversAllPixels;
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeDepth(Handle resource, bool coversAllPixels) {
+    _graph->_passes[_pass].depthTarget = resource;
+    _graph->_passes[_pass].depthCoversAll = coversAllPixels;
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::setSideEffect() {
+    _graph->_passes[_pass].sideEffect = true;
+    return *this;
+}
+
+//*************************************************************************************
+//
+// Graph
+
+RenderGraph::RenderGraph() : _executedPassCount(0) {}
+
+RenderGraph::~RenderGraph() {
+    for (const auto& entry : _framebuffers) {
+        glDeleteFramebuffers(1, &entry.second);
+    }
+    for (const auto& physical : _pool) {
+        glDeleteTextures(1, &physical.texture);
+    }
+}
+
+void RenderGraph::beginFrame() {
+    _resources.clear();
+    _passes.clear();
+}
+
+RenderGraph::Handle RenderGraph::importBackbuffer(const std::string& name, const TextureDesc& desc) {
+    _resources.push_back({name, desc, true, _isDepthFormat(desc.internalFormat), -1, -1, false, -1});
+    return static_cast<Handle>(_resources.size() - 1);
+}
+
+RenderGraph::Handle RenderGraph::createTexture(const std::string& name, const TextureDesc& desc) {
+    _resources.push_back({name, desc, false, _isDepthFormat(desc.internalFormat), -1, -1, false, -1});
+    return static_cast<Handle>(_resources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name, ExecuteFunction execute) {
+    _passes.push_back({name, std::move(execute), {}, -1, -1, false, false, false});
+    return PassBuilder(this, static_cast<int>(_passes.size() - 1));
+}
+
+std::vector<int> RenderGraph::_compile() {
+    const int numPasses = static_cast<int>(_passes.size());
+
+    // dependency edges in declaration order: read-after-write,
+    // write-after-write and write-after-read on the same resource
+    std::vector<std::vector<int>> dependents(numPasses), dependencies(numPasses);
+    std::vector<int> lastWriter(_resources.size(), -1);
+    std::vector<std::vector<int>> readersSinceWrite(_resources.size());
+    auto addEdge = [&](int from, int to) {
+        if (from < 0 || from == to) return;
+        dependents[from].push_back(to);
+        dependencies[to].push_back(from);
+    };
+
+    for (int p = 0; p < numPasses; ++p) {
+        const Pass& pass = _passes[p];
+        for (Handle r : pass.reads) {
+            addEdge(lastWriter[r], p);
+            readersSinceWrite[r].push_back(p);
+        }
+        for (Handle r : {pass.colorTarget, pass.depthTarget}) {
+            if (r < 0) continue;
+            addEdge(lastWriter[r], p);
+            for (int reader : readersSinceWrite[r]) addEdge(reader, p);
+            readersSinceWrite[r].clear();
+            lastWriter[r] = p;
+        }
+    }
+
+    // cull: keep what contributes to an imported target or has side effects
+    std::vector<bool> alive(numPasses, false);
+    std::vector<int> stack;
+    for (int p = 0; p < numPasses; ++p) {
+        const Pass& pass = _passes[p];
+        bool root = pass.sideEffect;
+        for (Handle r : {pass.colorTarget, pass.depthTarget}) {
+            if (r >= 0 && _resources[r].imported) root = true;
+        }
+        if (root) {
+            alive[p] = true;
+            stack.push_back(p);
+        }
+    }
+    while (!stack.empty()) {
+        const int p = stack.back();
+        stack.pop_back();
+        for (int dependency : dependencies[p]) {
+            if (!alive[dependency]) {
+                alive[dependency] = true;
+                stack.push_back(dependency);
+            }
+        }
+    }
+
+    // order the surviving passes, declaration order breaks ties
+    std::vector<int> inDegree(numPasses, 0);
+    for (int p = 0; p < numPasses; ++p) {
+        if (!alive[p]) continue;
+        for (int dependency : dependencies[p]) {
+            if (alive[dependency]) ++inDegree[p];
+        }
+    }
+    std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+    for (int p = 0; p < numPasses; ++p) {
+        if (alive[p] && inDegree[p] == 0) ready.push(p);
+    }
+    std::vector<int> order;
+    while (!ready.empty()) {
+        const int p = ready.top();
+        ready.pop();
+        order.push_back(p);
+        for (int dependent : dependents[p]) {
+            if (alive[dependent] && --inDegree[dependent] == 0) ready.push(dependent);
+        }
+    }
+
+    // resource lifetimes in execution order
+    for (int i = 0; i < static_cast<int>(order.size()); ++i) {
+        const Pass& pass = _passes[order[i]];
+        auto touch = [&](Handle r) {
+            if (r < 0) return;
+            if (_resources[r].firstUse < 0) _resources[r].firstUse = i;
+            _resources[r].lastUse = i;
+        };
+        for (Handle r : pass.reads) touch(r);
+        touch(pass.colorTarget);
+        touch(pass.depthTarget);
+    }
+
+    return order;
+}
+
+void RenderGraph::execute() {
+    const std::vector<int> order = _compile();
+
+    for (auto& physical : _pool) {
+        physical.inUse = false;
+        physical.usedThisFrame = false;
+    }
+
+    for (int i = 0; i < static_cast<int>(order.size()); ++i) {
+        const Pass& pass = _passes[order[i]];
+
+        // transients come alive at their first use
+        for (Handle r : {pass.colorTarget, pass.depthTarget}) {
+            if (r >= 0 && !_resources[r].imported && _resources[r].physical < 0) {
+                _resources[r].physical = _acquireTexture(_resources[r].desc);
+            }
+        }
+        for (Handle r : pass.reads) {
+            if (!_resources[r].imported && _resources[r].physical < 0) {
+                // read before any write, contents are undefined
+                fprintf(stderr, "[ERROR]: render graph pass \"%s\" reads \"%s\" before it is written\n",
+                        pass.name.c_str(), _resources[r].name.c_str());
+                _resources[r].physical = _acquireTexture(_resources[r].desc);
+            }
+        }
+
+        // bind the targets
+        const bool usesBackbuffer = (pass.colorTarget >= 0 && _resources[pass.colorTarget].imported) ||
+                                    (pass.depthTarget >= 0 && _resources[pass.depthTarget].imported);
+        GLsizei width = 0, height = 0;
+        for (Handle r : {pass.colorTarget, pass.depthTarget}) {
+            if (r >= 0) {
+                width = _resources[r].desc.width;
+                height = _resources[r].desc.height;
+            }
+        }
+        if (pass.colorTarget >= 0 || pass.depthTarget >= 0) {
+            const GLuint fbo = usesBackbuffer
+                ? 0
+                : _getFramebuffer(pass.colorTarget >= 0 ? _textureOf(pass.colorTarget) : 0,
+                                  pass.depthTarget >= 0 ? _textureOf(pass.depthTarget) : 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glViewport(0, 0, width, height);
+        }
+
+        // clear whatever is written for the first time and not fully covered
+        GLbitfield clearMask = 0;
+        if (pass.colorTarget >= 0 && !_resources[pass.colorTarget].written) {
+            if (!pass.colorCoversAll) clearMask |= GL_COLOR_BUFFER_BIT;
+            _resources[pass.colorTarget].written = true;
+        }
+        if (pass.depthTarget >= 0 && !_resources[pass.depthTarget].written) {
+            if (!pass.depthCoversAll) clearMask |= GL_DEPTH_BUFFER_BIT;
+            _resources[pass.depthTarget].written = true;
+        }
+        if (clearMask) {
+            glDepthMask(GL_TRUE);
+            glClear(clearMask);
+        }
+
+        pass.execute(PassContext(this));
+
+        // transients whose last use was this pass give their texture back
+        auto release = [&](Handle r) {
+            if (r >= 0 && !_resources[r].imported && _resources[r].lastUse == i && _resources[r].physical >= 0) {
+                _pool[_resources[r].physical].inUse = false;
+            }
+        };
+        for (Handle r : pass.reads) release(r);
+        release(pass.colorTarget);
+        release(pass.depthTarget);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    _executedPassCount = static_cast<int>(order.size());
+
+    _releaseUnusedTextures();
+}
+
+int RenderGraph::_acquireTexture(const TextureDesc& desc) {
+    for (int i = 0; i < static_cast<int>(_pool.size()); ++i) {
+        PhysicalTexture& physical = _pool[i];
+        if (!physical.inUse && physical.desc.width == desc.width && physical.desc.height == desc.height &&
+            physical.desc.internalFormat == desc.internalFormat) {
+            physical.inUse = true;
+            physical.usedThisFrame = true;
+            return i;
+        }
+    }
+
+    const bool depth = _isDepthFormat(desc.internalFormat);
+    const GLuint texture = GLResources::createTexture2D(
+        desc.width, desc.height, desc.internalFormat,
+        depth ? GL_DEPTH_COMPONENT : GL_RGBA, depth ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr,
+        GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    _pool.push_back({desc, texture, true, true});
+
+    fprintf(stdout, "[INFO]: render graph allocated %dx%d target with handle %d\n",
+            desc.width, desc.height, texture);
+    return static_cast<int>(_pool.size() - 1);
+}
+
+GLuint RenderGraph::_getFramebuffer(GLuint colorTexture, GLuint depthTexture) const {
+    const auto key = std::make_pair(colorTexture, depthTexture);
+    const auto it = _framebuffers.find(key);
+    if (it != _framebuffers.end()) return it->second;
+
+    // may be called from inside a pass, leave its framebuffer bound
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    if (colorTexture) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    } else {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    if (depthTexture) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    }
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "[ERROR]: render graph framebuffer %d is incomplete\n", fbo);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+
+    _framebuffers[key] = fbo;
+    return fbo;
+}
+
+GLuint RenderGraph::_textureOf(Handle resource) const {
+    const Resource& r = _resources[resource];
+    return (r.imported || r.physical < 0) ? 0 : _pool[r.physical].texture;
+}
+
+void RenderGraph::_releaseUnusedTextures() {
+    // anything not needed this frame (i.e. after a resize) is freed, along
+    // with the framebuffers built on it
+    for (auto it = _pool.begin(); it != _pool.end();) {
+        if (it->usedThisFrame) {
+            ++it;
+            continue;
+        }
+        for (auto fbo = _framebuffers.begin(); fbo != _framebuffers.end();) {
+            if (fbo->first.first == it->texture || fbo->first.second == it->texture) {
+                glDeleteFramebuffers(1, &fbo->second);
+                fbo = _framebuffers.erase(fbo);
+            } else {
+                ++fbo;
+            }
+        }
+        glDeleteTextures(1, &it->texture);
+        it = _pool.erase(it);
+    }
+}
+
+bool RenderGraph::_isDepthFormat(GLenum internalFormat) {
+    return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24 ||
+           internalFormat == GL_DEPTH_COMPONENT32F || internalFormat == GL_DEPTH_COMPONENT;
+}
@@ -0,0 +1,135 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <glad/gl.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Small frame graph. Every frame the engine declares its passes and the
+// render targets each of them reads and writes; execute() then
+//  - orders the passes so every read happens after the write it depends on,
+//  - culls passes whose output never reaches an imported target (the
+//    backbuffer) or a pass marked as having side effects,
+//  - assigns transient textures from a pool, so transients whose lifetimes
+//    don't overlap share the same texture, and
+//  - clears a target on its first write of the frame unless the writing pass
+//    says it covers every pixel.
+class RenderGraph {
+public:
+    using Handle = int;
+
+    struct TextureDesc {
+        GLsizei width;
+        GLsizei height;
+        GLenum internalFormat; // sized format, GL_DEPTH_COMPONENT24 etc. for depth
+    };
+
+    // what a pass gets handed when it runs
+    class PassContext {
+    public:
+        // texture currently backing the resource, 0 for the backbuffer
+        GLuint texture(Handle resource) const;
+        // framebuffer with the resource as its only attachment, for blits
+        GLuint framebuffer(Handle resource) const;
+        const TextureDesc& desc(Handle resource) const;
+    private:
+        friend class RenderGraph;
+        explicit PassContext(const RenderGraph* graph) : _graph(graph) {}
+        const RenderGraph* _graph;
+    };
+
+    using ExecuteFunction = std::function<void(const PassContext&)>;
+
+    // declares the resources of a pass, returned by addPass()
+    class PassBuilder {
+    public:
+        PassBuilder& read(Handle resource);
+        // at most one color target and one depth target per pass
+        PassBuilder& writeColor(Handle resource, bool coversAllPixels = false);
+        PassBuilder& writeDepth(Handle resource, bool coversAllPixels = false);
+        // keep the pass even if nothing reads what it writes
+        PassBuilder& setSideEffect();
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph* graph, int pass) : _graph(graph), _pass(pass) {}
+        RenderGraph* _graph;
+        int _pass;
+    };
+
+    RenderGraph();
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // start declaring a new frame, drops the passes & resources of the last one
+    void beginFrame();
+
+    // the default framebuffer, as a color or depth target depending on format
+    Handle importBackbuffer(const std::string& name, const TextureDesc& desc);
+
+    // texture that only lives during this frame
+    Handle createTexture(const std::string& name, const TextureDesc& desc);
+
+    PassBuilder addPass(const std::string& name, ExecuteFunction execute);
+
+    // compile and run the frame
+    void execute();
+
+    // number of passes that ran last frame, after culling
+    int getExecutedPassCount() const { return _executedPassCount; }
+
+private:
+    struct Resource {
+        std::string name;
+        TextureDesc desc;
+        bool imported;
+        bool isDepth;
+        // filled while compiling
+        int firstUse;
+        int lastUse;
+        bool written;
+        int physical; // index into _pool, -1 for imported
+    };
+    std::vector<Resource> _resources;
+
+    struct Pass {
+        std::string name;
+        ExecuteFunction execute;
+        std::vector<Handle> reads;
+        Handle colorTarget;
+        Handle depthTarget;
+        bool colorCoversAll;
+        bool depthCoversAll;
+        bool sideEffect;
+    };
+    std::vector<Pass> _passes;
+
+    // GPU textures backing the transient resources, reused across frames
+    struct PhysicalTexture {
+        TextureDesc desc;
+        GLuint texture;
+        bool inUse;
+        bool usedThisFrame;
+    };
+    std::vector<PhysicalTexture> _pool;
+
+    // framebuffers keyed by their (color, depth) attachments
+    mutable std::map<std::pair<GLuint, GLuint>, GLuint> _framebuffers;
+
+    int _executedPassCount;
+
+    std::vector<int> _compile();
+    int _acquireTexture(const TextureDesc& desc);
+    GLuint _getFramebuffer(GLuint colorTexture, GLuint depthTexture) const;
+    GLuint _textureOf(Handle resource) const;
+    void _releaseUnusedTextures();
+
+    static bool _isDepthFormat(GLenum internalFormat);
+};
+
+#endif // RENDER_GRAPH_H
@@ -1,8 +1,10 @@
 #include "Skybox.h"
+#include "GLResources.h"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <stb_image.h>
 
+#include <algorithm>
 #include <iostream>
 
 static float skyboxVertices[] = {
@@ -36,16 +38,12 @@ Skybox::Skybox() {
       "./assets/sky/ny.png", "./assets/sky/pz.png", "./assets/sky/nz.png"};
   loadCubemap(faces);
 
-  glGenVertexArrays(1, &mVAO);
-  glGenBuffers(1, &mVBO);
+  mVAO = GLResources::createVertexArray();
+  mVBO = GLResources::createStaticBuffer(sizeof(skyboxVertices),
+                                         skyboxVertices);
 
-  glBindVertexArray(mVAO);
-  glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices,
-               GL_STATIC_DRAW);
-
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+  GLResources::setVertexAttribute(mVAO, 0, mVBO, 3, GL_FLOAT,
+                                  3 * sizeof(float), 0);
 }
 
 void Skybox::draw(const glm::mat4 &view, const glm::mat4 &projection) {
@@ -64,37 +62,52 @@ void Skybox::draw(const glm::mat4 &view, const glm::mat4 &projection) {
 }
 
 void Skybox::loadCubemap(const std::vector<std::string> &faces) {
-  glGenTextures(1, &mTextureId);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, mTextureId);
+  mTextureId = 0;
+
+  // load every face first, immutable storage needs the size up front
+  struct FaceImage {
+    unsigned char *data;
+    int width, height, nrChannels;
+  };
+  std::vector<FaceImage> images(faces.size());
 
-  int width, height, nrChannels;
   stbi_set_flip_vertically_on_load(false);
   for (unsigned int i = 0; i < faces.size(); i++) {
-    unsigned char *data =
-        stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-    if (data) {
-      GLenum format;
-      if (nrChannels == 1)
-        format = GL_RED;
-      else if (nrChannels == 3)
-        format = GL_RGB;
-      else if (nrChannels == 4)
-        format = GL_RGBA;
-
-      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height,
-                   0, format, GL_UNSIGNED_BYTE, data);
-      stbi_image_free(data);
-    } else {
+    FaceImage &image = images[i];
+    image.data = stbi_load(faces[i].c_str(), &image.width, &image.height,
+                           &image.nrChannels, 0);
+    if (!image.data) {
       std::cerr << "Cubemap texture failed to load at path: " << faces[i]
                 << std::endl;
-      stbi_image_free(data);
     }
   }
 
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  // the first face that loaded decides the size and format of the cube map
+  auto first = std::find_if(images.begin(), images.end(),
+                            [](const FaceImage &image) { return image.data; });
+  if (first != images.end()) {
+    const GLsizei size = first->width;
+    const GLenum internalFormat =
+        GLResources::sizedInternalFormat(first->nrChannels, GL_UNSIGNED_BYTE);
+    mTextureId = GLResources::createCubemap(size, internalFormat);
+
+    for (unsigned int i = 0; i < images.size(); i++) {
+      const FaceImage &image = images[i];
+      if (!image.data)
+        continue;
+      if (image.width != size || image.height != size) {
+        std::cerr << "Cubemap face " << faces[i] << " is not " << size << "x"
+                  << size << std::endl;
+        continue;
+      }
+      GLResources::uploadCubemapFace(
+          mTextureId, i, size, internalFormat,
+          GLResources::pixelFormat(image.nrChannels), GL_UNSIGNED_BYTE,
+          image.data);
+    }
+  }
+
+  for (auto &image : images) {
+    stbi_image_free(image.data);
+  }
 }
@@ -0,0 +1,127 @@
+#include "StreamingBuffer.h"
+
+#include <cstdio>
+#include <cstring>
+
+StreamingBuffer::StreamingBuffer(GLenum target, GLsizeiptr regionSize)
+    : _target(target),
+      _handle(0),
+      _regionSize(regionSize),
+      _currentRegion(NUM_REGIONS - 1),
+      _regionUsed(0),
+      _mappedData(nullptr),
+      _fences{nullptr, nullptr, nullptr}
+{
+    const GLsizeiptr totalSize = _regionSize * NUM_REGIONS;
+
+    glGenBuffers(1, &_handle);
+    glBindBuffer(_target, _handle);
+
+    if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) {
+        // immutable storage mapped once for the lifetime of the buffer,
+        // coherent so no explicit flush is needed before drawing
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(_target, totalSize, nullptr, flags);
+        _mappedData = static_cast<unsigned char*>(glMapBufferRange(_target, 0, totalSize, flags));
+        if (!_mappedData) {
+            fprintf(stderr, "[ERROR]: could not persistently map streaming buffer %u\n", _handle);
+        }
+    }
+
+    if (!_mappedData) {
+        // a buffer created with glBufferStorage is immutable, start over with
+        // a fresh one for the orphaning path
+        glDeleteBuffers(1, &_handle);
+        glGenBuffers(1, &_handle);
+        glBindBuffer(_target, _handle);
+        glBufferData(_target, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(_target, 0);
+
+    fprintf(stdout, "[INFO]: streaming buffer %u created with %d x %ld bytes (%s)\n",
+            _handle, NUM_REGIONS, static_cast<long>(_regionSize),
+            _mappedData ? "persistent mapping" : "orphaning");
+}
+
+StreamingBuffer::~StreamingBuffer() {
+    for (auto& fence : _fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (_mappedData) {
+        glBindBuffer(_target, _handle);
+        glUnmapBuffer(_target);
+        glBindBuffer(_target, 0);
+        _mappedData = nullptr;
+    }
+
+    glDeleteBuffers(1, &_handle);
+}
+
+void StreamingBuffer::beginFrame() {
+    _currentRegion = (_currentRegion + 1) % NUM_REGIONS;
+    _regionUsed = 0;
+
+    if (_mappedData) {
+        _waitForRegion(_currentRegion);
+    } else {
+        // orphan: the driver hands back fresh storage while the GPU keeps
+        // reading the old one, so the regions never need fences here
+        glBindBuffer(_target, _handle);
+        glBufferData(_target, _regionSize * NUM_REGIONS, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(_target, 0);
+    }
+}
+
+void StreamingBuffer::endFrame() {
+    if (!_mappedData) return;
+
+    if (_fences[_currentRegion]) {
+        glDeleteSync(_fences[_currentRegion]);
+    }
+    _fences[_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLintptr StreamingBuffer::write(const void* data, GLsizeiptr size, GLsizeiptr alignment) {
+    GLsizeiptr start = (_regionUsed + alignment - 1) / alignment * alignment;
+    if (start + size > _regionSize) {
+        fprintf(stderr, "[ERROR]: streaming buffer %u region overflow (%ld of %ld bytes)\n",
+                _handle, static_cast<long>(start + size), static_cast<long>(_regionSize));
+        return -1;
+    }
+    _regionUsed = start + size;
+
+    const GLintptr offset = _currentRegion * _regionSize + start;
+    if (_mappedData) {
+        memcpy(_mappedData + offset, data, size);
+    } else {
+        glBindBuffer(_target, _handle);
+        glBufferSubData(_target, offset, size, data);
+        glBindBuffer(_target, 0);
+    }
+    return offset;
+}
+
+void StreamingBuffer::_waitForRegion(int region) {
+    GLsync fence = _fences[region];
+    if (!fence) return;
+
+    // flush on the first try so the fence is guaranteed to signal eventually
+    GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true) {
+        const GLenum result = glClientWaitSync(fence, waitFlags, 1000000); // 1ms
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) break;
+        if (result == GL_WAIT_FAILED) {
+            fprintf(stderr, "[ERROR]: wait on streaming buffer %u fence failed\n", _handle);
+            break;
+        }
+        waitFlags = 0;
+    }
+
+    glDeleteSync(fence);
+    _fences[region] = nullptr;
+}
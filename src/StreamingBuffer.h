@@ -0,0 +1,56 @@
+#ifndef STREAMING_BUFFER_H
+#define STREAMING_BUFFER_H
+
+#include <glad/gl.h>
+
+// Ring buffer for data that is rewritten every frame (instance data, joint
+// matrices, ...). The buffer is split into NUM_REGIONS frame sized regions so
+// the CPU can fill one region while the GPU is still reading the others.
+//
+// With GL 4.4 / ARB_buffer_storage the whole buffer is persistently and
+// coherently mapped once and a write is just a memcpy; each region is guarded
+// by a fence that is waited on before the region is reused. On plain 4.1 the
+// buffer is orphaned at the start of every frame and written with
+// glBufferSubData instead.
+class StreamingBuffer {
+public:
+    // target is the binding point used for uploads (GL_ARRAY_BUFFER, ...),
+    // regionSize the maximum number of bytes written during a single frame
+    StreamingBuffer(GLenum target, GLsizeiptr regionSize);
+    ~StreamingBuffer();
+
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+    // move to the next region, waits if the GPU is still using it
+    void beginFrame();
+
+    // fence the region written this frame, call after the last draw using it
+    void endFrame();
+
+    // copy data into the current region and return its byte offset in the
+    // buffer, or -1 if the region does not have enough space left
+    GLintptr write(const void* data, GLsizeiptr size, GLsizeiptr alignment = 16);
+
+    GLuint getHandle() const { return _handle; }
+    GLenum getTarget() const { return _target; }
+    bool isPersistentlyMapped() const { return _mappedData != nullptr; }
+
+    static constexpr int NUM_REGIONS = 3;
+
+private:
+    GLenum _target;
+    GLuint _handle;
+    GLsizeiptr _regionSize;
+
+    int _currentRegion;
+    GLsizeiptr _regionUsed;
+
+    // persistent mapping of the whole buffer, nullptr on the fallback path
+    unsigned char* _mappedData;
+    GLsync _fences[NUM_REGIONS];
+
+    void _waitForRegion(int region);
+};
+
+#endif // STREAMING_BUFFER_H
@@ -0,0 +1,141 @@
+#include "Terrain.h"
+
+namespace {
+    // height of each control point as a fraction of the hill height: flat
+    // corners, raised edges and a high interior (row i runs along v, column j
+    // along u)
+    const float CONTROL_POINT_WEIGHTS[4][4] = {
+        {0.0f, 0.1f, 0.1f, 0.0f},
+        {0.1f, 0.6f, 0.6f, 0.1f},
+        {0.1f, 0.6f, 0.6f, 0.1f},
+        {0.0f, 0.1f, 0.1f, 0.0f}
+    };
+
+    // cubic Bernstein basis in power form, BERNSTEIN[k][i] is the t^k
+    // coefficient of B_i(t)
+    const float BERNSTEIN[4][4] = {
+        { 1.0f,  0.0f,  0.0f, 0.0f},
+        {-3.0f,  3.0f,  0.0f, 0.0f},
+        { 3.0f, -6.0f,  3.0f, 0.0f},
+        {-1.0f,  3.0f, -3.0f, 1.0f}
+    };
+}
+
+Terrain::Terrain(float halfSize, float hillHeight)
+    : _halfSize(halfSize),
+      _hillHeight(hillHeight)
+{
+    // evenly spaced in x and z, so the surface maps x and z linearly onto u
+    // and v and a height lookup never has to invert the parameterization
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            _controlPoints[i * 4 + j] = glm::vec3(-_halfSize + 2.0f * _halfSize * j / 3.0f,
+                                                  CONTROL_POINT_WEIGHTS[i][j] * _hillHeight,
+                                                  -_halfSize + 2.0f * _halfSize * i / 3.0f);
+        }
+    }
+
+    // a = M * P * M^T turns sum P[i][j] B_i(u) B_j(v) into sum a[k][l] u^k v^l,
+    // the weights are symmetric so which of u and v runs along i is moot
+    float mp[4][4];
+    for (int k = 0; k < 4; ++k) {
+        for (int j = 0; j < 4; ++j) {
+            mp[k][j] = 0.0f;
+            for (int i = 0; i < 4; ++i) {
+                mp[k][j] += BERNSTEIN[k][i] * _controlPoints[i * 4 + j].y;
+            }
+        }
+    }
+    for (int k = 0; k < 4; ++k) {
+        for (int l = 0; l < 4; ++l) {
+            _coefficients[k][l] = 0.0f;
+            for (int j = 0; j < 4; ++j) {
+                _coefficients[k][l] += mp[k][j] * BERNSTEIN[l][j];
+            }
+        }
+    }
+}
+
+void Terrain::_evaluate(float u, float v, float& h, float& dhdu, float& dhdv) const {
+    const float (&a)[4][4] = _coefficients;
+
+    // each row as a polynomial in v, and its v derivative
+    float r[4], dr[4];
+    for (int k = 0; k < 4; ++k) {
+        r[k] = ((a[k][3] * v + a[k][2]) * v + a[k][1]) * v + a[k][0];
+        dr[k] = (3.0f * a[k][3] * v + 2.0f * a[k][2]) * v + a[k][1];
+    }
+
+    h = ((r[3] * u + r[2]) * u + r[1]) * u + r[0];
+    dhdu = (3.0f * r[3] * u + 2.0f * r[2]) * u + r[1];
+    dhdv = ((dr[3] * u + dr[2]) * u + dr[1]) * u + dr[0];
+}
+
+float Terrain::height(float x, float z) const {
+    if (x < -_halfSize || x > _halfSize || z < -_halfSize || z > _halfSize) {
+        return OUT_OF_BOUNDS_HEIGHT;
+    }
+
+    const float scale = 1.0f / (2.0f * _halfSize);
+    const float u = (x + _halfSize) * scale;
+    const float v = (z + _halfSize) * scale;
+
+    const float (&a)[4][4] = _coefficients;
+    const float r0 = ((a[0][3] * v + a[0][2]) * v + a[0][1]) * v + a[0][0];
+    const float r1 = ((a[1][3] * v + a[1][2]) * v + a[1][1]) * v + a[1][0];
+    const float r2 = ((a[2][3] * v + a[2][2]) * v + a[2][1]) * v + a[2][0];
+    const float r3 = ((a[3][3] * v + a[3][2]) * v + a[3][1]) * v + a[3][0];
+    return ((r3 * u + r2) * u + r1) * u + r0;
+}
+
+glm::vec3 Terrain::normal(float x, float z) const {
+    if (x < -_halfSize || x > _halfSize || z < -_halfSize || z > _halfSize) {
+        return glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    const float scale = 1.0f / (2.0f * _halfSize);
+    float h, dhdu, dhdv;
+    _evaluate((x + _halfSize) * scale, (z + _halfSize) * scale, h, dhdu, dhdv);
+
+    // u follows x and v follows z, both at 1 / (2 * halfSize) per unit
+    return glm::normalize(glm::vec3(-dhdu * scale, 1.0f, -dhdv * scale));
+}
+
+void Terrain::heights(const float* xs, const float* zs, float* outHeights,
+                      glm::vec3* outNormals, size_t count) const {
+    const float scale = 1.0f / (2.0f * _halfSize);
+    const float (&a)[4][4] = _coefficients;
+
+    // branch free body: points off the ground are evaluated anyway, clamped,
+    // and replaced by a select
+    for (size_t n = 0; n < count; ++n) {
+        const float x = xs[n];
+        const float z = zs[n];
+        const bool inside = x >= -_halfSize && x <= _halfSize && z >= -_halfSize && z <= _halfSize;
+        const float u = glm::clamp((x + _halfSize) * scale, 0.0f, 1.0f);
+        const float v = glm::clamp((z + _halfSize) * scale, 0.0f, 1.0f);
+
+        const float r0 = ((a[0][3] * v + a[0][2]) * v + a[0][1]) * v + a[0][0];
+        const float r1 = ((a[1][3] * v + a[1][2]) * v + a[1][1]) * v + a[1][0];
+        const float r2 = ((a[2][3] * v + a[2][2]) * v + a[2][1]) * v + a[2][0];
+        const float r3 = ((a[3][3] * v + a[3][2]) * v + a[3][1]) * v + a[3][0];
+        const float h = ((r3 * u + r2) * u + r1) * u + r0;
+
+        outHeights[n] = inside ? h : OUT_OF_BOUNDS_HEIGHT;
+    }
+
+    if (!outNormals) return;
+
+    for (size_t n = 0; n < count; ++n) {
+        const float x = xs[n];
+        const float z = zs[n];
+        const bool inside = x >= -_halfSize && x <= _halfSize && z >= -_halfSize && z <= _halfSize;
+
+        float h, dhdu, dhdv;
+        _evaluate(glm::clamp((x + _halfSize) * scale, 0.0f, 1.0f),
+                  glm::clamp((z + _halfSize) * scale, 0.0f, 1.0f), h, dhdu, dhdv);
+
+        outNormals[n] = inside ? glm::normalize(glm::vec3(-dhdu * scale, 1.0f, -dhdv * scale))
+                               : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
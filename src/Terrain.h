@@ -0,0 +1,58 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Height queries against the bicubic Bezier ground.
+//
+// The 4x4 control point heights are folded into the 16 coefficients of the
+// equivalent power basis polynomial h(u,v) = sum a[i][j] u^i v^j once, so a
+// lookup is two nested Horner evaluations with no branches and no control
+// point reconstruction. heights() evaluates many points at once over plain
+// arrays, laid out so the compiler can vectorize the loop.
+//
+// The control points themselves are also the ground shader's input, so the
+// rendered surface and the one the game collides with come from the same
+// numbers.
+class Terrain {
+public:
+    // halfSize: the ground spans [-halfSize, halfSize] in x and z
+    // hillHeight: height scale of the interior control points
+    Terrain(float halfSize, float hillHeight);
+
+    // height at (x, z), OUT_OF_BOUNDS_HEIGHT outside the ground
+    float height(float x, float z) const;
+
+    // unit surface normal at (x, z), straight up outside the ground
+    glm::vec3 normal(float x, float z) const;
+
+    // heights (and optionally normals) of count points, normals may be null
+    void heights(const float* xs, const float* zs, float* outHeights,
+                 glm::vec3* outNormals, size_t count) const;
+
+    // the 4x4 control points row by row, row i along z and column j along x
+    const glm::vec3* getControlPoints() const { return _controlPoints; }
+
+    float getHalfSize() const { return _halfSize; }
+    float getHillHeight() const { return _hillHeight; }
+
+    // returned for positions off the ground, so things fall to their death
+    static constexpr float OUT_OF_BOUNDS_HEIGHT = -1000.0f;
+    static constexpr int NUM_CONTROL_POINTS = 16;
+
+private:
+    float _halfSize;
+    float _hillHeight;
+
+    glm::vec3 _controlPoints[NUM_CONTROL_POINTS];
+
+    // power basis coefficients, _coefficients[i][j] multiplies u^i v^j
+    float _coefficients[4][4];
+
+    // evaluates the height and its partial derivatives at (u, v)
+    void _evaluate(float u, float v, float& h, float& dhdu, float& dhdv) const;
+};
+
+#endif // TERRAIN_H
@@ -0,0 +1,142 @@
+#include "TerrainDeformation.h"
+#include "GLResources.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // the rim as a fraction of the crater's depth, and its width as a
+    // fraction of the radius
+    constexpr float RIM_HEIGHT_RATIO = 0.25f;
+    constexpr float RIM_WIDTH_RATIO = 0.25f;
+    // past this many radii the rim has flattened out
+    constexpr float CRATER_EXTENT = 1.0f + 3.0f * RIM_WIDTH_RATIO;
+}
+
+TerrainDeformation::TerrainDeformation(const float halfSize, const int resolution)
+    : _halfSize(halfSize),
+      _resolution(std::max(resolution, 2)),
+      _spacing(2.0f * halfSize / (std::max(resolution, 2) - 1)),
+      _maxOffset(0.0f),
+      _texture(0)
+{
+    _offsets.assign(static_cast<size_t>(_resolution) * _resolution, 0.0f);
+    _texture = GLResources::createTexture2D(_resolution, _resolution, GL_R32F, GL_RED, GL_FLOAT,
+                                            _offsets.data(), GL_LINEAR, GL_LINEAR,
+                                            GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+}
+
+TerrainDeformation::~TerrainDeformation() {
+    glDeleteTextures(1, &_texture);
+}
+
+void TerrainDeformation::addCrater(const float x, const float z, const float radius, const float depth) {
+    const float extent = CRATER_EXTENT * radius;
+    DirtyRect rect;
+    rect.col0 = std::max(static_cast<int>(std::floor((x - extent + _halfSize) / _spacing)), 0);
+    rect.row0 = std::max(static_cast<int>(std::floor((z - extent + _halfSize) / _spacing)), 0);
+    rect.col1 = std::min(static_cast<int>(std::ceil((x + extent + _halfSize) / _spacing)) + 1, _resolution);
+    rect.row1 = std::min(static_cast<int>(std::ceil((z + extent + _halfSize) / _spacing)) + 1, _resolution);
+    if (rect.col0 >= rect.col1 || rect.row0 >= rect.row1) return;
+
+    for (int row = rect.row0; row < rect.row1; ++row) {
+        const float sampleZ = -_halfSize + row * _spacing;
+        for (int col = rect.col0; col < rect.col1; ++col) {
+            const float sampleX = -_halfSize + col * _spacing;
+            const float r = std::sqrt((sampleX - x) * (sampleX - x) + (sampleZ - z) * (sampleZ - z)) / radius;
+            if (r >= CRATER_EXTENT) continue;
+
+            float offset = 0.0f;
+            if (r < 1.0f) {
+                const float bowl = 1.0f - r * r;
+                offset -= depth * bowl * bowl;
+            }
+            const float rim = (r - 1.0f) / RIM_WIDTH_RATIO;
+            offset += RIM_HEIGHT_RATIO * depth * std::exp(-rim * rim);
+
+            float& sample = _offsets[static_cast<size_t>(row) * _resolution + col];
+            sample += offset;
+            _maxOffset = std::max(_maxOffset, std::abs(sample));
+        }
+    }
+
+    _markDirty(rect);
+}
+
+void TerrainDeformation::_markDirty(DirtyRect rect) {
+    // fold in every rectangle the new one overlaps, so no sample is sent twice
+    for (size_t i = 0; i < _dirtyRects.size();) {
+        const DirtyRect& other = _dirtyRects[i];
+        if (other.col0 < rect.col1 && rect.col0 < other.col1 && other.row0 < rect.row1 && rect.row0 < other.row1) {
+            rect.col0 = std::min(rect.col0, other.col0);
+            rect.row0 = std::min(rect.row0, other.row0);
+            rect.col1 = std::max(rect.col1, other.col1);
+            rect.row1 = std::max(rect.row1, other.row1);
+            _dirtyRects.erase(_dirtyRects.begin() + static_cast<std::ptrdiff_t>(i));
+            // the grown rectangle may now reach ones already checked
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+    _dirtyRects.push_back(rect);
+}
+
+void TerrainDeformation::upload() {
+    for (const DirtyRect& rect : _dirtyRects) {
+        const int width = rect.col1 - rect.col0;
+        const int depth = rect.row1 - rect.row0;
+        _uploadScratch.resize(static_cast<size_t>(width) * depth);
+        for (int row = 0; row < depth; ++row) {
+            const float* source = &_offsets[static_cast<size_t>(rect.row0 + row) * _resolution + rect.col0];
+            std::copy(source, source + width, &_uploadScratch[static_cast<size_t>(row) * width]);
+        }
+        GLResources::updateTexture2D(_texture, rect.col0, rect.row0, width, depth, GL_RED, GL_FLOAT,
+                                     _uploadScratch.data());
+    }
+    _dirtyRects.clear();
+}
+
+float TerrainDeformation::_interpolate(const float x, const float z) const {
+    const float last = static_cast<float>(_resolution - 1);
+    const float s = std::clamp((x + _halfSize) / _spacing, 0.0f, last);
+    const float t = std::clamp((z + _halfSize) / _spacing, 0.0f, last);
+    const int col = std::min(static_cast<int>(s), _resolution - 2);
+    const int row = std::min(static_cast<int>(t), _resolution - 2);
+    const float fs = s - col;
+    const float ft = t - row;
+
+    const float* r0 = &_offsets[static_cast<size_t>(row) * _resolution + col];
+    const float* r1 = r0 + _resolution;
+    const float h0 = r0[0] + (r0[1] - r0[0]) * fs;
+    const float h1 = r1[0] + (r1[1] - r1[0]) * fs;
+    return h0 + (h1 - h0) * ft;
+}
+
+float TerrainDeformation::height(const float x, const float z) const {
+    if (x < -_halfSize || x > _halfSize || z < -_halfSize || z > _halfSize) return 0.0f;
+    return _interpolate(x, z);
+}
+
+void TerrainDeformation::apply(const float* xs, const float* zs, float* heights, glm::vec3* normals,
+                               const size_t count) const {
+    // nothing dug yet, the ground is untouched
+    if (_maxOffset == 0.0f) return;
+
+    for (size_t n = 0; n < count; ++n) {
+        heights[n] += height(xs[n], zs[n]);
+    }
+
+    if (!normals) return;
+
+    // central differences one sample apart, the same as ground.tes.glsl
+    for (size_t n = 0; n < count; ++n) {
+        const float x = xs[n], z = zs[n];
+        if (x < -_halfSize || x > _halfSize || z < -_halfSize || z > _halfSize) continue;
+        const float dx = (_interpolate(x + _spacing, z) - _interpolate(x - _spacing, z)) / (2.0f * _spacing);
+        const float dz = (_interpolate(x, z + _spacing) - _interpolate(x, z - _spacing)) / (2.0f * _spacing);
+        // a normal scaled to y = 1 holds minus the surface's slopes
+        const glm::vec3 slopes = normals[n] / normals[n].y;
+        normals[n] = glm::normalize(glm::vec3(slopes.x - dx, 1.0f, slopes.z - dz));
+    }
+}
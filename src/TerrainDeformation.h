@@ -0,0 +1,71 @@
+#ifndef TERRAIN_DEFORMATION_H
+#define TERRAIN_DEFORMATION_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Height offsets added on top of the ground, for gameplay to dig into it.
+//
+// The offsets live in a CPU grid spanning [-halfSize, halfSize] in x and z
+// and are mirrored in an R32F displacement texture that ground.tes.glsl
+// samples. Edits only touch the samples under them and remember the
+// rectangle they covered; upload() sends just those rectangles to the
+// texture, so an edit costs in proportion to its area. Lookups are bilinear
+// like the texture's at texel centers, so collision sees exactly what is
+// drawn, and sees it as soon as the edit is made.
+class TerrainDeformation {
+public:
+    // halfSize: the grid spans [-halfSize, halfSize] in x and z
+    // resolution: samples along each side
+    TerrainDeformation(float halfSize, int resolution);
+    ~TerrainDeformation();
+
+    TerrainDeformation(const TerrainDeformation&) = delete;
+    TerrainDeformation& operator=(const TerrainDeformation&) = delete;
+
+    // digs a bowl of the given radius and depth at (x, z), ringed by a low
+    // rim of the dug out dirt
+    void addCrater(float x, float z, float radius, float depth);
+
+    // offset at (x, z), 0 off the grid
+    float height(float x, float z) const;
+
+    // adds the offsets to count heights and, if normals is not null, tilts
+    // the normals by the offsets' slope
+    void apply(const float* xs, const float* zs, float* heights, glm::vec3* normals, size_t count) const;
+
+    // sends the rectangles edited since the last call to the texture
+    void upload();
+
+    GLuint getTexture() const { return _texture; }
+    int getResolution() const { return _resolution; }
+    // largest offset either way, how far the surface can have moved
+    float getMaxOffset() const { return _maxOffset; }
+
+private:
+    struct DirtyRect {
+        int col0, row0; // first sample
+        int col1, row1; // one past the last sample
+    };
+
+    float _halfSize;
+    int _resolution;
+    float _spacing;
+    // row major, _offsets[row * _resolution + col]
+    std::vector<float> _offsets;
+    float _maxOffset;
+
+    GLuint _texture;
+    std::vector<DirtyRect> _dirtyRects;
+    // a dirty rectangle packed tightly for the upload
+    std::vector<float> _uploadScratch;
+
+    // bilinear lookup with (x, z) clamped onto the grid
+    float _interpolate(float x, float z) const;
+    void _markDirty(DirtyRect rect);
+};
+
+#endif // TERRAIN_DEFORMATION_H
@@ -0,0 +1,252 @@
+#include "TerrainRaycaster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    // deepest traversal stack a pyramid of up to 2^20 cells per side needs,
+    // three siblings left behind per level plus the node being expanded
+    constexpr int MAX_STACK_DEPTH = 3 * 21 + 1;
+}
+
+TerrainRaycaster::TerrainRaycaster(const HeightFunction& terrainHeights, const float halfSize, const int resolution)
+    : _terrainHeights(terrainHeights),
+      _halfSize(halfSize),
+      _resolution(std::max(resolution, 2)),
+      _spacing(2.0f * halfSize / (std::max(resolution, 2) - 1))
+{
+    _samples.resize(static_cast<size_t>(_resolution) * _resolution);
+
+    // halve the node count per side until a single root is left
+    Level level{_resolution - 1, _resolution - 1, {}};
+    for (;;) {
+        level.bounds.resize(static_cast<size_t>(level.width) * level.depth);
+        _levels.push_back(level);
+        if (level.width == 1 && level.depth == 1) break;
+        level.width = (level.width + 1) / 2;
+        level.depth = (level.depth + 1) / 2;
+    }
+
+    _sample(0, 0, _resolution - 1, _resolution - 1);
+    _updateBounds(0, 0, _resolution - 2, _resolution - 2);
+
+    fprintf(stdout, "[INFO]: terrain raycaster over %dx%d samples with %d pyramid levels\n",
+            _resolution, _resolution, getLevelCount());
+}
+
+void TerrainRaycaster::_sample(const int col0, const int row0, const int col1, const int row1) {
+    const size_t width = static_cast<size_t>(col1 - col0 + 1);
+    const size_t count = width * (row1 - row0 + 1);
+    std::vector<float> xs(count), zs(count), heights(count);
+    for (size_t i = 0; i < count; ++i) {
+        xs[i] = -_halfSize + (col0 + static_cast<int>(i % width)) * _spacing;
+        zs[i] = -_halfSize + (row0 + static_cast<int>(i / width)) * _spacing;
+    }
+    _terrainHeights(xs.data(), zs.data(), heights.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        _samples[(row0 + i / width) * _resolution + col0 + i % width] = heights[i];
+    }
+}
+
+void TerrainRaycaster::_updateBounds(int col0, int row0, int col1, int row1) {
+    // a bilinear cell never leaves the range of its four corners
+    Level& cells = _levels[0];
+    for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+            const float* r0 = &_samples[static_cast<size_t>(row) * _resolution + col];
+            const float* r1 = r0 + _resolution;
+            cells.bounds[row * cells.width + col] =
+                glm::vec2(std::min(std::min(r0[0], r0[1]), std::min(r1[0], r1[1])),
+                          std::max(std::max(r0[0], r0[1]), std::max(r1[0], r1[1])));
+        }
+    }
+
+    for (size_t l = 1; l < _levels.size(); ++l) {
+        const Level& children = _levels[l - 1];
+        Level& level = _levels[l];
+        col0 /= 2;
+        row0 /= 2;
+        col1 /= 2;
+        row1 /= 2;
+        for (int row = row0; row <= row1; ++row) {
+            for (int col = col0; col <= col1; ++col) {
+                // nodes on the far edges can have a single child along a side
+                glm::vec2 bounds = children.bounds[2 * row * children.width + 2 * col];
+                for (int child = 1; child < 4; ++child) {
+                    const int childCol = 2 * col + (child & 1);
+                    const int childRow = 2 * row + (child >> 1);
+                    if (childCol >= children.width || childRow >= children.depth) continue;
+                    const glm::vec2 childBounds = children.bounds[childRow * children.width + childCol];
+                    bounds = glm::vec2(std::min(bounds.x, childBounds.x), std::max(bounds.y, childBounds.y));
+                }
+                level.bounds[row * level.width + col] = bounds;
+            }
+        }
+    }
+}
+
+void TerrainRaycaster::refresh(const float x0, const float z0, const float x1, const float z1) {
+    const int col0 = std::clamp(static_cast<int>(std::floor((x0 + _halfSize) / _spacing)), 0, _resolution - 1);
+    const int row0 = std::clamp(static_cast<int>(std::floor((z0 + _halfSize) / _spacing)), 0, _resolution - 1);
+    const int col1 = std::clamp(static_cast<int>(std::ceil((x1 + _halfSize) / _spacing)), 0, _resolution - 1);
+    const int row1 = std::clamp(static_cast<int>(std::ceil((z1 + _halfSize) / _spacing)), 0, _resolution - 1);
+    _sample(col0, row0, col1, row1);
+    // every cell touching a re-sampled corner
+    _updateBounds(std::max(col0 - 1, 0), std::max(row0 - 1, 0),
+                  std::min(col1, _resolution - 2), std::min(row1, _resolution - 2));
+}
+
+bool TerrainRaycaster::_clipToRect(const Ray& ray, const float x0, const float z0, const float x1, const float z1,
+                                   float& tEnter, float& tExit) {
+    const float bounds[2][2] = {{x0, x1}, {z0, z1}};
+    const float origin[2] = {ray.origin.x, ray.origin.z};
+    const float direction[2] = {ray.direction.x, ray.direction.z};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (direction[axis] == 0.0f) {
+            if (origin[axis] < bounds[axis][0] || origin[axis] > bounds[axis][1]) return false;
+            continue;
+        }
+        const float inverse = 1.0f / direction[axis];
+        float tNear = (bounds[axis][0] - origin[axis]) * inverse;
+        float tFar = (bounds[axis][1] - origin[axis]) * inverse;
+        if (tNear > tFar) std::swap(tNear, tFar);
+        tEnter = std::max(tEnter, tNear);
+        tExit = std::min(tExit, tFar);
+    }
+    return tEnter <= tExit;
+}
+
+bool TerrainRaycaster::_intersectCell(const int col, const int row, const Ray& ray, const float tEnter,
+                                      const float tExit, float& tHit) const {
+    const float* r0 = &_samples[static_cast<size_t>(row) * _resolution + col];
+    const float* r1 = r0 + _resolution;
+    const float h00 = r0[0], h10 = r0[1], h01 = r1[0], h11 = r1[1];
+
+    // the ray from where it enters the cell, in cell units across x and z
+    const glm::vec3 start = ray.origin + ray.direction * tEnter;
+    const float u0 = (start.x - (-_halfSize + col * _spacing)) / _spacing;
+    const float v0 = (start.z - (-_halfSize + row * _spacing)) / _spacing;
+    const float du = ray.direction.x / _spacing;
+    const float dv = ray.direction.z / _spacing;
+
+    // height above the bilinear surface along the ray, A t^2 + B t + C
+    const float a = h10 - h00;
+    const float b = h01 - h00;
+    const float c = h00 - h10 - h01 + h11;
+    const float A = -c * du * dv;
+    const float B = ray.direction.y - (a * du + b * dv + c * (u0 * dv + v0 * du));
+    const float C = start.y - (h00 + a * u0 + b * v0 + c * u0 * v0);
+
+    const float length = tExit - tEnter;
+    if (C <= 0.0f) {
+        tHit = tEnter;
+        return true;
+    }
+
+    float t = -1.0f;
+    if (std::abs(A) < 1e-8f) {
+        if (B < 0.0f) t = -C / B;
+    } else {
+        const float discriminant = B * B - 4.0f * A * C;
+        if (discriminant < 0.0f) return false;
+        // the stable pair of roots, then the first one ahead
+        const float q = -0.5f * (B + std::copysign(std::sqrt(discriminant), B));
+        float root0 = q / A;
+        float root1 = q != 0.0f ? C / q : root0;
+        if (root0 > root1) std::swap(root0, root1);
+        t = root0 >= 0.0f ? root0 : root1;
+    }
+    if (t < 0.0f || t > length) return false;
+
+    tHit = tEnter + t;
+    return true;
+}
+
+TerrainRaycaster::Hit TerrainRaycaster::raycast(const Ray& ray) const {
+    Hit result{false, 0.0f, glm::vec3(0.0f)};
+
+    float tEnter = 0.0f;
+    float tExit = ray.maxDistance;
+    if (!_clipToRect(ray, -_halfSize, -_halfSize, _halfSize, _halfSize, tEnter, tExit)) return result;
+
+    struct Node {
+        int level;
+        int col;
+        int row;
+        float tEnter;
+        float tExit;
+    };
+    Node stack[MAX_STACK_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = {static_cast<int>(_levels.size()) - 1, 0, 0, tEnter, tExit};
+
+    while (stackSize > 0) {
+        const Node node = stack[--stackSize];
+        const Level& level = _levels[node.level];
+        const glm::vec2 bounds = level.bounds[node.row * level.width + node.col];
+
+        const float yEnter = ray.origin.y + ray.direction.y * node.tEnter;
+        const float yExit = ray.origin.y + ray.direction.y * node.tExit;
+        // passes over everything in the node
+        if (std::min(yEnter, yExit) > bounds.y) continue;
+        // under everything, nodes are visited front to back so the ray went
+        // under right where it came in
+        if (std::max(yEnter, yExit) < bounds.x) {
+            result.hit = true;
+            result.distance = node.tEnter;
+            break;
+        }
+
+        if (node.level == 0) {
+            float tHit;
+            if (_intersectCell(node.col, node.row, ray, node.tEnter, node.tExit, tHit)) {
+                result.hit = true;
+                result.distance = tHit;
+                break;
+            }
+            continue;
+        }
+
+        // children the ray crosses, pushed far to near so the nearest is
+        // popped first
+        const Level& children = _levels[node.level - 1];
+        const float childSize = _spacing * static_cast<float>(1 << (node.level - 1));
+        Node crossed[4];
+        int numCrossed = 0;
+        for (int child = 0; child < 4; ++child) {
+            const int childCol = 2 * node.col + (child & 1);
+            const int childRow = 2 * node.row + (child >> 1);
+            if (childCol >= children.width || childRow >= children.depth) continue;
+            const float x0 = -_halfSize + childCol * childSize;
+            const float z0 = -_halfSize + childRow * childSize;
+            float childEnter = node.tEnter;
+            float childExit = node.tExit;
+            if (!_clipToRect(ray, x0, z0, std::min(x0 + childSize, _halfSize), std::min(z0 + childSize, _halfSize),
+                             childEnter, childExit)) {
+                continue;
+            }
+            crossed[numCrossed++] = {node.level - 1, childCol, childRow, childEnter, childExit};
+        }
+        std::sort(crossed, crossed + numCrossed,
+                  [](const Node& lhs, const Node& rhs) { return lhs.tEnter > rhs.tEnter; });
+        for (int i = 0; i < numCrossed; ++i) {
+            stack[stackSize++] = crossed[i];
+        }
+    }
+
+    if (result.hit) {
+        result.position = ray.origin + ray.direction * result.distance;
+    }
+    return result;
+}
+
+void TerrainRaycaster::raycast(const Ray* rays, Hit* outHits, const size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+        outHits[i] = raycast(rays[i]);
+    }
+}
+
+bool TerrainRaycaster::lineOfSight(const glm::vec3& from, const glm::vec3& to) const {
+    return !raycast(Ray{from, to - from, 1.0f}).hit;
+}
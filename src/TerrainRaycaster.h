@@ -0,0 +1,83 @@
+#ifndef TERRAIN_RAYCASTER_H
+#define TERRAIN_RAYCASTER_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Ray casts against the terrain, for picking, camera collision and line of
+// sight.
+//
+// The terrain is sampled once into a regular grid spanning [-halfSize,
+// halfSize] in x and z, read as bilinear cells. Above the cells sits a
+// pyramid of min/max heights, each level merging 2x2 nodes of the one
+// below. A ray walks the pyramid front to back from the root, skipping every
+// node it passes over entirely and stopping at the first node it passes
+// under entirely; the cells it reaches are intersected exactly by solving
+// the quadratic the bilinear surface makes along the ray. A query visits a
+// few dozen nodes and takes microseconds.
+class TerrainRaycaster {
+public:
+    // heights of count points on the terrain
+    using HeightFunction = std::function<void(const float* xs, const float* zs, float* outHeights, size_t count)>;
+
+    // samples the terrain, resolution samples along each side
+    TerrainRaycaster(const HeightFunction& terrainHeights, float halfSize, int resolution);
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction; // need not be unit length, distances are in its units
+        float maxDistance;
+    };
+
+    struct Hit {
+        bool hit;
+        // along the ray, in units of its direction
+        float distance;
+        glm::vec3 position;
+    };
+
+    // first point where the ray meets the terrain within its max distance.
+    // Rays starting under the terrain hit at their origin, rays leaving the
+    // sampled area miss
+    Hit raycast(const Ray& ray) const;
+
+    // raycast() for count rays
+    void raycast(const Ray* rays, Hit* outHits, size_t count) const;
+
+    // whether the segment between two points clears the terrain
+    bool lineOfSight(const glm::vec3& from, const glm::vec3& to) const;
+
+    // re-samples the terrain in [x0, x1] x [z0, z1] after it changed and
+    // updates the pyramid above it
+    void refresh(float x0, float z0, float x1, float z1);
+
+    int getLevelCount() const { return static_cast<int>(_levels.size()); }
+
+private:
+    struct Level {
+        int width; // nodes along x
+        int depth; // nodes along z
+        // (lowest, highest) height under each node, row major
+        std::vector<glm::vec2> bounds;
+    };
+
+    HeightFunction _terrainHeights;
+    float _halfSize;
+    int _resolution;
+    float _spacing;
+    // row major, _samples[row * _resolution + col]
+    std::vector<float> _samples;
+    // cells first, then every coarser level up to a single root
+    std::vector<Level> _levels;
+
+    void _sample(int col0, int row0, int col1, int row1);
+    void _updateBounds(int col0, int row0, int col1, int row1);
+    bool _intersectCell(int col, int row, const Ray& ray, float tEnter, float tExit, float& tHit) const;
+    // the part [tEnter, tExit] of the ray inside the xz rectangle, false if none
+    static bool _clipToRect(const Ray& ray, float x0, float z0, float x1, float z1, float& tEnter, float& tExit);
+};
+
+#endif // TERRAIN_RAYCASTER_H
@@ -0,0 +1,82 @@
+#include "TessellationCache.h"
+#include "GLResources.h"
+
+#include <cstddef>
+#include <cstdio>
+
+TessellationCache::TessellationCache(const GLsizeiptr initialVertexCapacity)
+    : _vao(0),
+      _buffer(0),
+      _primitivesQuery(0),
+      _capacity(0),
+      _vertexCount(0),
+      _valid(false),
+      _lodOrigin(0.0f),
+      _projectionScale(0.0f)
+{
+    _vao = GLResources::createVertexArray();
+    glGenQueries(1, &_primitivesQuery);
+    _allocate(initialVertexCapacity);
+}
+
+TessellationCache::~TessellationCache() {
+    glDeleteVertexArrays(1, &_vao);
+    glDeleteBuffers(1, &_buffer);
+    glDeleteQueries(1, &_primitivesQuery);
+}
+
+void TessellationCache::_allocate(const GLsizeiptr vertexCapacity) {
+    glDeleteBuffers(1, &_buffer);
+    _buffer = GLResources::createDynamicBuffer(vertexCapacity * sizeof(Vertex), nullptr);
+    _capacity = vertexCapacity;
+
+    GLResources::setVertexAttribute(_vao, 0, _buffer, 3, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, position));
+    GLResources::setVertexAttribute(_vao, 1, _buffer, 3, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, normal));
+    GLResources::setVertexAttribute(_vao, 2, _buffer, 2, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, texCoord));
+    GLResources::setVertexAttribute(_vao, 3, _buffer, 2, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, lightmapCoord));
+}
+
+bool TessellationCache::isStale(const glm::vec3& lodOrigin, const float projectionScale) const {
+    if (!_valid) return true;
+    if (glm::length(lodOrigin - _lodOrigin) > RECAPTURE_DISTANCE) return true;
+    return projectionScale > _projectionScale * RECAPTURE_SCALE_RATIO ||
+           projectionScale * RECAPTURE_SCALE_RATIO < _projectionScale;
+}
+
+void TessellationCache::capture(const glm::vec3& lodOrigin, const float projectionScale,
+                                const std::function<void()>& drawPatches) {
+    glEnable(GL_RASTERIZER_DISCARD);
+    for (;;) {
+        // the query counts every triangle tessellated, including those that
+        // did not fit into the buffer
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _buffer);
+        glBeginQuery(GL_PRIMITIVES_GENERATED, _primitivesQuery);
+        glBeginTransformFeedback(GL_TRIANGLES);
+        drawPatches();
+        glEndTransformFeedback();
+        glEndQuery(GL_PRIMITIVES_GENERATED);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+        // waits for the capture, which is rare enough not to matter
+        GLuint numTriangles = 0;
+        glGetQueryObjectuiv(_primitivesQuery, GL_QUERY_RESULT, &numTriangles);
+        _vertexCount = 3 * static_cast<GLsizeiptr>(numTriangles);
+        if (_vertexCount <= _capacity) break;
+
+        // with room to spare, so walking around does not grow it every time
+        fprintf(stdout, "[INFO]: tessellation cache grows from %ld to %ld vertices\n",
+                static_cast<long>(_capacity), static_cast<long>(_vertexCount + _vertexCount / 4));
+        _allocate(_vertexCount + _vertexCount / 4);
+    }
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    _valid = true;
+    _lodOrigin = lodOrigin;
+    _projectionScale = projectionScale;
+}
+
+void TessellationCache::draw() const {
+    glBindVertexArray(_vao);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_vertexCount));
+    glBindVertexArray(0);
+}
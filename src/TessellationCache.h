@@ -0,0 +1,74 @@
+#ifndef TESSELLATION_CACHE_H
+#define TESSELLATION_CACHE_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+
+// Tessellated geometry captured once with transform feedback and drawn as
+// plain triangles afterwards.
+//
+// Tessellation shaders are the most expensive part of drawing the ground,
+// far more so on software rasterizers, and run again for every view of
+// every frame even though the surface only changes when it is dug into. The
+// cache runs them into a buffer instead, with levels chosen for a point of
+// view rather than a camera, and keeps drawing that buffer until the point
+// of view has moved far enough, or the projection changed enough, for the
+// levels to be noticeably off, or the surface itself changed.
+class TessellationCache {
+public:
+    // what the capture program writes for every vertex, interleaved in this
+    // order
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+        glm::vec2 lightmapCoord;
+    };
+
+    // initialVertexCapacity: vertices the buffer holds before it first has to
+    // grow
+    explicit TessellationCache(GLsizeiptr initialVertexCapacity);
+    ~TessellationCache();
+
+    TessellationCache(const TessellationCache&) = delete;
+    TessellationCache& operator=(const TessellationCache&) = delete;
+
+    // true if nothing is captured, the capture was invalidated, or a capture
+    // for the given point of view would differ noticeably from the last one
+    bool isStale(const glm::vec3& lodOrigin, float projectionScale) const;
+
+    // after the surface under the capture changed
+    void invalidate() { _valid = false; }
+
+    // captures the triangles drawPatches() tessellates. The capture program
+    // must be bound and sized for lodOrigin and projectionScale. If the
+    // buffer is too small it is grown and the capture repeated
+    void capture(const glm::vec3& lodOrigin, float projectionScale, const std::function<void()>& drawPatches);
+
+    // draws the captured triangles, attributes 0 to 3 are the Vertex fields
+    void draw() const;
+
+    GLsizeiptr getVertexCount() const { return _vertexCount; }
+
+    // how far the point of view can move before the levels are redone
+    static constexpr float RECAPTURE_DISTANCE = 4.0f;
+    // and how much the projection may scale edges either way
+    static constexpr float RECAPTURE_SCALE_RATIO = 1.25f;
+
+private:
+    GLuint _vao;
+    GLuint _buffer;
+    GLuint _primitivesQuery;
+    GLsizeiptr _capacity; // in vertices
+    GLsizeiptr _vertexCount;
+
+    bool _valid;
+    glm::vec3 _lodOrigin;
+    float _projectionScale;
+
+    void _allocate(GLsizeiptr vertexCapacity);
+};
+
+#endif // TESSELLATION_CACHE_H
@@ -0,0 +1,106 @@
+#include "TransformFeedbackShaderProgram.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+CSCI441::TransformFeedbackShaderProgram::TransformFeedbackShaderProgram(
+    const char *vertexShaderFilename,
+    const char *tessellationControlShaderFilename,
+    const char *tessellationEvaluationShaderFilename,
+    const std::vector<const char *> &varyings, const GLenum bufferMode)
+    : ShaderProgram() {
+  mVertexShaderHandle = CSCI441_INTERNAL::ShaderUtils::compileShader(
+      vertexShaderFilename, GL_VERTEX_SHADER);
+  if (strcmp(tessellationControlShaderFilename, "") != 0) {
+    mTessellationControlShaderHandle =
+        CSCI441_INTERNAL::ShaderUtils::compileShader(
+            tessellationControlShaderFilename, GL_TESS_CONTROL_SHADER);
+  }
+  if (strcmp(tessellationEvaluationShaderFilename, "") != 0) {
+    mTessellationEvaluationShaderHandle =
+        CSCI441_INTERNAL::ShaderUtils::compileShader(
+            tessellationEvaluationShaderFilename, GL_TESS_EVALUATION_SHADER);
+  }
+
+  mShaderProgramHandle = glCreateProgram();
+  const GLuint stages[] = {mVertexShaderHandle,
+                           mTessellationControlShaderHandle,
+                           mTessellationEvaluationShaderHandle};
+  for (const GLuint stage : stages) {
+    if (stage != 0)
+      glAttachShader(mShaderProgramHandle, stage);
+  }
+
+  // has to be set before linking to take effect
+  glTransformFeedbackVaryings(mShaderProgramHandle,
+                              static_cast<GLsizei>(varyings.size()),
+                              varyings.data(), bufferMode);
+  glLinkProgram(mShaderProgramHandle);
+  CSCI441_INTERNAL::ShaderUtils::printProgramLog(mShaderProgramHandle);
+
+  for (const GLuint stage : stages) {
+    if (stage != 0) {
+      glDetachShader(mShaderProgramHandle, stage);
+      glDeleteShader(stage);
+    }
+  }
+
+  _mapLocations();
+
+  if (isLinked()) {
+    fprintf(stdout,
+            "[INFO]: transform feedback program %u from %s capturing %zu "
+            "varyings\n",
+            mShaderProgramHandle, vertexShaderFilename, varyings.size());
+  } else {
+    fprintf(stderr,
+            "[ERROR]: transform feedback program from %s failed to link\n",
+            vertexShaderFilename);
+  }
+}
+
+bool CSCI441::TransformFeedbackShaderProgram::isLinked() const {
+  GLint linkStatus = GL_FALSE;
+  glGetProgramiv(mShaderProgramHandle, GL_LINK_STATUS, &linkStatus);
+  return linkStatus == GL_TRUE;
+}
+
+void CSCI441::TransformFeedbackShaderProgram::_mapLocations() {
+  mpUniformLocationsMap = new std::map<std::string, GLint>();
+  mpAttributeLocationsMap = new std::map<std::string, GLint>();
+
+  GLint numUniforms = 0, maxUniformNameLength = 0;
+  glGetProgramiv(mShaderProgramHandle, GL_ACTIVE_UNIFORMS, &numUniforms);
+  glGetProgramiv(mShaderProgramHandle, GL_ACTIVE_UNIFORM_MAX_LENGTH,
+                 &maxUniformNameLength);
+  std::string name(static_cast<size_t>(maxUniformNameLength) + 1, '\0');
+  for (GLint i = 0; i < numUniforms; i++) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type;
+    glGetActiveUniform(mShaderProgramHandle, i, maxUniformNameLength, &length,
+                       &size, &type, &name[0]);
+    const std::string uniformName(name.c_str(), length);
+    mpUniformLocationsMap->emplace(
+        uniformName,
+        glGetUniformLocation(mShaderProgramHandle, uniformName.c_str()));
+  }
+
+  GLint numAttributes = 0, maxAttributeNameLength = 0;
+  glGetProgramiv(mShaderProgramHandle, GL_ACTIVE_ATTRIBUTES, &numAttributes);
+  glGetProgramiv(mShaderProgramHandle, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH,
+                 &maxAttributeNameLength);
+  name.assign(static_cast<size_t>(maxAttributeNameLength) + 1, '\0');
+  for (GLint i = 0; i < numAttributes; i++) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type;
+    glGetActiveAttrib(mShaderProgramHandle, i, maxAttributeNameLength, &length,
+                      &size, &type, &name[0]);
+    const std::string attributeName(name.c_str(), length);
+    mpAttributeLocationsMap->emplace(
+        attributeName,
+        glGetAttribLocation(mShaderProgramHandle, attributeName.c_str()));
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef TRANSFORM_FEEDBACK_SHADER_PROGRAM_H
+#define TRANSFORM_FEEDBACK_SHADER_PROGRAM_H
+
+#include <CSCI441/ShaderProgram.hpp>
+
+#include <vector>
+
+namespace CSCI441 {
+
+// A shader program whose last vertex processing stage writes into buffers
+// instead of the rasterizer. The varyings to capture have to be named before
+// the program is linked, which ShaderProgram's constructors leave no room
+// for, so this compiles and links the stages itself. There is no fragment
+// shader, draws with it belong between glEnable(GL_RASTERIZER_DISCARD) and
+// glDisable(GL_RASTERIZER_DISCARD).
+class TransformFeedbackShaderProgram : public ShaderProgram {
+public:
+  // the tessellation shaders are optional, pass "" to leave them out.
+  // varyings are captured in order, interleaved into one buffer with
+  // GL_INTERLEAVED_ATTRIBS or one buffer each with GL_SEPARATE_ATTRIBS
+  TransformFeedbackShaderProgram(const char *vertexShaderFilename,
+                                 const char *tessellationControlShaderFilename,
+                                 const char *tessellationEvaluationShaderFilename,
+                                 const std::vector<const char *> &varyings,
+                                 GLenum bufferMode = GL_INTERLEAVED_ATTRIBS);
+
+  // whether the program linked, a capture with a program that did not would
+  // leave its buffers untouched
+  bool isLinked() const;
+
+private:
+  // fills the name to location maps ShaderProgram's getters read
+  void _mapLocations();
+};
+
+} // namespace CSCI441
+
+#endif // TRANSFORM_FEEDBACK_SHADER_PROGRAM_H
@@ -0,0 +1,423 @@
+#include "WorldStreamer.h"
+#include "Frustum.h"
+#include "GLResources.h"
+#include "GridSeed.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+    constexpr int VERTICES_PER_SIDE = WorldStreamer::CHUNK_RESOLUTION + 1;
+    constexpr float SAMPLE_SPACING = WorldStreamer::CHUNK_SIZE / WorldStreamer::CHUNK_RESOLUTION;
+}
+
+WorldStreamer::WorldStreamer(const Generator& generator, unsigned int seed, int viewDistance,
+                             float reservedHalfSize)
+    : _generator(generator),
+      _seed(seed),
+      _viewDistance(viewDistance),
+      _reservedHalfSize(reservedHalfSize),
+      _synchronous(false),
+      _center({0, 0}),
+      _indexBuffer(0),
+      _numIndices(0),
+      _stopping(false)
+{
+    std::vector<GLushort> indices;
+    indices.reserve(6 * CHUNK_RESOLUTION * CHUNK_RESOLUTION);
+    for (int row = 0; row < CHUNK_RESOLUTION; ++row) {
+        for (int col = 0; col < CHUNK_RESOLUTION; ++col) {
+            const GLushort corner = row * VERTICES_PER_SIDE + col;
+            // counter clockwise seen from above
+            indices.push_back(corner);
+            indices.push_back(corner + VERTICES_PER_SIDE);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + VERTICES_PER_SIDE);
+            indices.push_back(corner + VERTICES_PER_SIDE + 1);
+        }
+    }
+    _numIndices = static_cast<GLsizei>(indices.size());
+    _indexBuffer = GLResources::createStaticBuffer(indices.size() * sizeof(GLushort), indices.data());
+
+    // leave a core for the render thread
+    const unsigned int cores = std::thread::hardware_concurrency();
+    const unsigned int numWorkers = std::clamp(cores > 1 ? cores - 1 : 1u, 1u, 4u);
+    for (unsigned int i = 0; i < numWorkers; ++i) {
+        _workers.emplace_back(&WorldStreamer::_workerLoop, this);
+    }
+
+    fprintf(stdout, "[INFO]: streaming %.0f unit chunks %d deep with %u workers\n",
+            CHUNK_SIZE, _viewDistance, numWorkers);
+}
+
+WorldStreamer::~WorldStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _jobs.clear();
+    }
+    _jobAvailable.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+
+    for (Chunk* chunk : _finished) {
+        delete chunk;
+    }
+    for (auto& entry : _chunks) {
+        delete entry.second;
+    }
+    for (const GPUSlot& slot : _gpuSlots) {
+        glDeleteVertexArrays(1, &slot.vao);
+        glDeleteBuffers(1, &slot.vbo);
+        glDeleteTextures(1, &slot.irradianceTexture);
+    }
+    glDeleteBuffers(1, &_indexBuffer);
+}
+
+WorldStreamer::ChunkCoord WorldStreamer::_coordOf(float x, float z) {
+    return {static_cast<int>(std::floor(x / CHUNK_SIZE)), static_cast<int>(std::floor(z / CHUNK_SIZE))};
+}
+
+int WorldStreamer::_distance(ChunkCoord coord) const {
+    return std::max(std::abs(coord.x - _center.x), std::abs(coord.z - _center.z));
+}
+
+bool WorldStreamer::isInRange(float x, float z) const {
+    // the same range update() evicts past
+    return _distance(_coordOf(x, z)) <= _viewDistance + 1;
+}
+
+void WorldStreamer::update(const glm::vec3& focus) {
+    _center = _coordOf(focus.x, focus.z);
+    _newSpawnPoints.clear();
+
+    // chunks are kept one ring past the view distance so walking back and
+    // forth over a border does not thrash
+    const int keepDistance = _viewDistance + 1;
+
+    std::vector<Chunk*> finished;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        finished.swap(_finished);
+
+        // drop queued requests that fell out of range
+        for (auto job = _jobs.begin(); job != _jobs.end();) {
+            if (_distance(*job) > keepDistance) {
+                _pending.erase(*job);
+                job = _jobs.erase(job);
+            } else {
+                ++job;
+            }
+        }
+    }
+
+    for (Chunk* chunk : finished) {
+        _pending.erase(chunk->coord);
+        if (_distance(chunk->coord) > keepDistance) {
+            delete chunk;
+            continue;
+        }
+        _newSpawnPoints.insert(_newSpawnPoints.end(), chunk->spawnPoints.begin(), chunk->spawnPoints.end());
+        _chunks[chunk->coord] = chunk;
+    }
+
+    // evict, and collect what still needs uploading
+    std::vector<Chunk*> notUploaded;
+    for (auto entry = _chunks.begin(); entry != _chunks.end();) {
+        if (_distance(entry->first) > keepDistance) {
+            _evict(entry->second);
+            entry = _chunks.erase(entry);
+            continue;
+        }
+        if (entry->second->gpuSlot < 0) notUploaded.push_back(entry->second);
+        ++entry;
+    }
+
+    // nearest first, a bounded number per frame
+    std::sort(notUploaded.begin(), notUploaded.end(), [this](const Chunk* a, const Chunk* b) {
+        return _distance(a->coord) < _distance(b->coord);
+    });
+    const size_t numUploads = std::min(notUploaded.size(), static_cast<size_t>(MAX_UPLOADS_PER_UPDATE));
+    for (size_t i = 0; i < numUploads; ++i) {
+        _upload(*notUploaded[i]);
+    }
+
+    // request whatever is missing, nearest rings first
+    std::vector<ChunkCoord> requests;
+    for (int ring = 0; ring <= _viewDistance; ++ring) {
+        for (int dz = -ring; dz <= ring; ++dz) {
+            for (int dx = -ring; dx <= ring; ++dx) {
+                if (std::max(std::abs(dx), std::abs(dz)) != ring) continue;
+                const ChunkCoord coord{_center.x + dx, _center.z + dz};
+                if (_chunks.count(coord) || _pending.count(coord)) continue;
+                requests.push_back(coord);
+                _pending.insert(coord);
+            }
+        }
+    }
+    if (_synchronous) {
+        // nearest rings first, the same order on every run
+        for (const ChunkCoord& coord : requests) {
+            Chunk* chunk = _generateChunk(coord);
+            _pending.erase(coord);
+            _newSpawnPoints.insert(_newSpawnPoints.end(), chunk->spawnPoints.begin(), chunk->spawnPoints.end());
+            _chunks[coord] = chunk;
+            _upload(*chunk);
+        }
+    } else if (!requests.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.insert(_jobs.end(), requests.begin(), requests.end());
+            // the player may have moved since older requests were queued
+            std::stable_sort(_jobs.begin(), _jobs.end(), [this](ChunkCoord a, ChunkCoord b) {
+                return _distance(a) < _distance(b);
+            });
+        }
+        _jobAvailable.notify_all();
+    }
+}
+
+void WorldStreamer::_workerLoop() {
+    while (true) {
+        ChunkCoord coord;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobAvailable.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_stopping) return;
+            coord = _jobs.front();
+            _jobs.pop_front();
+        }
+
+        Chunk* chunk = _generateChunk(coord);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _finished.push_back(chunk);
+        }
+    }
+}
+
+WorldStreamer::Chunk* WorldStreamer::_generateChunk(ChunkCoord coord) const {
+    Chunk* chunk = new Chunk();
+    chunk->coord = coord;
+    chunk->gpuSlot = -1;
+
+    const float originX = coord.x * CHUNK_SIZE;
+    const float originZ = coord.z * CHUNK_SIZE;
+
+    // one ring of samples past the edges so border normals match the
+    // neighbouring chunks
+    constexpr int paddedSide = VERTICES_PER_SIDE + 2;
+    std::vector<float> padded(paddedSide * paddedSide);
+    if (_generator.heightTile) {
+        _generator.heightTile(originX - SAMPLE_SPACING, originZ - SAMPLE_SPACING, SAMPLE_SPACING,
+                              paddedSide, paddedSide, padded.data());
+    } else {
+        for (int row = 0; row < paddedSide; ++row) {
+            for (int col = 0; col < paddedSide; ++col) {
+                padded[row * paddedSide + col] = _generator.height(originX + (col - 1) * SAMPLE_SPACING,
+                                                                   originZ + (row - 1) * SAMPLE_SPACING);
+            }
+        }
+    }
+
+    chunk->heights.resize(VERTICES_PER_SIDE * VERTICES_PER_SIDE);
+    chunk->vertices.resize(VERTICES_PER_SIDE * VERTICES_PER_SIDE);
+    chunk->irradiance.resize(VERTICES_PER_SIDE * VERTICES_PER_SIDE);
+    chunk->minHeight = padded[paddedSide + 1];
+    chunk->maxHeight = chunk->minHeight;
+    for (int row = 0; row < VERTICES_PER_SIDE; ++row) {
+        for (int col = 0; col < VERTICES_PER_SIDE; ++col) {
+            const float* center = &padded[(row + 1) * paddedSide + col + 1];
+            const float h = center[0];
+            const glm::vec3 normal = glm::normalize(glm::vec3((center[-1] - center[1]) / (2.0f * SAMPLE_SPACING), 1.0f,
+                                                              (center[-paddedSide] - center[paddedSide]) / (2.0f * SAMPLE_SPACING)));
+            const glm::vec3 position(originX + col * SAMPLE_SPACING, h, originZ + row * SAMPLE_SPACING);
+
+            const int index = row * VERTICES_PER_SIDE + col;
+            chunk->heights[index] = h;
+            // the irradiance texture has one texel per vertex, address their centers
+            chunk->vertices[index] = {position, normal,
+                                      glm::vec2((col + 0.5f) / VERTICES_PER_SIDE, (row + 0.5f) / VERTICES_PER_SIDE)};
+            chunk->irradiance[index] = _generator.groundIrradiance(position, normal);
+            chunk->minHeight = std::min(chunk->minHeight, h);
+            chunk->maxHeight = std::max(chunk->maxHeight, h);
+        }
+    }
+
+    // the same chunk always gets the same vegetation and spawns
+    std::mt19937 random(gridSeed(_seed, coord.x, coord.z));
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto inReservedArea = [this](float x, float z) {
+        return std::abs(x) < _reservedHalfSize && std::abs(z) < _reservedHalfSize;
+    };
+
+    for (int i = 0; i < VEGETATION_PER_CHUNK; ++i) {
+        const float x = originX + unit(random) * CHUNK_SIZE;
+        const float z = originZ + unit(random) * CHUNK_SIZE;
+        VegetationInstance bush;
+        bush.size = 1.5f + unit(random);
+        bush.color = glm::vec3(0.086f, 0.588f, 0.455f) + (glm::vec3(unit(random), unit(random), unit(random)) - 0.5f) * 0.15f;
+        if (inReservedArea(x, z)) continue;
+        bush.position = glm::vec3(x, _generator.height(x, z) + bush.size, z);
+        bush.bakedColor = bush.color * _generator.vegetationIrradiance(bush.position + glm::vec3(0.0f, bush.size, 0.0f));
+        chunk->vegetation.push_back(bush);
+    }
+
+    for (int i = 0; i < MAX_SPAWN_POINTS_PER_CHUNK; ++i) {
+        const float x = originX + unit(random) * CHUNK_SIZE;
+        const float z = originZ + unit(random) * CHUNK_SIZE;
+        const float heading = unit(random) * 2.0f * glm::pi<float>();
+        if (unit(random) < 0.5f || inReservedArea(x, z)) continue;
+        chunk->spawnPoints.push_back({glm::vec3(x, _generator.height(x, z) + 1.0f, z), heading});
+    }
+
+    return chunk;
+}
+
+int WorldStreamer::_acquireGPUSlot() {
+    if (!_freeGPUSlots.empty()) {
+        const int slot = _freeGPUSlots.back();
+        _freeGPUSlots.pop_back();
+        return slot;
+    }
+
+    // every chunk has the same size, so storage is allocated once per slot
+    GPUSlot slot;
+    slot.vbo = GLResources::createDynamicBuffer(VERTICES_PER_SIDE * VERTICES_PER_SIDE * sizeof(ChunkVertex), nullptr);
+    slot.vao = GLResources::createVertexArray();
+    GLResources::setVertexAttribute(slot.vao, 0, slot.vbo, 3, GL_FLOAT, sizeof(ChunkVertex),
+                                    offsetof(ChunkVertex, position));
+    GLResources::setVertexAttribute(slot.vao, 1, slot.vbo, 3, GL_FLOAT, sizeof(ChunkVertex),
+                                    offsetof(ChunkVertex, normal));
+    GLResources::setVertexAttribute(slot.vao, 2, slot.vbo, 2, GL_FLOAT, sizeof(ChunkVertex),
+                                    offsetof(ChunkVertex, lightmapCoord));
+    GLResources::setElementBuffer(slot.vao, _indexBuffer);
+    slot.irradianceTexture = GLResources::createTexture2D(
+        VERTICES_PER_SIDE, VERTICES_PER_SIDE, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr,
+        GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+    _gpuSlots.push_back(slot);
+    return static_cast<int>(_gpuSlots.size()) - 1;
+}
+
+void WorldStreamer::_upload(Chunk& chunk) {
+    chunk.gpuSlot = _acquireGPUSlot();
+    const GPUSlot& slot = _gpuSlots[chunk.gpuSlot];
+
+    GLResources::updateBuffer(slot.vbo, 0, chunk.vertices.size() * sizeof(ChunkVertex), chunk.vertices.data());
+    GLResources::updateTexture2D(slot.irradianceTexture, 0, 0, VERTICES_PER_SIDE, VERTICES_PER_SIDE,
+                                 GL_RGB, GL_FLOAT, chunk.irradiance.data());
+
+    // the GPU has its own copy now
+    std::vector<ChunkVertex>().swap(chunk.vertices);
+    std::vector<glm::vec3>().swap(chunk.irradiance);
+}
+
+void WorldStreamer::_evict(Chunk* chunk) {
+    if (chunk->gpuSlot >= 0) {
+        _freeGPUSlots.push_back(chunk->gpuSlot);
+    }
+    delete chunk;
+}
+
+void WorldStreamer::drawTerrain(const glm::mat4& viewProjectionMtx) const {
+    const Frustum frustum(viewProjectionMtx);
+    for (const auto& entry : _chunks) {
+        const Chunk& chunk = *entry.second;
+        if (chunk.gpuSlot < 0) continue;
+
+        const glm::vec3 boxMin(chunk.coord.x * CHUNK_SIZE, chunk.minHeight, chunk.coord.z * CHUNK_SIZE);
+        const glm::vec3 boxMax = boxMin + glm::vec3(CHUNK_SIZE, chunk.maxHeight - chunk.minHeight, CHUNK_SIZE);
+        if (!frustum.intersects(boxMin, boxMax)) continue;
+
+        const GPUSlot& slot = _gpuSlots[chunk.gpuSlot];
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, slot.irradianceTexture);
+        glBindVertexArray(slot.vao);
+        glDrawElements(GL_TRIANGLES, _numIndices, GL_UNSIGNED_SHORT, nullptr);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(0);
+}
+
+void WorldStreamer::forEachVisibleVegetation(const glm::mat4& viewProjectionMtx,
+                                             const std::function<void(const VegetationInstance&)>& visit) const {
+    const Frustum frustum(viewProjectionMtx);
+    for (const auto& entry : _chunks) {
+        const Chunk& chunk = *entry.second;
+        if (chunk.gpuSlot < 0 || chunk.vegetation.empty()) continue;
+
+        // bushes reach a little past the chunk and well above the ground
+        const glm::vec3 boxMin(chunk.coord.x * CHUNK_SIZE - 3.0f, chunk.minHeight, chunk.coord.z * CHUNK_SIZE - 3.0f);
+        const glm::vec3 boxMax(boxMin.x + CHUNK_SIZE + 6.0f, chunk.maxHeight + 6.0f, boxMin.z + CHUNK_SIZE + 6.0f);
+        if (!frustum.intersects(boxMin, boxMax)) continue;
+
+        for (const VegetationInstance& bush : chunk.vegetation) {
+            visit(bush);
+        }
+    }
+}
+
+void WorldStreamer::forEachVegetationNear(float x, float z, float radius,
+                                          const std::function<void(const VegetationInstance&)>& visit) const {
+    // bushes reach a little past their chunk
+    const float reach = radius + 3.0f;
+    const ChunkCoord first = _coordOf(x - reach, z - reach);
+    const ChunkCoord last = _coordOf(x + reach, z + reach);
+    for (int cz = first.z; cz <= last.z; ++cz) {
+        for (int cx = first.x; cx <= last.x; ++cx) {
+            const auto entry = _chunks.find({cx, cz});
+            // vegetation of a chunk that is not drawn yet is not there
+            if (entry == _chunks.end() || entry->second->gpuSlot < 0) continue;
+            for (const VegetationInstance& bush : entry->second->vegetation) {
+                visit(bush);
+            }
+        }
+    }
+}
+
+float WorldStreamer::height(float x, float z) const {
+    const ChunkCoord coord = _coordOf(x, z);
+    const auto entry = _chunks.find(coord);
+    if (entry == _chunks.end()) {
+        return _generator.height(x, z);
+    }
+
+    // bilinear between the chunk's samples, like the drawn grid
+    const Chunk& chunk = *entry->second;
+    const float s = std::clamp((x - coord.x * CHUNK_SIZE) / SAMPLE_SPACING, 0.0f, static_cast<float>(CHUNK_RESOLUTION));
+    const float t = std::clamp((z - coord.z * CHUNK_SIZE) / SAMPLE_SPACING, 0.0f, static_cast<float>(CHUNK_RESOLUTION));
+    const int col = std::min(static_cast<int>(s), CHUNK_RESOLUTION - 1);
+    const int row = std::min(static_cast<int>(t), CHUNK_RESOLUTION - 1);
+    const float fs = s - col;
+    const float ft = t - row;
+
+    const float* r0 = &chunk.heights[row * VERTICES_PER_SIDE + col];
+    const float* r1 = r0 + VERTICES_PER_SIDE;
+    const float h0 = r0[0] + (r0[1] - r0[0]) * fs;
+    const float h1 = r1[0] + (r1[1] - r1[0]) * fs;
+    return h0 + (h1 - h0) * ft;
+}
+
+void WorldStreamer::heights(const float* xs, const float* zs, float* outHeights,
+                            glm::vec3* outNormals, size_t count) const {
+    for (size_t n = 0; n < count; ++n) {
+        outHeights[n] = height(xs[n], zs[n]);
+    }
+
+    if (!outNormals) return;
+
+    for (size_t n = 0; n < count; ++n) {
+        const float dhdx = (height(xs[n] + SAMPLE_SPACING, zs[n]) - height(xs[n] - SAMPLE_SPACING, zs[n])) / (2.0f * SAMPLE_SPACING);
+        const float dhdz = (height(xs[n], zs[n] + SAMPLE_SPACING) - height(xs[n], zs[n] - SAMPLE_SPACING)) / (2.0f * SAMPLE_SPACING);
+        outNormals[n] = glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+    }
+}
@@ -0,0 +1,199 @@
+#ifndef WORLD_STREAMER_H
+#define WORLD_STREAMER_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// An open world split into square chunks keyed by grid coordinate.
+//
+// Chunks within the view distance of the focus point (the player) are
+// generated on worker threads: terrain heights and normals, the diffuse
+// lighting of every vertex, vegetation and enemy spawn points. The main
+// thread picks up finished chunks in update(), uploads a bounded number of
+// them per call into GPU buffers taken from a pool, and evicts chunks that
+// fell behind, handing their buffers back to the pool. Every chunk has the
+// same vertex count, so pooled buffers fit any chunk and steady state
+// streaming allocates nothing on the GPU. Memory is bounded by the view
+// distance, not by the size of the world.
+class WorldStreamer {
+public:
+    // what the workers call to fill a chunk, all of it must be safe to call
+    // from several threads at once
+    struct Generator {
+        // ground height at (x, z)
+        std::function<float(float x, float z)> height;
+        // optional, fills a width x depth grid of heights whose first sample
+        // is at (x0, z0) and whose samples are spacing apart. Chunks are
+        // sampled one height at a time without it
+        std::function<void(float x0, float z0, float spacing, int width, int depth, float* out)> heightTile;
+        // diffuse light reaching the ground at a position with a normal
+        std::function<glm::vec3(const glm::vec3& position, const glm::vec3& normal)> groundIrradiance;
+        // diffuse light reaching vegetation at a position
+        std::function<glm::vec3(const glm::vec3& position)> vegetationIrradiance;
+    };
+
+    // seed: makes vegetation and spawn points repeatable
+    // viewDistance: chunks kept around the focus in each direction
+    // reservedHalfSize: the square [-reservedHalfSize, reservedHalfSize] is
+    // left to the hand placed scene, no vegetation or spawns go there
+    WorldStreamer(const Generator& generator, unsigned int seed, int viewDistance, float reservedHalfSize);
+    ~WorldStreamer();
+
+    WorldStreamer(const WorldStreamer&) = delete;
+    WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+    // requests chunks around focus, uploads finished ones and evicts far ones
+    void update(const glm::vec3& focus);
+
+    // when set, update() generates and uploads every requested chunk itself
+    // before returning instead of leaving them to the workers, so the world
+    // around the focus does not depend on thread timing. Offline rendering
+    // uses it to get the same frames on every run
+    void setSynchronous(bool synchronous) { _synchronous = synchronous; }
+
+    // draws the terrain of every uploaded chunk in the frustum. The ground
+    // shader and texture (unit 0) must be bound, each chunk binds its own
+    // irradiance texture to unit 1
+    void drawTerrain(const glm::mat4& viewProjectionMtx) const;
+
+    // height at (x, z) from the chunk there, straight from the generator if
+    // it is not loaded
+    float height(float x, float z) const;
+
+    // heights of count points, normals may be null
+    void heights(const float* xs, const float* zs, float* outHeights,
+                 glm::vec3* outNormals, size_t count) const;
+
+    struct VegetationInstance {
+        glm::vec3 position; // center of the bush
+        glm::vec3 color;
+        float size;
+        // color lit by the static lights, see FPEngine::BushData
+        glm::vec3 bakedColor;
+    };
+
+    // calls visit(vegetation) for every resident chunk's vegetation that may
+    // be in the frustum
+    void forEachVisibleVegetation(const glm::mat4& viewProjectionMtx,
+                                  const std::function<void(const VegetationInstance&)>& visit) const;
+
+    // calls visit(vegetation) for every uploaded chunk's vegetation whose
+    // chunk lies within radius of (x, z), whether it is in view or not
+    void forEachVegetationNear(float x, float z, float radius,
+                               const std::function<void(const VegetationInstance&)>& visit) const;
+
+    struct SpawnPoint {
+        glm::vec3 position;
+        // radians, drawn from the chunk's own random sequence
+        float heading;
+    };
+
+    // spawn points of the chunks that became resident in the last update()
+    const std::vector<SpawnPoint>& getNewSpawnPoints() const { return _newSpawnPoints; }
+
+    // whether the chunk under (x, z) is close enough to the focus to be kept,
+    // true while it is still being generated. Anything outside is on a chunk
+    // that was evicted or never will be loaded
+    bool isInRange(float x, float z) const;
+
+    size_t getResidentChunkCount() const { return _chunks.size(); }
+    size_t getPooledBufferCount() const { return _gpuSlots.size(); }
+
+    static constexpr float CHUNK_SIZE = 64.0f;
+    // grid quads along the side of a chunk
+    static constexpr int CHUNK_RESOLUTION = 32;
+    // chunks uploaded per update(), keeps the upload cost of one frame flat
+    static constexpr int MAX_UPLOADS_PER_UPDATE = 4;
+    static constexpr int VEGETATION_PER_CHUNK = 12;
+    static constexpr int MAX_SPAWN_POINTS_PER_CHUNK = 1;
+
+private:
+    struct ChunkCoord {
+        int x;
+        int z;
+        bool operator==(const ChunkCoord& other) const { return x == other.x && z == other.z; }
+    };
+    struct ChunkCoordHash {
+        size_t operator()(const ChunkCoord& coord) const {
+            // pack the bits unsigned, shifting a negative x is undefined
+            return std::hash<uint64_t>()((static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) |
+                                         static_cast<uint32_t>(coord.z));
+        }
+    };
+
+    struct ChunkVertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 lightmapCoord;
+    };
+
+    struct Chunk {
+        ChunkCoord coord;
+        // (CHUNK_RESOLUTION + 1)^2 samples, row major, kept for height queries
+        std::vector<float> heights;
+        float minHeight;
+        float maxHeight;
+        // GPU data, released once uploaded
+        std::vector<ChunkVertex> vertices;
+        std::vector<glm::vec3> irradiance;
+        std::vector<VegetationInstance> vegetation;
+        std::vector<SpawnPoint> spawnPoints;
+        // index into _gpuSlots, -1 until uploaded
+        int gpuSlot;
+    };
+
+    // pooled GPU storage for one chunk
+    struct GPUSlot {
+        GLuint vao;
+        GLuint vbo;
+        GLuint irradianceTexture;
+    };
+
+    Generator _generator;
+    unsigned int _seed;
+    int _viewDistance;
+    float _reservedHalfSize;
+    bool _synchronous;
+
+    // resident chunks and requested ones, main thread only
+    std::unordered_map<ChunkCoord, Chunk*, ChunkCoordHash> _chunks;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> _pending;
+    std::vector<SpawnPoint> _newSpawnPoints;
+    ChunkCoord _center;
+
+    std::vector<GPUSlot> _gpuSlots;
+    std::vector<int> _freeGPUSlots;
+    // every chunk shares the same triangulation
+    GLuint _indexBuffer;
+    GLsizei _numIndices;
+
+    // worker state, guarded by _mutex
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _jobAvailable;
+    std::deque<ChunkCoord> _jobs;
+    std::vector<Chunk*> _finished;
+    bool _stopping;
+
+    void _workerLoop();
+    Chunk* _generateChunk(ChunkCoord coord) const;
+    void _upload(Chunk& chunk);
+    void _evict(Chunk* chunk);
+    int _acquireGPUSlot();
+
+    static ChunkCoord _coordOf(float x, float z);
+    int _distance(ChunkCoord coord) const;
+};
+
+#endif // WORLD_STREAMER_H
@@ -19,11 +19,76 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+#include <cstdlib>
+#include <cstring>
+
 ///*****************************************************************************
 //
 // Our main function
-int main() {
+//
+// usage: FP [--offline <frames> [output directory]]
+//           [--heightmap <image> [half size] [height scale]]
+//           [--procedural <seed> [half size] [height scale]] [--open-world]
+//           [--cache-ground] [--elsters <count>]
+//   --offline renders a fixed time step sequence with a fixed seed as fast as
+//   possible and writes every frame as a PNG (to ./captures by default)
+//   --heightmap replaces the hill with a grayscale heightmap image spanning
+//   [-half size, half size] (440 by default) whose white pixels are height
+//   scale (100 by default) high
+//   --procedural generates the terrain from fractal noise with the given
+//   seed, the same seed always gives the same terrain. Half size is 440 and
+//   height scale 60 by default
+//   --open-world streams an endless world in around the ground instead of
+//   ending it at the ground's edge
+//   --cache-ground draws the tessellated ground from a transform feedback
+//   capture that is only redone when the camera moved far enough, always on
+//   with software renderers
+//   --elsters sets how many enemy Elsters chase the player, 1 by default
+int main(int argc, char *argv[]) {
   const auto labEngine = new FPEngine();
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--offline") == 0 && i + 1 < argc) {
+      const int numFrames = atoi(argv[++i]);
+      const char *outputDirectory =
+          (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "captures";
+      labEngine->setOfflineMode(numFrames, outputDirectory);
+    } else if (strcmp(argv[i], "--heightmap") == 0 && i + 1 < argc) {
+      const char *filename = argv[++i];
+      float halfSize = 440.0f;
+      float heightScale = 100.0f;
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        halfSize = static_cast<float>(atof(argv[++i]));
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        heightScale = static_cast<float>(atof(argv[++i]));
+      labEngine->setHeightmap(filename, halfSize, heightScale);
+    } else if (strcmp(argv[i], "--procedural") == 0 && i + 1 < argc) {
+      const auto seed =
+          static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+      float halfSize = 440.0f;
+      float heightScale = 60.0f;
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        halfSize = static_cast<float>(atof(argv[++i]));
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        heightScale = static_cast<float>(atof(argv[++i]));
+      labEngine->setProceduralTerrain(seed, halfSize, heightScale);
+    } else if (strcmp(argv[i], "--open-world") == 0) {
+      labEngine->setOpenWorld(true);
+    } else if (strcmp(argv[i], "--cache-ground") == 0) {
+      labEngine->setCachedGround(true);
+    } else if (strcmp(argv[i], "--elsters") == 0 && i + 1 < argc) {
+      labEngine->setEnemyElsters(atoi(argv[++i]));
+    } else {
+      fprintf(stderr, "[ERROR]: unknown argument \"%s\"\n", argv[i]);
+      fprintf(stderr,
+              "usage: %s [--offline <frames> [output directory]] "
+              "[--heightmap <image> [half size] [height scale]] "
+              "[--procedural <seed> [half size] [height scale]] "
+              "[--open-world] [--cache-ground] [--elsters <count>]\n",
+              argv[0]);
+      delete labEngine;
+      return EXIT_FAILURE;
+    }
+  }
   labEngine->initialize();
   if (labEngine->getError() ==
       CSCI441::OpenGLEngine::OPENGL_ENGINE_ERROR_NO_ERROR) {
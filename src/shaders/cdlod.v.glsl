@@ -0,0 +1,64 @@
+#version 410 core
+
+// CDLOD terrain: a grid covering a quarter of a quadtree node, instanced per
+// selected quarter and displaced by the heightmap. Shares ground.f.glsl with
+// the tessellated ground
+
+layout(location = 0) in vec2 vGridPos;         // [0, 1] across the quarter
+layout(location = 1) in vec4 instanceQuadrant; // xy minimum corner, z size, w level
+
+out vec3 worldPos;
+out vec3 fragNormal;
+out vec2 fragTexCoord;
+out vec2 fragLightmapCoord;
+
+uniform mat4 mvpMatrix;
+uniform vec3 cameraPosition;
+
+uniform sampler2D heightmapTexture;
+uniform vec2 terrainMin;        // minimum x and z corner of the map
+uniform vec2 terrainSize;       // extent of the map in x and z
+uniform vec2 heightmapSize;     // samples along x and z
+uniform float quadrantResolution = 16.0;
+uniform vec2 morphRanges[10];   // per level (start, end) of the morph
+uniform float textureScale;     // ground texture repeats per unit
+
+// heightmap samples sit on the map's edges, so address texel centers
+float sampleHeight(vec2 xz) {
+    vec2 st = (xz - terrainMin) / terrainSize;
+    vec2 uv = (st * (heightmapSize - 1.0) + 0.5) / heightmapSize;
+    return textureLod(heightmapTexture, uv, 0.0).r;
+}
+
+void main() {
+    vec2 origin = instanceQuadrant.xy;
+    float size = instanceQuadrant.z;
+    int lod = int(instanceQuadrant.w);
+
+    vec2 xz = origin + vGridPos * size;
+
+    // morph towards the next coarser level over the far end of this level's
+    // range by sliding odd vertices onto their even neighbours
+    float dist = distance(cameraPosition, vec3(xz.x, sampleHeight(xz), xz.y));
+    vec2 morphRange = morphRanges[lod];
+    float morph = clamp((dist - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+    vec2 oddOffset = fract(vGridPos * quadrantResolution * 0.5) * 2.0 / quadrantResolution;
+    xz -= oddOffset * size * morph;
+
+    // nodes can hang over the far edges of the map
+    xz = min(xz, terrainMin + terrainSize);
+
+    float height = sampleHeight(xz);
+
+    // normal from central differences one sample apart, as Heightmap::normal
+    vec2 spacing = terrainSize / (heightmapSize - 1.0);
+    float dhdx = (sampleHeight(xz + vec2(spacing.x, 0.0)) - sampleHeight(xz - vec2(spacing.x, 0.0))) / (2.0 * spacing.x);
+    float dhdz = (sampleHeight(xz + vec2(0.0, spacing.y)) - sampleHeight(xz - vec2(0.0, spacing.y))) / (2.0 * spacing.y);
+
+    worldPos = vec3(xz.x, height, xz.y);
+    fragNormal = normalize(vec3(-dhdx, 1.0, -dhdz));
+    fragTexCoord = xz * textureScale;
+    fragLightmapCoord = (xz - terrainMin) / terrainSize;
+
+    gl_Position = mvpMatrix * vec4(worldPos, 1.0);
+}
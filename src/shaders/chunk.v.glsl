@@ -0,0 +1,26 @@
+#version 410 core
+
+// streamed open world terrain chunk, already in world space. Shares
+// ground.f.glsl with the other grounds, the chunk's own irradiance texture
+// stands in for the lightmap
+
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vLightmapCoord;
+
+out vec3 worldPos;
+out vec3 fragNormal;
+out vec2 fragTexCoord;
+out vec2 fragLightmapCoord;
+
+uniform mat4 mvpMatrix;
+uniform float textureScale; // ground texture repeats per unit
+
+void main() {
+    worldPos = vPos;
+    fragNormal = vNormal;
+    fragTexCoord = vPos.xz * textureScale;
+    fragLightmapCoord = vLightmapCoord;
+
+    gl_Position = mvpMatrix * vec4(vPos, 1.0);
+}
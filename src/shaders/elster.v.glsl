@@ -1,18 +1,15 @@
 #version 410 core
 
-layout(location = 0) in vec3 vPos;
-layout(location = 1) in vec3 vNormal;
-layout(location = 2) in ivec4 vJoints;
-layout(location = 3) in vec4 vWeights;
 layout(location = 4) in vec2 vTexCoord;
 
-uniform mat4 mvpMatrix;
-uniform mat3 normalMatrix;
-uniform mat4 modelMatrix;
+uniform mat4 viewProjectionMatrix;
 
-const int MAX_JOINTS = 100;
-uniform mat4 jointMatrices[MAX_JOINTS];
-uniform bool useSkinning = false;
+// the vertices elsterskin.v.glsl skinned this frame, two texels each (world
+// position, world normal): a primitive's vertices for every character of the
+// draw, one character after another from firstSkinnedVertex
+uniform samplerBuffer skinnedVertices;
+uniform int firstSkinnedVertex;
+uniform int vertexCount;
 
 uniform vec3 lightDirection;
 uniform vec3 lightColor;
@@ -37,31 +34,13 @@ out vec3 fragLightColor;
 out vec2 fragTexCoord;
 
 void main() {
-    vec4 position = vec4(vPos, 1.0);
-    vec3 normal = vNormal;
-
-    // handles character skinning
-    if (useSkinning && vWeights.x > 0.0) {
-        mat4 skinMatrix =
-            vWeights.x * jointMatrices[vJoints.x] +
-            vWeights.y * jointMatrices[vJoints.y] +
-            vWeights.z * jointMatrices[vJoints.z] +
-            vWeights.w * jointMatrices[vJoints.w];
-
-        position = skinMatrix * position;
-        // Use inverse transpose for proper normal transformation
-        mat3 skinNormalMatrix = transpose(inverse(mat3(skinMatrix)));
-        normal = skinNormalMatrix * normal;
-    }
+    // gl_VertexID is the index, which picks this character's copy of it
+    int vertex = firstSkinnedVertex + gl_InstanceID * vertexCount + gl_VertexID;
+    vec3 worldPos = texelFetch(skinnedVertices, vertex * 2).xyz;
+    vec3 normalTransformed = texelFetch(skinnedVertices, vertex * 2 + 1).xyz;
 
     // transform & output the vertex in clip space
-    gl_Position = mvpMatrix * position;
-
-    // Calculate world space position
-    vec3 worldPos = (modelMatrix * position).xyz;
-
-    // Transform normal to world space
-    vec3 normalTransformed = normalize(normalMatrix * normal);
+    gl_Position = viewProjectionMatrix * vec4(worldPos, 1.0);
 
     // Pass data to fragment shader for per-pixel lighting
     fragNormal = normalTransformed;
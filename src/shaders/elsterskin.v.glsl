@@ -0,0 +1,70 @@
+#version 410 core
+
+// skins every vertex of a character primitive once a frame into world space,
+// captured with transform feedback for elster.v.glsl to draw from in every
+// view
+
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in ivec4 vJoints;
+layout(location = 3) in vec4 vWeights;
+
+// every character of the draw, one after another from firstInstanceTexel:
+// its model matrix, then jointCount joint matrices of four texels, then
+// jointCount normal matrices of three texels
+uniform samplerBuffer instanceData;
+uniform int firstInstanceTexel;
+uniform int jointCount;
+// the joints and weights of unskinned primitives are not bound, the current
+// attribute values read there would be taken for a weight of one on joint 0
+uniform bool hasSkin;
+
+out vec3 skinnedPosition;
+out vec3 skinnedNormal;
+
+mat4 fetchMatrix(int texel) {
+    return mat4(texelFetch(instanceData, texel),
+                texelFetch(instanceData, texel + 1),
+                texelFetch(instanceData, texel + 2),
+                texelFetch(instanceData, texel + 3));
+}
+
+mat3 fetchNormalMatrix(int texel) {
+    return mat3(texelFetch(instanceData, texel).xyz,
+                texelFetch(instanceData, texel + 1).xyz,
+                texelFetch(instanceData, texel + 2).xyz);
+}
+
+void main() {
+    int instanceTexel = firstInstanceTexel + gl_InstanceID * (4 + jointCount * 7);
+    mat4 modelMatrix = fetchMatrix(instanceTexel);
+    int paletteTexel = instanceTexel + 4;
+    int normalPaletteTexel = paletteTexel + jointCount * 4;
+
+    vec4 position = vec4(vPos, 1.0);
+    vec3 normal = vNormal;
+
+    // a skinned vertex may still leave its first weight empty
+    if (hasSkin && dot(vWeights, vec4(1.0)) > 0.0) {
+        mat4 skinMatrix =
+            vWeights.x * fetchMatrix(paletteTexel + vJoints.x * 4) +
+            vWeights.y * fetchMatrix(paletteTexel + vJoints.y * 4) +
+            vWeights.z * fetchMatrix(paletteTexel + vJoints.z * 4) +
+            vWeights.w * fetchMatrix(paletteTexel + vJoints.w * 4);
+
+        position = skinMatrix * position;
+        // the joints' inverse transposes are blended the same way, they were
+        // inverted once per joint on the CPU
+        mat3 skinNormalMatrix =
+            vWeights.x * fetchNormalMatrix(normalPaletteTexel + vJoints.x * 3) +
+            vWeights.y * fetchNormalMatrix(normalPaletteTexel + vJoints.y * 3) +
+            vWeights.z * fetchNormalMatrix(normalPaletteTexel + vJoints.z * 3) +
+            vWeights.w * fetchNormalMatrix(normalPaletteTexel + vJoints.w * 3);
+        normal = skinNormalMatrix * normal;
+    }
+
+    // characters are only rotated and uniformly scaled, so the model matrix
+    // itself transforms the normal
+    skinnedPosition = (modelMatrix * position).xyz;
+    skinnedNormal = normalize(mat3(modelMatrix) * normal);
+}
@@ -0,0 +1,23 @@
+#version 410 core
+
+// grass blades lit by the ground's baked lightmap, darker near the roots
+// where the blades shade each other
+
+in vec2 fragLightmapCoord;
+in float bladeT;
+in float bladeShade;
+
+out vec4 fragColorOut;
+
+uniform sampler2D lightmapTexture;
+
+const vec3 ROOT_COLOR = vec3(0.05, 0.25, 0.06);
+const vec3 TIP_COLOR = vec3(0.35, 0.6, 0.15);
+
+void main() {
+    vec3 irradiance = texture(lightmapTexture, fragLightmapCoord).rgb;
+    vec3 albedo = mix(ROOT_COLOR, TIP_COLOR, bladeT) * bladeShade;
+    float occlusion = mix(0.5, 1.0, bladeT);
+
+    fragColorOut = vec4(albedo * irradiance * occlusion, 1.0);
+}
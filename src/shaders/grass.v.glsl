@@ -0,0 +1,59 @@
+#version 410 core
+
+// instanced grass blades, see GrassField
+
+layout(location = 0) in vec2 vBlade;              // x across in [-1, 1], y up in [0, 1]
+layout(location = 1) in vec4 instanceRootFacing;  // xyz = root on the ground, w = facing in radians
+layout(location = 2) in vec4 instanceShape;       // height, width, wind phase, rank
+
+uniform mat4 viewProjectionMatrix;
+uniform vec3 cameraPosition;
+uniform float time;
+uniform vec2 windDirection;  // unit length
+uniform float windStrength;  // sideways lean of a tip per unit of blade height
+uniform vec2 densityRange;   // (full density distance, no grass distance)
+uniform vec2 groundMin;      // the lightmap spans the whole ground
+uniform vec2 groundSize;
+
+out vec2 fragLightmapCoord;
+out float bladeT;
+out float bladeShade;
+
+void main() {
+    vec3 root = instanceRootFacing.xyz;
+    float facing = instanceRootFacing.w;
+    float height = instanceShape.x;
+    float width = instanceShape.y;
+    float phase = instanceShape.z;
+    float rank = instanceShape.w;
+
+    // thin out with distance: blades whose rank the density here no longer
+    // reaches shrink away instead of popping
+    float distanceToCamera = length(root - cameraPosition);
+    float density = clamp((densityRange.y - distanceToCamera) / (densityRange.y - densityRange.x), 0.0, 1.0);
+    float visibility = clamp((density - rank) * 20.0, 0.0, 1.0);
+    height *= visibility;
+    width *= visibility;
+
+    // wind: gusts rolling along the wind direction and a quicker flutter of
+    // every blade on its own
+    float gust = sin(dot(root.xz, windDirection) * 0.15 - time * 1.3) * 0.5 + 0.5;
+    float flutter = sin(time * 3.1 + phase) * 0.15;
+    vec2 sway = windDirection * windStrength * (0.3 + 0.7 * gust) + vec2(cos(phase), sin(phase)) * flutter;
+
+    // the blade tapers to its tip and bends more the higher up it is, the
+    // tip dropping a little so it keeps roughly its length
+    float t = vBlade.y;
+    float bend = t * t;
+    vec3 across = vec3(cos(facing), 0.0, sin(facing));
+    vec3 position = root
+                  + across * (vBlade.x * 0.5 * width * (1.0 - t))
+                  + vec3(sway.x * bend * height,
+                         t * height * (1.0 - 0.3 * dot(sway, sway) * bend),
+                         sway.y * bend * height);
+
+    gl_Position = viewProjectionMatrix * vec4(position, 1.0);
+    fragLightmapCoord = (root.xz - groundMin) / groundSize;
+    bladeT = t;
+    bladeShade = 0.85 + 0.15 * sin(phase * 3.0);
+}
@@ -1,14 +1,18 @@
 #version 410 core
 
 // Fragment shader for textured ground with lighting
+// the diffuse & ambient terms of every static light are baked into
+// lightmapTexture, only the view dependent specular is computed here
 
 in vec3 worldPos;
 in vec3 fragNormal;
 in vec2 fragTexCoord;
+in vec2 fragLightmapCoord;
 
 out vec4 fragColorOut;
 
 uniform sampler2D groundTexture;
+uniform sampler2D lightmapTexture;
 uniform vec3 lightDirection;
 uniform vec3 lightColor;
 uniform vec3 lightPosition;
@@ -22,44 +26,33 @@ void main() {
     // Sample texture
     vec4 texColor = texture(groundTexture, fragTexCoord);
 
+    // Baked ambient + diffuse irradiance
+    vec3 irradiance = texture(lightmapTexture, fragLightmapCoord).rgb;
+
     // Normalize interpolated normal
     vec3 normal = normalize(fragNormal);
+    vec3 viewVec = normalize(cameraPosition - worldPos);
 
     // DIRECTIONAL LIGHT
     vec3 lightVec = normalize(lightDirection);
-    vec3 diffuse = lightColor * texColor.rgb * max(dot(normal, lightVec), 0.0);
-
-    // Specular
-    vec3 viewVec = normalize(cameraPosition - worldPos);
     vec3 reflectVec = reflect(-lightVec, normal);
     float spec = pow(max(dot(viewVec, reflectVec), 0.0), 32.0);
     vec3 specular = vec3(0.3) * spec;
 
-    vec3 dirColor = diffuse + specular;
-
     // POINT LIGHT
     vec3 posLightVec = normalize(lightPosition - worldPos);
-    vec3 posDiffuse = max(dot(normal, posLightVec), 0.0) * pointLightColor * texColor.rgb;
-
     vec3 posReflectVec = reflect(-posLightVec, normal);
     float posSpec = pow(max(dot(viewVec, posReflectVec), 0.0), 32.0);
-    vec3 posSpecular = vec3(0.3) * posSpec * pointLightColor;
 
-    // Attenuation
     float pointDistance = length(lightPosition - worldPos);
     float pointAttenuation = 1.0 / (1.0 + 0.09 * pointDistance + 0.032 * (pointDistance * pointDistance));
 
-    vec3 pointColor = (posDiffuse + posSpecular) * pointAttenuation;
+    vec3 posSpecular = vec3(0.3) * posSpec * pointLightColor * pointAttenuation;
 
     // SPOTLIGHT
-    vec3 lightToSurfaceDir = normalize(worldPos - spotLightPosition);
-    vec3 spotLightDir = normalize(-lightToSurfaceDir);
-
-    vec3 spotDiffuse = max(dot(normal, spotLightDir), 0.0) * texColor.rgb * spotLightColor;
-
+    vec3 spotLightDir = normalize(spotLightPosition - worldPos);
     vec3 spotReflectVec = reflect(-spotLightDir, normal);
     float spotSpec = pow(max(dot(viewVec, spotReflectVec), 0.0), 32.0);
-    vec3 spotSpecular = vec3(0.3) * spotSpec * spotLightColor;
 
     // Spotlight cone
     float innerCut = cos(radians(30.0));
@@ -67,17 +60,13 @@ void main() {
     float theta = dot(spotLightDir, normalize(-spotLightDirection));
     float intensity = smoothstep(outerCut, innerCut, theta);
 
-    // Attenuation
     float distance = length(spotLightPosition - worldPos);
     float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * (distance * distance));
 
-    vec3 spotColor = (spotDiffuse + spotSpecular) * intensity * attenuation;
-
-    // Ambient
-    vec3 ambient = vec3(0.3, 0.3, 0.3) * texColor.rgb;
+    vec3 spotSpecular = vec3(0.3) * spotSpec * spotLightColor * intensity * attenuation;
 
-    // Combine all lighting
-    vec3 finalColor = ambient + dirColor + pointColor + spotColor;
+    // Combine baked and runtime lighting
+    vec3 finalColor = texColor.rgb * irradiance + specular + posSpecular + spotSpecular;
 
     fragColorOut = vec4(finalColor, texColor.a);
 }
@@ -10,7 +10,57 @@ out vec3 tePos[];
 out vec3 teNormal[];
 out vec2 teTexCoord[];
 
-uniform float tessLevel = 32.0; // Tessellation level
+uniform mat4 mvpMatrix;
+uniform float projectionScale;         // pixels per unit at distance one
+uniform float targetEdgePixels = 16.0; // on screen length of a tessellated edge
+uniform float maxTessLevel = 64.0;
+
+// how far the curved surface can rise above or dip below the patch corners
+const float CULL_MARGIN = 2.0;
+// and how far the displacement in ground.tes.glsl can move it on top of that
+uniform float displacementMargin = 0.0;
+
+// set when the patches are captured into a TessellationCache instead of
+// drawn: every patch is kept and edges are sized by their distance to
+// lodOrigin, so the capture holds up whichever way the camera there turns
+uniform bool captureAll = false;
+uniform vec3 lodOrigin;
+
+// tessellation level for the edge between two corners. Only the edge's own
+// corners go in, so the patches on either side of it agree on the level
+float edgeLevel(vec3 p0, vec3 p1) {
+    // size the edge by the sphere around it, which stays sensible for edges
+    // that cross the camera plane
+    vec3 center = 0.5 * (p0 + p1);
+    float diameter = distance(p0, p1);
+    float depth = captureAll ? max(distance(center, lodOrigin), 0.1)
+                             : max((mvpMatrix * vec4(center, 1.0)).w, 0.1);
+    float pixels = diameter * projectionScale / depth;
+    return clamp(pixels / targetEdgePixels, 1.0, maxTessLevel);
+}
+
+// true if the patch's bounding box is entirely outside one frustum plane
+bool outsideFrustum() {
+    float margin = CULL_MARGIN + displacementMargin;
+    vec3 lo = min(min(tcPos[0], tcPos[1]), min(tcPos[2], tcPos[3])) - vec3(0.0, margin, 0.0);
+    vec3 hi = max(max(tcPos[0], tcPos[1]), max(tcPos[2], tcPos[3])) + vec3(0.0, margin, 0.0);
+
+    // count the box corners outside each plane
+    int left = 0, right = 0, bottom = 0, top = 0, nearPlane = 0, farPlane = 0;
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = vec3((i & 1) == 0 ? lo.x : hi.x,
+                           (i & 2) == 0 ? lo.y : hi.y,
+                           (i & 4) == 0 ? lo.z : hi.z);
+        vec4 clip = mvpMatrix * vec4(corner, 1.0);
+        if (clip.x < -clip.w) ++left;
+        if (clip.x >  clip.w) ++right;
+        if (clip.y < -clip.w) ++bottom;
+        if (clip.y >  clip.w) ++top;
+        if (clip.z < -clip.w) ++nearPlane;
+        if (clip.z >  clip.w) ++farPlane;
+    }
+    return left == 8 || right == 8 || bottom == 8 || top == 8 || nearPlane == 8 || farPlane == 8;
+}
 
 void main() {
     // vertex data
@@ -20,14 +70,25 @@ void main() {
 
     // set tessellation levels
     if (gl_InvocationID == 0) {
-        // Outer tessellation levels 
-        gl_TessLevelOuter[0] = tessLevel;
-        gl_TessLevelOuter[1] = tessLevel;
-        gl_TessLevelOuter[2] = tessLevel;
-        gl_TessLevelOuter[3] = tessLevel;
-
-        // Inner tessellation levels 
-        gl_TessLevelInner[0] = tessLevel;
-        gl_TessLevelInner[1] = tessLevel;
+        // a zero level discards the patch
+        if (!captureAll && outsideFrustum()) {
+            gl_TessLevelOuter[0] = 0.0;
+            gl_TessLevelOuter[1] = 0.0;
+            gl_TessLevelOuter[2] = 0.0;
+            gl_TessLevelOuter[3] = 0.0;
+            gl_TessLevelInner[0] = 0.0;
+            gl_TessLevelInner[1] = 0.0;
+            return;
+        }
+
+        // Outer tessellation levels, corners are (-x,-z), (+x,-z), (-x,+z), (+x,+z)
+        gl_TessLevelOuter[0] = edgeLevel(tcPos[0], tcPos[2]); // u = 0
+        gl_TessLevelOuter[1] = edgeLevel(tcPos[0], tcPos[1]); // v = 0
+        gl_TessLevelOuter[2] = edgeLevel(tcPos[1], tcPos[3]); // u = 1
+        gl_TessLevelOuter[3] = edgeLevel(tcPos[2], tcPos[3]); // v = 1
+
+        // Inner tessellation levels follow the finer of the opposite edges
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
     }
 }
@@ -9,187 +9,26 @@ in vec2 teTexCoord[];
 out vec3 worldPos;
 out vec3 fragNormal;
 out vec2 fragTexCoord;
+out vec2 fragLightmapCoord;
 
 uniform mat4 mvpMatrix;
 uniform mat4 modelMatrix;
 uniform mat3 normalMatrix;
-uniform float hillHeight = 56.25; // Maximum height of the mountain
 
-// Bezier curve evaluation for 4 control points
-vec3 bezierCurve(vec3 p0, vec3 p1, vec3 p2, vec3 p3, float t) {
-    float t2 = t * t;
-    float t3 = t2 * t;
-    float mt = 1.0 - t;
-    float mt2 = mt * mt;
-    float mt3 = mt2 * mt;
+// bicubic Bezier control points of the whole ground, row by row with rows
+// along z and columns along x, shared with the CPU height queries in Terrain
+uniform vec3 controlPoints[16];
 
-    return mt3 * p0 + 3.0 * mt2 * t * p1 + 3.0 * mt * t2 * p2 + t3 * p3;
-}
+// gameplay offsets on top of the surface spanning the whole ground, kept in
+// step with the CPU copy in TerrainDeformation
+uniform sampler2D displacementTexture;
+uniform float displacementResolution;  // samples along each side
 
-// Derivative of Bezier curve for computing tangents
-vec3 bezierCurveDerivative(vec3 p0, vec3 p1, vec3 p2, vec3 p3, float t) {
-    float t2 = t * t;
+// cubic Bernstein basis and its derivative at t
+void bernstein(float t, out vec4 b, out vec4 db) {
     float mt = 1.0 - t;
-    float mt2 = mt * mt;
-
-    return 3.0 * mt2 * (p1 - p0) + 6.0 * mt * t * (p2 - p1) + 3.0 * t2 * (p3 - p2);
-}
-
-// get control point
-vec3 getControlPoint(vec3 p00, vec3 p10, vec3 p01, vec3 p11, int i, int j) {
-    // Row 0 (bottom edge)
-    if (i == 0 && j == 0) return p00;
-    if (i == 0 && j == 1) return mix(p00, p10, 0.333) + vec3(0, hillHeight * 0.1, 0);
-    if (i == 0 && j == 2) return mix(p00, p10, 0.667) + vec3(0, hillHeight * 0.1, 0);
-    if (i == 0 && j == 3) return p10;
-
-    // Row 1 (first interior row)
-    if (i == 1 && j == 0) return mix(p00, p01, 0.333) + vec3(0, hillHeight * 0.1, 0);
-    if (i == 1 && j == 1) return mix(mix(p00, p10, 0.333), mix(p01, p11, 0.333), 0.333) + vec3(0, hillHeight * 0.6, 0);
-    if (i == 1 && j == 2) return mix(mix(p00, p10, 0.667), mix(p01, p11, 0.667), 0.333) + vec3(0, hillHeight * 0.6, 0);
-    if (i == 1 && j == 3) return mix(p10, p11, 0.333) + vec3(0, hillHeight * 0.1, 0);
-
-    // Row 2 (second interior row)
-    if (i == 2 && j == 0) return mix(p00, p01, 0.667) + vec3(0, hillHeight * 0.1, 0);
-    if (i == 2 && j == 1) return mix(mix(p00, p10, 0.333), mix(p01, p11, 0.333), 0.667) + vec3(0, hillHeight * 0.6, 0);
-    if (i == 2 && j == 2) return mix(mix(p00, p10, 0.667), mix(p01, p11, 0.667), 0.667) + vec3(0, hillHeight * 0.6, 0);
-    if (i == 2 && j == 3) return mix(p10, p11, 0.667) + vec3(0, hillHeight * 0.1, 0);
-
-    // Row 3 (top edge)
-    if (i == 3 && j == 0) return p01;
-    if (i == 3 && j == 1) return mix(p01, p11, 0.333) + vec3(0, hillHeight * 0.1, 0);
-    if (i == 3 && j == 2) return mix(p01, p11, 0.667) + vec3(0, hillHeight * 0.1, 0);
-    if (i == 3 && j == 3) return p11;
-
-    return vec3(0.0); // fail case
-}
-
-// Bezier interpolation
-vec3 bezierInterpolate(float u, float v) {
-    // 4 corner positions from the patch
-    vec3 p00 = tePos[0];
-    vec3 p10 = tePos[1];
-    vec3 p01 = tePos[2];
-    vec3 p11 = tePos[3];
-
-    // evaluate 4 Bezier curves along u direction
-    vec3 curve0 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 0, 0),
-        getControlPoint(p00, p10, p01, p11, 0, 1),
-        getControlPoint(p00, p10, p01, p11, 0, 2),
-        getControlPoint(p00, p10, p01, p11, 0, 3),
-        u
-    );
-
-    vec3 curve1 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 1, 0),
-        getControlPoint(p00, p10, p01, p11, 1, 1),
-        getControlPoint(p00, p10, p01, p11, 1, 2),
-        getControlPoint(p00, p10, p01, p11, 1, 3),
-        u
-    );
-
-    vec3 curve2 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 2, 0),
-        getControlPoint(p00, p10, p01, p11, 2, 1),
-        getControlPoint(p00, p10, p01, p11, 2, 2),
-        getControlPoint(p00, p10, p01, p11, 2, 3),
-        u
-    );
-
-    vec3 curve3 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 3, 0),
-        getControlPoint(p00, p10, p01, p11, 3, 1),
-        getControlPoint(p00, p10, p01, p11, 3, 2),
-        getControlPoint(p00, p10, p01, p11, 3, 3),
-        u
-    );
-
-    // evaluate final curve through those 4 results along v direction
-    return bezierCurve(curve0, curve1, curve2, curve3, v);
-}
-
-// Compute normal from Bezier surface tangents
-vec3 computeNormal(float u, float v) {
-    vec3 p00 = tePos[0];
-    vec3 p10 = tePos[1];
-    vec3 p01 = tePos[2];
-    vec3 p11 = tePos[3];
-
-    // evaluate derivative of 4 curves along u direction
-    vec3 dCurve0_du = bezierCurveDerivative(
-        getControlPoint(p00, p10, p01, p11, 0, 0),
-        getControlPoint(p00, p10, p01, p11, 0, 1),
-        getControlPoint(p00, p10, p01, p11, 0, 2),
-        getControlPoint(p00, p10, p01, p11, 0, 3),
-        u
-    );
-
-    vec3 dCurve1_du = bezierCurveDerivative(
-        getControlPoint(p00, p10, p01, p11, 1, 0),
-        getControlPoint(p00, p10, p01, p11, 1, 1),
-        getControlPoint(p00, p10, p01, p11, 1, 2),
-        getControlPoint(p00, p10, p01, p11, 1, 3),
-        u
-    );
-
-    vec3 dCurve2_du = bezierCurveDerivative(
-        getControlPoint(p00, p10, p01, p11, 2, 0),
-        getControlPoint(p00, p10, p01, p11, 2, 1),
-        getControlPoint(p00, p10, p01, p11, 2, 2),
-        getControlPoint(p00, p10, p01, p11, 2, 3),
-        u
-    );
-
-    vec3 dCurve3_du = bezierCurveDerivative(
-        getControlPoint(p00, p10, p01, p11, 3, 0),
-        getControlPoint(p00, p10, p01, p11, 3, 1),
-        getControlPoint(p00, p10, p01, p11, 3, 2),
-        getControlPoint(p00, p10, p01, p11, 3, 3),
-        u
-    );
-
-    // evaluate curve through derivatives along v direction
-    vec3 tangentU = bezierCurve(dCurve0_du, dCurve1_du, dCurve2_du, dCurve3_du, v);
-
-    // evaluate 4 curves along u direction (same as position)
-    vec3 curve0 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 0, 0),
-        getControlPoint(p00, p10, p01, p11, 0, 1),
-        getControlPoint(p00, p10, p01, p11, 0, 2),
-        getControlPoint(p00, p10, p01, p11, 0, 3),
-        u
-    );
-
-    vec3 curve1 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 1, 0),
-        getControlPoint(p00, p10, p01, p11, 1, 1),
-        getControlPoint(p00, p10, p01, p11, 1, 2),
-        getControlPoint(p00, p10, p01, p11, 1, 3),
-        u
-    );
-
-    vec3 curve2 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 2, 0),
-        getControlPoint(p00, p10, p01, p11, 2, 1),
-        getControlPoint(p00, p10, p01, p11, 2, 2),
-        getControlPoint(p00, p10, p01, p11, 2, 3),
-        u
-    );
-
-    vec3 curve3 = bezierCurve(
-        getControlPoint(p00, p10, p01, p11, 3, 0),
-        getControlPoint(p00, p10, p01, p11, 3, 1),
-        getControlPoint(p00, p10, p01, p11, 3, 2),
-        getControlPoint(p00, p10, p01, p11, 3, 3),
-        u
-    );
-
-    // evaluate derivative of curve through results along v direction
-    vec3 tangentV = bezierCurveDerivative(curve0, curve1, curve2, curve3, v);
-
-    // Normal is cross product of tangents
-    return normalize(cross(tangentU, tangentV));
+    b = vec4(mt * mt * mt, 3.0 * mt * mt * t, 3.0 * mt * t * t, t * t * t);
+    db = vec4(-3.0 * mt * mt, 3.0 * mt * (mt - 2.0 * t), 3.0 * t * (2.0 * mt - t), 3.0 * t * t);
 }
 
 void main() {
@@ -202,11 +41,56 @@ void main() {
     vec2 texCoord1 = mix(teTexCoord[2], teTexCoord[3], u);
     fragTexCoord = mix(texCoord0, texCoord1, v);
 
-    // position using Bezier surface
-    vec3 localPos = bezierInterpolate(u, v);
-
-    // normal from surface
-    vec3 localNormal = computeNormal(u, v);
+    // where this vertex sits on the ground, s along x and t along z
+    vec3 flatPos = mix(mix(tePos[0], tePos[1], u), mix(tePos[2], tePos[3], u), v);
+    vec2 groundMin = controlPoints[0].xz;
+    vec2 groundMax = controlPoints[15].xz;
+    vec2 st = (flatPos.xz - groundMin) / (groundMax - groundMin);
+
+    // the lightmap spans the whole ground
+    fragLightmapCoord = st;
+
+    // position and both tangents in one pass over the control points
+    vec4 bs, dbs, bt, dbt;
+    bernstein(st.x, bs, dbs);
+    bernstein(st.y, bt, dbt);
+
+    vec3 localPos = vec3(0.0);
+    vec3 tangentS = vec3(0.0);
+    vec3 tangentT = vec3(0.0);
+    for (int i = 0; i < 4; ++i) {
+        vec3 row = vec3(0.0);
+        vec3 dRow = vec3(0.0);
+        for (int j = 0; j < 4; ++j) {
+            vec3 p = controlPoints[i * 4 + j];
+            row += bs[j] * p;
+            dRow += dbs[j] * p;
+        }
+        localPos += bt[i] * row;
+        tangentS += bt[i] * dRow;
+        tangentT += dbt[i] * row;
+    }
+
+    // the displacement, sampled at texel centers so it matches the CPU's
+    // bilinear lookups, and its slope from central differences one sample
+    // apart
+    float texel = 1.0 / displacementResolution;
+    vec2 displacementCoord = (st * (displacementResolution - 1.0) + 0.5) * texel;
+    vec2 sampleSpacing = (groundMax - groundMin) / (displacementResolution - 1.0);
+    localPos.y += textureLod(displacementTexture, displacementCoord, 0.0).r;
+    float displacementDx = (textureLod(displacementTexture, displacementCoord + vec2(texel, 0.0), 0.0).r -
+                            textureLod(displacementTexture, displacementCoord - vec2(texel, 0.0), 0.0).r) /
+                           (2.0 * sampleSpacing.x);
+    float displacementDz = (textureLod(displacementTexture, displacementCoord + vec2(0.0, texel), 0.0).r -
+                            textureLod(displacementTexture, displacementCoord - vec2(0.0, texel), 0.0).r) /
+                           (2.0 * sampleSpacing.y);
+
+    // x only follows s and z only follows t, so the tangents give the
+    // surface's slopes directly. The normal is cross(tangentT, tangentS)
+    // scaled to y = 1 with the displacement's slopes added
+    vec2 slopes = vec2(tangentS.y / tangentS.x, tangentT.y / tangentT.z) +
+                  vec2(displacementDx, displacementDz);
+    vec3 localNormal = normalize(vec3(-slopes.x, 1.0, -slopes.y));
 
     // to world space
     worldPos = (modelMatrix * vec4(localPos, 1.0)).xyz;
@@ -0,0 +1,25 @@
+#version 410 core
+
+// draws the ground triangles a TessellationCache captured from ground.tes.glsl,
+// already in world space and carrying everything ground.f.glsl reads
+
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vTexCoord;
+layout(location = 3) in vec2 vLightmapCoord;
+
+out vec3 worldPos;
+out vec3 fragNormal;
+out vec2 fragTexCoord;
+out vec2 fragLightmapCoord;
+
+uniform mat4 viewProjectionMatrix;
+
+void main() {
+    worldPos = vPos;
+    fragNormal = vNormal;
+    fragTexCoord = vTexCoord;
+    fragLightmapCoord = vLightmapCoord;
+
+    gl_Position = viewProjectionMatrix * vec4(vPos, 1.0);
+}
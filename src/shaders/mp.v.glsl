@@ -18,6 +18,9 @@ uniform vec3 cameraPosition;
 
 uniform vec3 materialColor;             // the material color for our vertex (& whole object)
 
+uniform bool useBakedLighting = false;  // static objects with pre-lit colors
+uniform vec3 bakedColor;                // materialColor * baked ambient, point & spot diffuse
+
 // attribute inputs
 layout(location = 0) in vec3 vPos;      // the position of this specific vertex in object space
 // TODO #C: add vertex normal
@@ -42,15 +45,21 @@ void main() {
     // TODO #F: perform diffuse calculation
     vec3 diffuse = lightColor * materialColor * max(dot(normal, lightVec), 0.0);
 
-    // Calculate ambient so that the shadow is not completely black
-    vec3 ambient = vec3(0.71, 0.54, 0.7) * materialColor;
-
     // Specular
     vec3 viewVec = normalize(cameraPosition - worldPos);
     vec3 reflectVec = reflect(-lightVec, normal);
     float spec = pow(max(dot(viewVec, reflectVec), 0.0), 32);
     vec3 specular = vec3(0.5, 0.5, 0.5) * spec;
 
+    // baked objects only need the directional light on top of their bake
+    if (useBakedLighting) {
+        color = bakedColor + diffuse + specular;
+        return;
+    }
+
+    // Calculate ambient so that the shadow is not completely black
+    vec3 ambient = vec3(0.71, 0.54, 0.7) * materialColor;
+
     // TODO #G: assign the color for this vertex
     vec3 dirColor = diffuse + specular;
 
@@ -0,0 +1,30 @@
+#version 410 core
+
+
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec2 vTexCoord;
+
+// per-particle instance data
+layout(location = 2) in vec4 instancePositionSize;  // xyz = world position, w = size
+layout(location = 3) in float instanceRotation;
+
+uniform mat4 viewProjectionMatrix;
+uniform vec3 cameraRight;
+uniform vec3 cameraUp;
+
+out vec2 texCoord;
+
+// instanced billboarded particles vertex shader
+
+void main() {
+    // spin the quad in the camera plane, then scale it
+    float c = cos(instanceRotation);
+    float s = sin(instanceRotation);
+    vec2 corner = vec2(c * vPos.x - s * vPos.y, s * vPos.x + c * vPos.y) * instancePositionSize.w;
+
+    // billboard: lay the quad along the camera axes
+    vec3 worldPos = instancePositionSize.xyz + cameraRight * corner.x + cameraUp * corner.y;
+
+    gl_Position = viewProjectionMatrix * vec4(worldPos, 1.0);
+    texCoord = vTexCoord;
+}